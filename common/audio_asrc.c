@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <nuttx/config.h>
+
+#include "audio_asrc.h"
+
+/*
+ * The output at input position t is the sum of x[i] * h(t - i) over the
+ * AUDIO_ASRC_TAPS inputs nearest to t, h being a sinc cut a little below
+ * the lower Nyquist frequency of the two rates, under a Blackman window.
+ * Row p of the table holds h(TAPS / 2 - 1 - k + p / PHASES) for the inputs
+ * k from the oldest, each row scaled to sum to one so that the phases
+ * have the same DC gain and the interpolation between them adds no ripple.
+ *
+ * The bridge has neither FPU nor libm: the table is computed in soft float
+ * with its own sine, once at setup.
+ */
+
+#define AUDIO_ASRC_PI                   3.14159265f
+
+/* Cutoff, relative to the lower Nyquist frequency */
+#define AUDIO_ASRC_CUTOFF               0.91f
+
+/* Coefficients are Q15 */
+#define AUDIO_ASRC_COEFF_SHIFT          15
+
+/* Bits of the position between phases used to interpolate */
+#define AUDIO_ASRC_INTERP_BITS          15
+
+#define AUDIO_ASRC_PPB                  1000000000
+
+/*
+ * Drift loop. The fill error is smoothed over about 32 periods, which
+ * averages out the packet sawtooth of the buffer feeding the converter,
+ * then a PI controller settles in a few seconds. Gains are in ppb per
+ * frame of error, and per frame and period for the integral.
+ */
+#define AUDIO_ASRC_ERROR_SHIFT          8
+#define AUDIO_ASRC_SMOOTH_SHIFT         5
+#define AUDIO_ASRC_KP                   24000
+#define AUDIO_ASRC_KI                   24
+
+/* sin(x) by its Taylor series, after reduction to [-pi / 2, pi / 2] */
+static float audio_asrc_sin(float x)
+{
+    float x2;
+
+    while (x > AUDIO_ASRC_PI) {
+        x -= 2 * AUDIO_ASRC_PI;
+    }
+    while (x < -AUDIO_ASRC_PI) {
+        x += 2 * AUDIO_ASRC_PI;
+    }
+    if (x > AUDIO_ASRC_PI / 2) {
+        x = AUDIO_ASRC_PI - x;
+    } else if (x < -AUDIO_ASRC_PI / 2) {
+        x = -AUDIO_ASRC_PI - x;
+    }
+
+    x2 = x * x;
+    return x * (1 - x2 / 6 * (1 - x2 / 20 * (1 - x2 / 42 *
+           (1 - x2 / 72 * (1 - x2 / 110)))));
+}
+
+static float audio_asrc_cos(float x)
+{
+    return audio_asrc_sin(x + AUDIO_ASRC_PI / 2);
+}
+
+/* Windowed sinc at distance d from the output, in input frames */
+static float audio_asrc_kernel(float d, float fc)
+{
+    float w;
+    float x;
+
+    if (d <= -AUDIO_ASRC_TAPS / 2 || d >= AUDIO_ASRC_TAPS / 2) {
+        return 0;
+    }
+
+    x = AUDIO_ASRC_PI * d / (AUDIO_ASRC_TAPS / 2);
+    w = 0.42f + 0.5f * audio_asrc_cos(x) + 0.08f * audio_asrc_cos(2 * x);
+
+    x = AUDIO_ASRC_PI * fc * d;
+    if (x > -1e-6f && x < 1e-6f) {
+        return fc * w;
+    }
+    return fc * w * audio_asrc_sin(x) / x;
+}
+
+static void audio_asrc_design(struct audio_asrc *asrc, float fc)
+{
+    float h[AUDIO_ASRC_TAPS];
+    float sum;
+    int32_t total;
+    int p;
+    int k;
+
+    for (p = 0; p <= AUDIO_ASRC_PHASES; p++) {
+        sum = 0;
+        for (k = 0; k < AUDIO_ASRC_TAPS; k++) {
+            h[k] = audio_asrc_kernel(AUDIO_ASRC_TAPS / 2 - 1 - k +
+                                     (float)p / AUDIO_ASRC_PHASES, fc);
+            sum += h[k];
+        }
+
+        /* Round, then put the rounding error on the largest tap */
+        total = 0;
+        for (k = 0; k < AUDIO_ASRC_TAPS; k++) {
+            h[k] = h[k] * (1 << AUDIO_ASRC_COEFF_SHIFT) / sum;
+            asrc->coeffs[p][k] = h[k] < 0 ? (int16_t)(h[k] - 0.5f) :
+                                            (int16_t)(h[k] + 0.5f);
+            total += asrc->coeffs[p][k];
+        }
+        k = p < AUDIO_ASRC_PHASES / 2 ? AUDIO_ASRC_TAPS / 2 - 1 :
+                                        AUDIO_ASRC_TAPS / 2;
+        asrc->coeffs[p][k] += (1 << AUDIO_ASRC_COEFF_SHIFT) - total;
+    }
+}
+
+int audio_asrc_setup(struct audio_asrc *asrc, uint32_t in_rate,
+                     uint32_t out_rate, uint8_t channels)
+{
+    float fc;
+
+    /* Sixteen taps leave too little of the band below half the rate */
+    if (!in_rate || !out_rate || in_rate > 2 * out_rate ||
+        out_rate > 6 * in_rate || !channels ||
+        channels > AUDIO_ASRC_MAX_CHANNELS) {
+        return -EINVAL;
+    }
+
+    fc = AUDIO_ASRC_CUTOFF;
+    if (out_rate < in_rate) {
+        fc = fc * out_rate / in_rate;
+    }
+    audio_asrc_design(asrc, fc);
+
+    asrc->channels = channels;
+    asrc->nominal = ((uint64_t)in_rate << 32) / out_rate;
+    audio_asrc_reset(asrc);
+
+    return 0;
+}
+
+void audio_asrc_reset(struct audio_asrc *asrc)
+{
+    memset(asrc->history, 0, sizeof(asrc->history));
+    asrc->pos = 0;
+    asrc->step = asrc->nominal;
+    asrc->frac = 0;
+    asrc->pending = 1;
+    asrc->smoothed = 0;
+    asrc->integral = 0;
+    asrc->correction = 0;
+}
+
+static void audio_asrc_push(struct audio_asrc *asrc, const int16_t *frame)
+{
+    uint8_t c;
+
+    for (c = 0; c < asrc->channels; c++) {
+        asrc->history[c][asrc->pos] = frame[c];
+        asrc->history[c][asrc->pos + AUDIO_ASRC_TAPS] = frame[c];
+    }
+    if (++asrc->pos == AUDIO_ASRC_TAPS) {
+        asrc->pos = 0;
+    }
+}
+
+static inline int32_t audio_asrc_sat16(int32_t x)
+{
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+    __asm__ ("ssat %0, #16, %1" : "=r" (x) : "r" (x));
+    return x;
+#else
+    return x > INT16_MAX ? INT16_MAX : x < INT16_MIN ? INT16_MIN : x;
+#endif
+}
+
+uint32_t audio_asrc_process(struct audio_asrc *asrc, const int16_t *in,
+                            uint32_t *in_frames, int16_t *out,
+                            uint32_t out_frames)
+{
+    int32_t coeffs[AUDIO_ASRC_TAPS];
+    const int16_t *c0;
+    const int16_t *c1;
+    const int16_t *x;
+    uint32_t used = 0;
+    uint32_t done;
+    uint64_t next;
+    int32_t a;
+    int32_t sum;
+    uint8_t c;
+    int k;
+
+    for (done = 0; done < out_frames; done++) {
+        for (; asrc->pending; asrc->pending--, used++) {
+            if (used == *in_frames) {
+                goto out;
+            }
+            audio_asrc_push(asrc, in + used * asrc->channels);
+        }
+
+        /* Coefficients for this position, between two phases */
+        c0 = asrc->coeffs[asrc->frac >> (32 - AUDIO_ASRC_PHASE_BITS)];
+        c1 = c0 + AUDIO_ASRC_TAPS;
+        a = (asrc->frac >> (32 - AUDIO_ASRC_PHASE_BITS -
+                            AUDIO_ASRC_INTERP_BITS)) &
+            ((1 << AUDIO_ASRC_INTERP_BITS) - 1);
+        for (k = 0; k < AUDIO_ASRC_TAPS; k++) {
+            coeffs[k] = c0[k] + (((c1[k] - c0[k]) * a) >>
+                                 AUDIO_ASRC_INTERP_BITS);
+        }
+
+        for (c = 0; c < asrc->channels; c++) {
+            x = &asrc->history[c][asrc->pos];
+            sum = 1 << (AUDIO_ASRC_COEFF_SHIFT - 1);
+            for (k = 0; k < AUDIO_ASRC_TAPS; k++) {
+                sum += coeffs[k] * x[k];
+            }
+            *out++ = audio_asrc_sat16(sum >> AUDIO_ASRC_COEFF_SHIFT);
+        }
+
+        next = (uint64_t)asrc->frac + asrc->step;
+        asrc->frac = (uint32_t)next;
+        asrc->pending = next >> 32;
+    }
+
+out:
+    *in_frames = used;
+    return done;
+}
+
+void audio_asrc_steer(struct audio_asrc *asrc, int32_t error)
+{
+    int32_t limit = ((int64_t)AUDIO_ASRC_MAX_CORRECTION <<
+                     AUDIO_ASRC_ERROR_SHIFT) / AUDIO_ASRC_KI;
+    int64_t correction;
+
+    asrc->smoothed += (error * (1 << AUDIO_ASRC_ERROR_SHIFT) -
+                       asrc->smoothed) >> AUDIO_ASRC_SMOOTH_SHIFT;
+
+    /* The integral alone may reach the largest correction, not beyond */
+    asrc->integral += asrc->smoothed;
+    if (asrc->integral > limit) {
+        asrc->integral = limit;
+    } else if (asrc->integral < -limit) {
+        asrc->integral = -limit;
+    }
+
+    correction = ((int64_t)asrc->smoothed * AUDIO_ASRC_KP +
+                  (int64_t)asrc->integral * AUDIO_ASRC_KI) >>
+                 AUDIO_ASRC_ERROR_SHIFT;
+    if (correction > AUDIO_ASRC_MAX_CORRECTION) {
+        correction = AUDIO_ASRC_MAX_CORRECTION;
+    } else if (correction < -AUDIO_ASRC_MAX_CORRECTION) {
+        correction = -AUDIO_ASRC_MAX_CORRECTION;
+    }
+    asrc->correction = correction;
+
+    /* Above the target, take the input faster */
+    asrc->step = asrc->nominal +
+                 (int64_t)asrc->nominal * correction / AUDIO_ASRC_PPB;
+}
+
+int32_t audio_asrc_get_correction(struct audio_asrc *asrc)
+{
+    return asrc->correction;
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FDK_COMMON_AUDIO_ASRC_H
+#define FDK_COMMON_AUDIO_ASRC_H
+
+#include <stdint.h>
+
+/*
+ * Asynchronous sample-rate converter. It converts between standard rates,
+ * 44.1 kHz to 48 kHz for instance, so that the codec can stay at one rate,
+ * and it fine-tunes the ratio to follow the drift between the AP audio
+ * clock and the I2S clock.
+ *
+ * The filter is a windowed sinc of AUDIO_ASRC_TAPS taps in Q15, tabulated
+ * at AUDIO_ASRC_PHASES phases; the coefficients of an output sample are
+ * interpolated linearly between the two nearest phases. The position in
+ * the input is kept with 32 fraction bits.
+ *
+ * The drift is corrected from the buffer fill level: audio_asrc_steer()
+ * takes how many frames the buffer feeding the converter holds above its
+ * target, typically the playout error of the jitter buffer, and a PI loop
+ * turns it into a ratio correction. Samples are signed 16-bit, interleaved.
+ */
+
+#define AUDIO_ASRC_TAPS                 16
+#define AUDIO_ASRC_PHASE_BITS           6
+#define AUDIO_ASRC_PHASES               (1 << AUDIO_ASRC_PHASE_BITS)
+#define AUDIO_ASRC_MAX_CHANNELS         2
+
+/* Largest drift correction, in parts per billion */
+#define AUDIO_ASRC_MAX_CORRECTION       2000000
+
+/**
+ * @brief Converter state
+ *
+ * The fields are private, use audio_asrc_setup() to initialize it.
+ */
+struct audio_asrc {
+    /** Coefficients, one more phase to interpolate past the last one */
+    int16_t coeffs[AUDIO_ASRC_PHASES + 1][AUDIO_ASRC_TAPS];
+    /** Input history, written twice so that a window is contiguous */
+    int16_t history[AUDIO_ASRC_MAX_CHANNELS][2 * AUDIO_ASRC_TAPS];
+    uint32_t pos;
+    uint8_t channels;
+
+    /** Input frames per output frame, nominal and corrected, in Q32 */
+    uint64_t nominal;
+    uint64_t step;
+    /** Position of the next output between two inputs, in Q32 */
+    uint32_t frac;
+    /** Input frames to take before the next output */
+    uint32_t pending;
+
+    /** Drift loop: smoothed error and its integral in Q8, correction in ppb */
+    int32_t smoothed;
+    int32_t integral;
+    int32_t correction;
+};
+
+/**
+ * @brief Prepare a converter
+ *
+ * The filter is computed here, in soft float: set up converters before
+ * streaming, not from interrupt context.
+ *
+ * @param asrc Converter
+ * @param in_rate Input frames per second
+ * @param out_rate Output frames per second
+ * @param channels Samples per frame, 1 or 2
+ * @return 0 on success, -EINVAL on invalid parameters
+ */
+int audio_asrc_setup(struct audio_asrc *asrc, uint32_t in_rate,
+                     uint32_t out_rate, uint8_t channels);
+
+/**
+ * @brief Clear the input history and the drift correction
+ * @param asrc Converter
+ */
+void audio_asrc_reset(struct audio_asrc *asrc);
+
+/**
+ * @brief Convert samples
+ *
+ * Stops when the output is full or when the input is used up, the next
+ * call goes on from there.
+ *
+ * @param asrc Converter
+ * @param in Input samples
+ * @param in_frames Number of input frames, set to the number consumed
+ * @param out Output samples
+ * @param out_frames Room in the output, in frames
+ * @return number of frames output
+ */
+uint32_t audio_asrc_process(struct audio_asrc *asrc, const int16_t *in,
+                            uint32_t *in_frames, int16_t *out,
+                            uint32_t out_frames);
+
+/**
+ * @brief Correct the ratio from the fill level of the input buffer
+ *
+ * To be called once per output period.
+ *
+ * @param asrc Converter
+ * @param error Frames buffered above the target, negative below it
+ */
+void audio_asrc_steer(struct audio_asrc *asrc, int32_t error);
+
+/**
+ * @brief Get the drift correction
+ * @param asrc Converter
+ * @return correction of the ratio, in parts per billion
+ */
+int32_t audio_asrc_get_correction(struct audio_asrc *asrc);
+
+#endif /* FDK_COMMON_AUDIO_ASRC_H */
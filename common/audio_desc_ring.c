@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <nuttx/config.h>
+
+#include <arch/irq.h>
+
+#include "audio_desc_ring.h"
+
+/*
+ * Descriptors are held from head on: first the ones handed to the DMA,
+ * then the queued ones. Release callbacks run without the lock held.
+ */
+
+int audio_desc_ring_setup(struct audio_desc_ring *ring,
+                          struct audio_desc *descs, uint16_t capacity)
+{
+    if (!ring || !descs || !capacity) {
+        return -EINVAL;
+    }
+
+    memset(ring, 0, sizeof(*ring));
+    ring->descs = descs;
+    ring->capacity = capacity;
+
+    return 0;
+}
+
+int audio_desc_ring_push(struct audio_desc_ring *ring, void *buf,
+                         const int16_t *samples, uint32_t frames,
+                         audio_desc_release_t release, void *arg)
+{
+    struct audio_desc *desc;
+    irqstate_t flags;
+    uint32_t tail;
+
+    flags = irqsave();
+
+    if (ring->held == ring->capacity) {
+        ring->stats.overruns++;
+        irqrestore(flags);
+        return -ENOSPC;
+    }
+
+    tail = ring->head + ring->held;
+    if (tail >= ring->capacity) {
+        tail -= ring->capacity;
+    }
+
+    desc = &ring->descs[tail];
+    desc->samples = samples;
+    desc->frames = frames;
+    desc->buf = buf;
+    desc->release = release;
+    desc->arg = arg;
+
+    ring->held++;
+    ring->frames += frames;
+    ring->stats.pushed++;
+    if (ring->held > ring->stats.peak) {
+        ring->stats.peak = ring->held;
+    }
+
+    irqrestore(flags);
+
+    return 0;
+}
+
+const struct audio_desc *audio_desc_ring_next(struct audio_desc_ring *ring)
+{
+    struct audio_desc *desc;
+    irqstate_t flags;
+    uint32_t next;
+
+    flags = irqsave();
+
+    if (ring->inflight == ring->held) {
+        ring->stats.underruns++;
+        irqrestore(flags);
+        return NULL;
+    }
+
+    next = ring->head + ring->inflight;
+    if (next >= ring->capacity) {
+        next -= ring->capacity;
+    }
+
+    desc = &ring->descs[next];
+    ring->inflight++;
+    ring->frames -= desc->frames;
+
+    irqrestore(flags);
+
+    return desc;
+}
+
+void audio_desc_ring_complete(struct audio_desc_ring *ring)
+{
+    struct audio_desc desc;
+    irqstate_t flags;
+
+    flags = irqsave();
+
+    if (!ring->inflight) {
+        irqrestore(flags);
+        return;
+    }
+
+    desc = ring->descs[ring->head];
+    if (++ring->head == ring->capacity) {
+        ring->head = 0;
+    }
+    ring->held--;
+    ring->inflight--;
+
+    irqrestore(flags);
+
+    if (desc.release) {
+        desc.release(desc.buf, desc.arg);
+    }
+}
+
+void audio_desc_ring_flush(struct audio_desc_ring *ring)
+{
+    irqstate_t flags;
+
+    flags = irqsave();
+    ring->inflight = ring->held;
+    ring->frames = 0;
+    irqrestore(flags);
+
+    while (ring->inflight) {
+        audio_desc_ring_complete(ring);
+    }
+}
+
+void audio_desc_ring_get_stats(struct audio_desc_ring *ring,
+                               struct audio_desc_stats *stats)
+{
+    irqstate_t flags;
+
+    flags = irqsave();
+    *stats = ring->stats;
+    stats->held = ring->held;
+    stats->frames = ring->frames;
+    irqrestore(flags);
+}
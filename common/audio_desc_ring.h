@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FDK_COMMON_AUDIO_DESC_RING_H
+#define FDK_COMMON_AUDIO_DESC_RING_H
+
+#include <stdint.h>
+
+#include <nuttx/config.h>
+
+/*
+ * Zero-copy audio path: a ring of descriptors pointing at the receive
+ * buffers of the audio data CPort, chained to the I2S transmit DMA in
+ * place of the copies into the jitter buffer and the period buffers.
+ *
+ * With CONFIG_UNIPRO_ZERO_COPY the Greybus receive handler owns the UniPro
+ * buffer of each packet until it frees it. It pushes the payload here with
+ * a release callback, typically freeing the buffer with unipro_rxbuf_free()
+ * instead of copying it. The DMA side takes the next descriptor when it
+ * is set up for the next transfer and completes the oldest one when that
+ * transfer is done, which hands the buffer back to the UniPro pool.
+ *
+ * There is no concealment, drift correction or format conversion on this
+ * path: the stream must already be in the I2S format, and the DMA plays
+ * silence when it finds the ring empty. Every descriptor held is a UniPro
+ * buffer out of the pool, size the ring accordingly.
+ *
+ * Samples are signed 16-bit and interleaved. There must be one producer
+ * and one consumer, either of them may run in interrupt context.
+ */
+
+typedef void (*audio_desc_release_t)(void *buf, void *arg);
+
+/**
+ * @brief One receive buffer queued for the DMA
+ */
+struct audio_desc {
+    /** Samples to transfer, inside buf */
+    const int16_t *samples;
+    uint32_t frames;
+    /** Buffer to hand back once transferred */
+    void *buf;
+    audio_desc_release_t release;
+    void *arg;
+};
+
+/**
+ * @brief Descriptor ring counters and state
+ */
+struct audio_desc_stats {
+    /** Descriptors queued */
+    uint32_t pushed;
+    /** Pushes refused because the ring was full */
+    uint32_t overruns;
+    /** Times the DMA found no descriptor to chain */
+    uint32_t underruns;
+    /** Most descriptors held at once */
+    uint16_t peak;
+    /** Descriptors held, queued or being transferred */
+    uint16_t held;
+    /** Frames queued and not handed to the DMA yet */
+    uint32_t frames;
+};
+
+/**
+ * @brief Descriptor ring
+ *
+ * The fields are private, use audio_desc_ring_setup() to initialize it.
+ */
+struct audio_desc_ring {
+    struct audio_desc *descs;
+    uint16_t capacity;
+    /** Oldest descriptor held, and descriptors held */
+    uint16_t head;
+    uint16_t held;
+    /** Descriptors handed to the DMA and not completed */
+    uint16_t inflight;
+    uint32_t frames;
+    struct audio_desc_stats stats;
+};
+
+/**
+ * @brief Prepare an empty ring
+ * @param ring Ring to initialize
+ * @param descs Storage for the descriptors
+ * @param capacity Number of descriptors
+ * @return 0 on success, -EINVAL on invalid parameters
+ */
+int audio_desc_ring_setup(struct audio_desc_ring *ring,
+                          struct audio_desc *descs, uint16_t capacity);
+
+/**
+ * @brief Queue a receive buffer
+ *
+ * On success the ring owns the buffer until it calls release.
+ *
+ * @param ring Ring
+ * @param buf Buffer to hand back once transferred
+ * @param samples Samples to transfer, inside buf
+ * @param frames Number of frames
+ * @param release Called with buf and arg once the transfer is done
+ * @param arg Argument given to release
+ * @return 0 on success, -ENOSPC if the ring is full, the caller keeps buf
+ */
+int audio_desc_ring_push(struct audio_desc_ring *ring, void *buf,
+                         const int16_t *samples, uint32_t frames,
+                         audio_desc_release_t release, void *arg);
+
+/**
+ * @brief Take the next descriptor to chain to the DMA
+ * @param ring Ring
+ * @return descriptor, valid until completed, or NULL if the ring is empty
+ */
+const struct audio_desc *audio_desc_ring_next(struct audio_desc_ring *ring);
+
+/**
+ * @brief Release the oldest descriptor handed to the DMA
+ * @param ring Ring
+ */
+void audio_desc_ring_complete(struct audio_desc_ring *ring);
+
+/**
+ * @brief Release every descriptor, when the stream stops
+ *
+ * The DMA must be stopped first.
+ *
+ * @param ring Ring
+ */
+void audio_desc_ring_flush(struct audio_desc_ring *ring);
+
+void audio_desc_ring_get_stats(struct audio_desc_ring *ring,
+                               struct audio_desc_stats *stats);
+
+#endif /* FDK_COMMON_AUDIO_DESC_RING_H */
@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include <nuttx/config.h>
+
+#include "audio_dsp.h"
+
+/*
+ * Word loads go through memcpy, which the compiler turns into a single
+ * (unaligned) load on the Cortex-M3. The bridge is little endian: the first
+ * sample of a word is its low half.
+ */
+
+/* Extra fraction bits of the ramping gain */
+#define AUDIO_DSP_GAIN_FRAC             15
+
+static inline uint32_t audio_dsp_load32(const void *p)
+{
+    uint32_t word;
+
+    memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+static inline void audio_dsp_store32(void *p, uint32_t word)
+{
+    memcpy(p, &word, sizeof(word));
+}
+
+static inline int32_t audio_dsp_sat16(int32_t x)
+{
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+    __asm__ ("ssat %0, #16, %1" : "=r" (x) : "r" (x));
+    return x;
+#else
+    return x > INT16_MAX ? INT16_MAX : x < INT16_MIN ? INT16_MIN : x;
+#endif
+}
+
+static inline int32_t audio_dsp_sat24(int32_t x)
+{
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+    __asm__ ("ssat %0, #24, %1" : "=r" (x) : "r" (x));
+    return x;
+#else
+    return x > 0x7fffff ? 0x7fffff : x < -0x800000 ? -0x800000 : x;
+#endif
+}
+
+/* Two 16-bit samples in a word, the first one low */
+static inline uint32_t audio_dsp_pack16(int32_t lo, int32_t hi)
+{
+    return (lo & 0xffff) | ((uint32_t)hi << 16);
+}
+
+/*
+ * Round a sample left-justified in 32 bits to 16 bits. The bits below the
+ * rounding bit are ignored, they may be garbage.
+ */
+static inline int32_t audio_dsp_round16(int32_t x)
+{
+    return audio_dsp_sat16(((x >> 15) + 1) >> 1);
+}
+
+void audio_dsp_s16_to_s32(int32_t *dst, const int16_t *src, uint32_t n)
+{
+    uint32_t w;
+
+    for (; n >= 2; n -= 2, src += 2, dst += 2) {
+        w = audio_dsp_load32(src);
+        dst[0] = (int32_t)(w << 16);
+        dst[1] = (int32_t)(w & 0xffff0000);
+    }
+
+    if (n) {
+        dst[0] = (int32_t)src[0] << 16;
+    }
+}
+
+void audio_dsp_s32_to_s16(int16_t *dst, const int32_t *src, uint32_t n)
+{
+    for (; n >= 2; n -= 2, src += 2, dst += 2) {
+        audio_dsp_store32(dst, audio_dsp_pack16(audio_dsp_round16(src[0]),
+                                                audio_dsp_round16(src[1])));
+    }
+
+    if (n) {
+        dst[0] = audio_dsp_round16(src[0]);
+    }
+}
+
+/*
+ * Four 24-bit samples are three words. Sample i is bytes 3i to 3i + 2 of
+ * the stream, so a 16-bit sample becomes a zero byte and its two bytes.
+ */
+void audio_dsp_s16_to_s24(uint8_t *dst, const int16_t *src, uint32_t n)
+{
+    uint32_t a, b;
+
+    for (; n >= 4; n -= 4, src += 4, dst += 12) {
+        a = audio_dsp_load32(src);
+        b = audio_dsp_load32(src + 2);
+        audio_dsp_store32(dst, (a << 8) & 0xffffff);
+        audio_dsp_store32(dst + 4, (a >> 16) | (b << 24));
+        audio_dsp_store32(dst + 8, ((b >> 8) & 0xff) | (b & 0xffff0000));
+    }
+
+    for (; n; n--, src++, dst += 3) {
+        dst[0] = 0;
+        dst[1] = src[0] & 0xff;
+        dst[2] = (uint16_t)src[0] >> 8;
+    }
+}
+
+/*
+ * Each sample is loaded left-justified in a word, with the byte below it as
+ * garbage in the low byte instead of shifting it out.
+ */
+void audio_dsp_s24_to_s16(int16_t *dst, const uint8_t *src, uint32_t n)
+{
+    uint32_t w0, w1, w2;
+
+    for (; n >= 4; n -= 4, src += 12, dst += 4) {
+        w0 = audio_dsp_load32(src);
+        w1 = audio_dsp_load32(src + 4);
+        w2 = audio_dsp_load32(src + 8);
+        audio_dsp_store32(dst, audio_dsp_pack16(
+            audio_dsp_round16(w0 << 8),
+            audio_dsp_round16((w0 >> 16) | (w1 << 16))));
+        audio_dsp_store32(dst + 2, audio_dsp_pack16(
+            audio_dsp_round16((w1 >> 8) | (w2 << 24)),
+            audio_dsp_round16(w2)));
+    }
+
+    for (; n; n--, src += 3, dst++) {
+        dst[0] = audio_dsp_round16((src[0] << 8) | (src[1] << 16) |
+                                   ((uint32_t)src[2] << 24));
+    }
+}
+
+void audio_dsp_s24_to_s32(int32_t *dst, const uint8_t *src, uint32_t n)
+{
+    uint32_t w0, w1, w2;
+
+    for (; n >= 4; n -= 4, src += 12, dst += 4) {
+        w0 = audio_dsp_load32(src);
+        w1 = audio_dsp_load32(src + 4);
+        w2 = audio_dsp_load32(src + 8);
+        dst[0] = (int32_t)(w0 << 8);
+        dst[1] = (int32_t)(((w0 >> 16) | (w1 << 16)) & 0xffffff00);
+        dst[2] = (int32_t)(((w1 >> 8) | (w2 << 24)) & 0xffffff00);
+        dst[3] = (int32_t)(w2 & 0xffffff00);
+    }
+
+    for (; n; n--, src += 3, dst++) {
+        dst[0] = (int32_t)((src[0] << 8) | (src[1] << 16) |
+                           ((uint32_t)src[2] << 24));
+    }
+}
+
+void audio_dsp_s32_to_s24(uint8_t *dst, const int32_t *src, uint32_t n)
+{
+    uint32_t v0, v1, v2, v3;
+
+    for (; n >= 4; n -= 4, src += 4, dst += 12) {
+        v0 = audio_dsp_sat24(((src[0] >> 7) + 1) >> 1) & 0xffffff;
+        v1 = audio_dsp_sat24(((src[1] >> 7) + 1) >> 1) & 0xffffff;
+        v2 = audio_dsp_sat24(((src[2] >> 7) + 1) >> 1) & 0xffffff;
+        v3 = audio_dsp_sat24(((src[3] >> 7) + 1) >> 1);
+        audio_dsp_store32(dst, v0 | (v1 << 24));
+        audio_dsp_store32(dst + 4, (v1 >> 8) | (v2 << 16));
+        audio_dsp_store32(dst + 8, (v2 >> 16) | (v3 << 8));
+    }
+
+    for (; n; n--, src++, dst += 3) {
+        v0 = audio_dsp_sat24(((src[0] >> 7) + 1) >> 1);
+        dst[0] = v0;
+        dst[1] = v0 >> 8;
+        dst[2] = v0 >> 16;
+    }
+}
+
+void audio_dsp_mono_to_stereo(int16_t *dst, const int16_t *src,
+                              uint32_t frames)
+{
+    uint32_t w;
+
+    for (; frames >= 2; frames -= 2, src += 2, dst += 4) {
+        w = audio_dsp_load32(src);
+        audio_dsp_store32(dst, (w & 0xffff) | (w << 16));
+        audio_dsp_store32(dst + 2, (w >> 16) | (w & 0xffff0000));
+    }
+
+    if (frames) {
+        dst[0] = src[0];
+        dst[1] = src[0];
+    }
+}
+
+/* The sum of two 16-bit samples always fits, the average needs no clamp. */
+void audio_dsp_stereo_to_mono(int16_t *dst, const int16_t *src,
+                              uint32_t frames)
+{
+    uint32_t a, b;
+
+    for (; frames >= 2; frames -= 2, src += 4, dst += 2) {
+        a = audio_dsp_load32(src);
+        b = audio_dsp_load32(src + 2);
+        audio_dsp_store32(dst, audio_dsp_pack16(
+            (((int32_t)(a << 16) >> 16) + ((int32_t)a >> 16)) >> 1,
+            (((int32_t)(b << 16) >> 16) + ((int32_t)b >> 16)) >> 1));
+    }
+
+    if (frames) {
+        dst[0] = (src[0] + src[1]) >> 1;
+    }
+}
+
+void audio_dsp_mix(int16_t *dst, const int16_t *src, uint32_t n)
+{
+    uint32_t a, b;
+
+    for (; n >= 2; n -= 2, src += 2, dst += 2) {
+        a = audio_dsp_load32(dst);
+        b = audio_dsp_load32(src);
+        audio_dsp_store32(dst, audio_dsp_pack16(
+            audio_dsp_sat16(((int32_t)(a << 16) >> 16) +
+                            ((int32_t)(b << 16) >> 16)),
+            audio_dsp_sat16(((int32_t)a >> 16) + ((int32_t)b >> 16))));
+    }
+
+    if (n) {
+        dst[0] = audio_dsp_sat16(dst[0] + src[0]);
+    }
+}
+
+void audio_dsp_gain_init(struct audio_dsp_gain *g, uint16_t gain)
+{
+    g->gain = (int32_t)gain << AUDIO_DSP_GAIN_FRAC;
+    g->step = 0;
+    g->ramp = 0;
+    g->target = gain;
+}
+
+void audio_dsp_gain_set(struct audio_dsp_gain *g, uint16_t gain,
+                        uint32_t frames)
+{
+    if (!frames) {
+        audio_dsp_gain_init(g, gain);
+        return;
+    }
+
+    g->step = (((int32_t)gain << AUDIO_DSP_GAIN_FRAC) - g->gain) /
+              (int32_t)frames;
+    g->ramp = frames;
+    g->target = gain;
+}
+
+/* A sample times a Q4.12 gain, rounded */
+static inline int32_t audio_dsp_scale(int32_t sample, int32_t gain)
+{
+    return audio_dsp_sat16((sample * gain + (1 << (AUDIO_DSP_GAIN_SHIFT - 1)))
+                           >> AUDIO_DSP_GAIN_SHIFT);
+}
+
+void audio_dsp_gain_apply(struct audio_dsp_gain *g, int16_t *samples,
+                          uint32_t frames, uint8_t channels)
+{
+    int32_t gain;
+    uint32_t n;
+    uint32_t w;
+
+    /* The ramp, one gain per frame */
+    for (; g->ramp && frames; g->ramp--, frames--, samples += channels) {
+        g->gain += g->step;
+        gain = g->gain >> AUDIO_DSP_GAIN_FRAC;
+        samples[0] = audio_dsp_scale(samples[0], gain);
+        if (channels == 2) {
+            samples[1] = audio_dsp_scale(samples[1], gain);
+        }
+    }
+
+    if (!g->ramp) {
+        g->gain = (int32_t)g->target << AUDIO_DSP_GAIN_FRAC;
+    }
+
+    if (!frames || g->target == AUDIO_DSP_GAIN_UNITY) {
+        return;
+    }
+
+    gain = g->target;
+    for (n = frames * channels; n >= 2; n -= 2, samples += 2) {
+        w = audio_dsp_load32(samples);
+        audio_dsp_store32(samples, audio_dsp_pack16(
+            audio_dsp_scale((int32_t)(w << 16) >> 16, gain),
+            audio_dsp_scale((int32_t)w >> 16, gain)));
+    }
+
+    if (n) {
+        samples[0] = audio_dsp_scale(samples[0], gain);
+    }
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FDK_COMMON_AUDIO_DSP_H
+#define FDK_COMMON_AUDIO_DSP_H
+
+#include <stdint.h>
+
+/*
+ * Fixed-point sample kernels for the audio data path: format conversion,
+ * channel up and down-mixing, mixing and gain.
+ *
+ * Samples are signed and little endian. 16-bit and 32-bit samples are in
+ * native integers, 24-bit samples are packed in 3 bytes. Conversions to a
+ * narrower format round to nearest and saturate, every other kernel
+ * saturates its result. Kernels work on two 16-bit samples per 32-bit word,
+ * or four 24-bit samples per three words, buffers need no alignment.
+ */
+
+/* Gains are unsigned Q4.12, up to 16 times (+24 dB) */
+#define AUDIO_DSP_GAIN_SHIFT            12
+#define AUDIO_DSP_GAIN_UNITY            (1 << AUDIO_DSP_GAIN_SHIFT)
+
+/**
+ * @brief Gain stage with linear ramps between gains
+ *
+ * The fields are private, use audio_dsp_gain_init() to initialize it.
+ */
+struct audio_dsp_gain {
+    /** Current gain and step per frame, with 15 more fraction bits */
+    int32_t gain;
+    int32_t step;
+    /** Frames left in the ramp */
+    uint32_t ramp;
+    uint16_t target;
+};
+
+void audio_dsp_s16_to_s32(int32_t *dst, const int16_t *src, uint32_t n);
+void audio_dsp_s32_to_s16(int16_t *dst, const int32_t *src, uint32_t n);
+void audio_dsp_s16_to_s24(uint8_t *dst, const int16_t *src, uint32_t n);
+void audio_dsp_s24_to_s16(int16_t *dst, const uint8_t *src, uint32_t n);
+void audio_dsp_s24_to_s32(int32_t *dst, const uint8_t *src, uint32_t n);
+void audio_dsp_s32_to_s24(uint8_t *dst, const int32_t *src, uint32_t n);
+
+/**
+ * @brief Duplicate a mono stream on two channels
+ * @param dst Interleaved stereo output, 2 * frames samples
+ * @param src Mono input
+ * @param frames Number of frames
+ */
+void audio_dsp_mono_to_stereo(int16_t *dst, const int16_t *src,
+                              uint32_t frames);
+
+/**
+ * @brief Average the two channels of a stereo stream
+ *
+ * The output may be the input buffer.
+ *
+ * @param dst Mono output
+ * @param src Interleaved stereo input, 2 * frames samples
+ * @param frames Number of frames
+ */
+void audio_dsp_stereo_to_mono(int16_t *dst, const int16_t *src,
+                              uint32_t frames);
+
+/**
+ * @brief Add a stream to another one
+ * @param dst Stream mixed into, in place
+ * @param src Stream to add
+ * @param n Number of samples
+ */
+void audio_dsp_mix(int16_t *dst, const int16_t *src, uint32_t n);
+
+/**
+ * @brief Set a gain stage to a gain, without ramp
+ * @param g Gain stage
+ * @param gain Gain in Q4.12
+ */
+void audio_dsp_gain_init(struct audio_dsp_gain *g, uint16_t gain);
+
+/**
+ * @brief Ramp linearly to a new gain
+ *
+ * A ramp in progress starts over from the current gain.
+ *
+ * @param g Gain stage
+ * @param gain Gain in Q4.12
+ * @param frames Length of the ramp, 0 to jump to the gain
+ */
+void audio_dsp_gain_set(struct audio_dsp_gain *g, uint16_t gain,
+                        uint32_t frames);
+
+/**
+ * @brief Apply a gain stage in place
+ *
+ * The gain changes once per frame during a ramp, unity gain costs nothing.
+ *
+ * @param g Gain stage
+ * @param samples Interleaved samples
+ * @param frames Number of frames
+ * @param channels Samples per frame, 1 or 2
+ */
+void audio_dsp_gain_apply(struct audio_dsp_gain *g, int16_t *samples,
+                          uint32_t frames, uint8_t channels);
+
+#endif /* FDK_COMMON_AUDIO_DSP_H */
@@ -0,0 +1,490 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <nuttx/config.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/util.h>
+
+#include <arch/irq.h>
+
+#include "audio_jitter.h"
+
+/*
+ * The late arrival envelope follows a later packet at once. It holds for
+ * AUDIO_JITTER_HOLD_US, so that periodic stalls are not forgotten between
+ * two of them, then decays towards the current lateness by
+ * 2^-AUDIO_JITTER_DECAY_SHIFT per packet.
+ */
+#define AUDIO_JITTER_HOLD_US            4000000
+#define AUDIO_JITTER_DECAY_SHIFT        10
+
+/**
+ * @brief Convert a duration to frames
+ * @param jb Jitter buffer
+ * @param us Duration in microseconds, less than 40 seconds
+ * @return number of frames, rounded towards zero
+ */
+static int32_t audio_jitter_frames(struct audio_jitter *jb, int32_t us)
+{
+    /* In 10 us and 100 Hz units, so that the product fits */
+    return us / 10 * (int32_t)(jb->rate / 100) / 1000;
+}
+
+/**
+ * @brief Playout delay the buffer steers to
+ *
+ * The last frame of a read may be in a packet starting a period earlier,
+ * a late packet needs the period plus its lateness, and half a period
+ * more is kept for the read time jitter.
+ *
+ * @param jb Jitter buffer
+ * @return playout delay in frames
+ */
+static uint32_t audio_jitter_target(struct audio_jitter *jb)
+{
+    uint32_t target;
+
+    target = audio_jitter_frames(jb, jb->stats.delay_us) + jb->period +
+             jb->period / 2;
+
+    return MIN(target, jb->capacity - jb->period);
+}
+
+/**
+ * @brief Current playout delay
+ *
+ * A frame due at media time m arrives at the earliest at base + m. The
+ * reader plays the frame after the buffered ones, due at media_us - depth,
+ * now. Neither arrivals nor reads change the difference, only merges,
+ * insertions, concealment and a new earliest packet do.
+ *
+ * @param jb Jitter buffer
+ * @param now Current time, in microseconds
+ * @return playout delay in frames
+ */
+static int32_t audio_jitter_playout(struct audio_jitter *jb, uint32_t now)
+{
+    return jb->count +
+           audio_jitter_frames(jb, now - jb->base - jb->media_us);
+}
+
+/**
+ * @brief Update the arrival statistics with a packet
+ *
+ * The transit time of a packet is its arrival time minus the time its
+ * first frame is due in the stream.
+ *
+ * @param jb Jitter buffer
+ * @param frames Number of frames of the packet
+ * @param now Arrival time, in microseconds
+ */
+static void audio_jitter_track(struct audio_jitter *jb, uint32_t frames,
+                               uint32_t now)
+{
+    uint32_t total;
+    int32_t transit;
+    int32_t delay;
+    uint32_t diff;
+
+    transit = (int32_t)(now - jb->media_us);
+
+    if (!jb->arrived) {
+        jb->arrived = true;
+        jb->base = transit;
+        jb->transit = transit;
+    }
+
+    diff = transit > jb->transit ? transit - jb->transit :
+                                   jb->transit - transit;
+    jb->jitter_q4 += diff - ((jb->jitter_q4 + 8) >> 4);
+    jb->transit = transit;
+
+    delay = transit - jb->base;
+    if (delay < 0) {
+        jb->base = transit;
+        delay = 0;
+    }
+
+    if ((uint32_t)delay >= jb->stats.delay_us) {
+        jb->stats.delay_us = delay;
+        jb->peak_time = now;
+    } else if (now - jb->peak_time > AUDIO_JITTER_HOLD_US) {
+        jb->stats.delay_us -= (jb->stats.delay_us - delay) >>
+                              AUDIO_JITTER_DECAY_SHIFT;
+    }
+
+    total = frames * 1000000 + jb->media_rem;
+    jb->media_us += total / jb->rate;
+    jb->media_rem = total % jb->rate;
+}
+
+/**
+ * @brief Move frames from the ring to a buffer
+ * @param jb Jitter buffer
+ * @param samples Output buffer
+ * @param frames Number of frames, no more than buffered
+ */
+static void audio_jitter_take(struct audio_jitter *jb, int16_t *samples,
+                              uint32_t frames)
+{
+    uint32_t first = MIN(frames, jb->capacity - jb->head);
+
+    memcpy(samples, &jb->ring[jb->head * jb->channels],
+           first * jb->channels * sizeof(int16_t));
+    memcpy(samples + first * jb->channels, jb->ring,
+           (frames - first) * jb->channels * sizeof(int16_t));
+
+    jb->head = (jb->head + frames) % jb->capacity;
+    jb->count -= frames;
+}
+
+/**
+ * @brief Fill the end of a period with the fade-out of the last frame
+ * @param jb Jitter buffer
+ * @param samples Output buffer of one period
+ * @param from First frame to fill
+ */
+static void audio_jitter_conceal(struct audio_jitter *jb, int16_t *samples,
+                                 uint32_t from)
+{
+    int16_t *frame = samples + from * jb->channels;
+    uint32_t gain;
+    uint32_t i;
+    uint8_t c;
+
+    for (i = from; i < jb->period; i++, frame += jb->channels) {
+        gain = jb->fade_out < AUDIO_JITTER_FADE_FRAMES ?
+               AUDIO_JITTER_FADE_FRAMES - 1 - jb->fade_out++ : 0;
+
+        for (c = 0; c < jb->channels; c++) {
+            frame[c] = jb->last[c] * (int32_t)gain /
+                       AUDIO_JITTER_FADE_FRAMES;
+        }
+    }
+
+    if (jb->primed) {
+        jb->stats.concealed += jb->period - from;
+    }
+}
+
+/**
+ * @brief Read a period, steering the playout delay by one frame if needed
+ *
+ * Merging replaces two frames by their average, inserting adds the average
+ * of two frames between them, both in the middle of the period.
+ *
+ * @param jb Jitter buffer
+ * @param samples Output buffer of one period
+ * @param steer Positive to merge, negative to insert, 0 to copy
+ */
+static void audio_jitter_play(struct audio_jitter *jb, int16_t *samples,
+                              int steer)
+{
+    uint32_t mid = (jb->period - 1) / 2;
+    int16_t *frame = samples + mid * jb->channels;
+    int16_t pair[2 * AUDIO_JITTER_MAX_CHANNELS];
+    uint8_t c;
+
+    if (steer > 0) {
+        audio_jitter_take(jb, samples, mid);
+        audio_jitter_take(jb, pair, 2);
+        for (c = 0; c < jb->channels; c++) {
+            frame[c] = (pair[c] + pair[jb->channels + c]) / 2;
+        }
+        audio_jitter_take(jb, frame + jb->channels, jb->period - mid - 1);
+        jb->stats.merged++;
+    } else if (steer < 0) {
+        audio_jitter_take(jb, samples, mid + 1);
+        for (c = 0; c < jb->channels; c++) {
+            frame[jb->channels + c] =
+                (frame[c] + jb->ring[jb->head * jb->channels + c]) / 2;
+        }
+        audio_jitter_take(jb, frame + 2 * jb->channels,
+                          jb->period - mid - 2);
+        jb->stats.inserted++;
+    } else {
+        audio_jitter_take(jb, samples, jb->period);
+    }
+}
+
+int audio_jitter_setup(struct audio_jitter *jb, int16_t *ring,
+                       uint32_t capacity, uint8_t channels, uint32_t rate,
+                       uint32_t period)
+{
+    if (!jb || !ring || !channels || channels > AUDIO_JITTER_MAX_CHANNELS ||
+        !rate || period < 2 || capacity < 4 * period) {
+        return -EINVAL;
+    }
+
+    memset(jb, 0, sizeof(*jb));
+    jb->ring = ring;
+    jb->capacity = capacity;
+    jb->channels = channels;
+    jb->rate = rate;
+    jb->period = period;
+
+    audio_jitter_reset(jb);
+
+    return 0;
+}
+
+void audio_jitter_reset(struct audio_jitter *jb)
+{
+    irqstate_t flags;
+
+    flags = irqsave();
+
+    jb->head = 0;
+    jb->count = 0;
+    jb->playing = false;
+    jb->primed = false;
+    jb->fade_in = 0;
+    jb->fade_out = AUDIO_JITTER_FADE_FRAMES;
+    memset(jb->last, 0, sizeof(jb->last));
+
+    /* The next stream has its own clock, the delay envelope is kept. */
+    jb->arrived = false;
+    jb->media_us = 0;
+    jb->media_rem = 0;
+
+    jb->stats.depth = 0;
+
+    irqrestore(flags);
+}
+
+uint32_t audio_jitter_write(struct audio_jitter *jb, const int16_t *samples,
+                            uint32_t frames, uint32_t now)
+{
+    irqstate_t flags;
+    uint32_t first;
+    uint32_t tail;
+    uint32_t room;
+
+    flags = irqsave();
+
+    audio_jitter_track(jb, frames, now);
+
+    room = jb->capacity - jb->count;
+    if (frames > room) {
+        jb->stats.overruns++;
+        jb->stats.dropped += frames - room;
+        frames = room;
+    }
+
+    tail = (jb->head + jb->count) % jb->capacity;
+    first = MIN(frames, jb->capacity - tail);
+
+    memcpy(&jb->ring[tail * jb->channels], samples,
+           first * jb->channels * sizeof(int16_t));
+    memcpy(jb->ring, samples + first * jb->channels,
+           (frames - first) * jb->channels * sizeof(int16_t));
+
+    jb->count += frames;
+    jb->stats.depth = jb->count;
+
+    irqrestore(flags);
+
+    return frames;
+}
+
+void audio_jitter_read(struct audio_jitter *jb, int16_t *samples,
+                       uint32_t now)
+{
+    irqstate_t flags;
+    uint32_t target;
+    int32_t playout;
+    int16_t *frame;
+    uint32_t left;
+    uint32_t gain;
+    uint32_t i;
+    uint8_t c;
+
+    flags = irqsave();
+
+    target = audio_jitter_target(jb);
+    playout = jb->arrived ? audio_jitter_playout(jb, now) : 0;
+    jb->stats.target = target;
+    jb->stats.playout = playout;
+
+    if (!jb->playing) {
+        if (playout < (int32_t)target || jb->count < jb->period) {
+            audio_jitter_conceal(jb, samples, 0);
+            goto out;
+        }
+
+        jb->playing = true;
+        jb->primed = true;
+        jb->fade_in = AUDIO_JITTER_FADE_FRAMES;
+    }
+
+    if (jb->count < jb->period) {
+        jb->stats.underruns++;
+        jb->playing = false;
+        jb->fade_out = 0;
+
+        left = jb->count;
+        if (left) {
+            audio_jitter_take(jb, samples, left);
+            memcpy(jb->last, samples + (left - 1) * jb->channels,
+                   jb->channels * sizeof(int16_t));
+        }
+
+        audio_jitter_conceal(jb, samples, left);
+        goto out;
+    }
+
+    /* A quarter period of hysteresis, on the side with the spare frames */
+    if (playout > (int32_t)(target + jb->period / 4) &&
+        jb->count > jb->period) {
+        audio_jitter_play(jb, samples, 1);
+    } else if (playout < (int32_t)target) {
+        audio_jitter_play(jb, samples, -1);
+    } else {
+        audio_jitter_play(jb, samples, 0);
+    }
+
+    for (i = 0, frame = samples; i < jb->period && jb->fade_in;
+         i++, frame += jb->channels) {
+        gain = AUDIO_JITTER_FADE_FRAMES + 1 - jb->fade_in--;
+        for (c = 0; c < jb->channels; c++) {
+            frame[c] = frame[c] * (int32_t)gain / AUDIO_JITTER_FADE_FRAMES;
+        }
+    }
+
+    memcpy(jb->last, samples + (jb->period - 1) * jb->channels,
+           jb->channels * sizeof(int16_t));
+
+out:
+    jb->stats.depth = jb->count;
+    irqrestore(flags);
+}
+
+void audio_jitter_get_stats(struct audio_jitter *jb,
+                            struct audio_jitter_stats *stats)
+{
+    irqstate_t flags;
+
+    flags = irqsave();
+    *stats = jb->stats;
+    stats->jitter_us = jb->jitter_q4 >> 4;
+    irqrestore(flags);
+}
+
+void audio_jitter_reset_stats(struct audio_jitter *jb)
+{
+    irqstate_t flags;
+
+    flags = irqsave();
+    jb->stats.underruns = 0;
+    jb->stats.overruns = 0;
+    jb->stats.dropped = 0;
+    jb->stats.concealed = 0;
+    jb->stats.merged = 0;
+    jb->stats.inserted = 0;
+    irqrestore(flags);
+}
+
+#ifdef CONFIG_ARA_AUDIO_JITTER_STATS
+
+/*
+ * Two lines: "D depth playout target jitter_us delay_us" with the depth and
+ * delays in frames, then "S underruns overruns dropped concealed merged
+ * inserted".
+ */
+static int audio_jitter_format(struct audio_jitter *jb, unsigned int index,
+                               char *line, size_t size)
+{
+    struct audio_jitter_stats stats;
+
+    if (index > 1) {
+        return 0;
+    }
+
+    audio_jitter_get_stats(jb, &stats);
+
+    if (!index) {
+        return snprintf(line, size, "D %u %d %u %u %u\n", stats.depth,
+                        stats.playout, stats.target, stats.jitter_us,
+                        stats.delay_us);
+    }
+
+    return snprintf(line, size, "S %u %u %u %u %u %u\n", stats.underruns,
+                    stats.overruns, stats.dropped, stats.concealed,
+                    stats.merged, stats.inserted);
+}
+
+/*
+ * The file position is used as a line index so that the dump can be read
+ * with any buffer size, as long as it holds at least one line.
+ */
+static ssize_t audio_jitter_read_stats(struct file *filep, char *buffer,
+                                       size_t buflen)
+{
+    struct audio_jitter *jb = filep->f_inode->i_private;
+    char line[AUDIO_JITTER_LINE_LEN];
+    size_t nread = 0;
+    int len;
+
+    while (nread < buflen) {
+        len = audio_jitter_format(jb, filep->f_pos, line, sizeof(line));
+        if (len <= 0 || nread + len > buflen) {
+            break;
+        }
+
+        memcpy(buffer + nread, line, len);
+        nread += len;
+        filep->f_pos++;
+    }
+
+    return nread;
+}
+
+/* Writing anything to the device clears the counters. */
+static ssize_t audio_jitter_write_stats(struct file *filep,
+                                        const char *buffer, size_t buflen)
+{
+    audio_jitter_reset_stats(filep->f_inode->i_private);
+
+    return buflen;
+}
+
+static const struct file_operations audio_jitter_fops = {
+    .read   = audio_jitter_read_stats,
+    .write  = audio_jitter_write_stats,
+};
+
+int audio_jitter_register(struct audio_jitter *jb, const char *path)
+{
+    return register_driver(path, &audio_jitter_fops, 0666, jb);
+}
+
+#endif /* CONFIG_ARA_AUDIO_JITTER_STATS */
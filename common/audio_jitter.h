@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FDK_COMMON_AUDIO_JITTER_H
+#define FDK_COMMON_AUDIO_JITTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <nuttx/config.h>
+
+/*
+ * Adaptive jitter buffer between the audio data CPort and the I2S
+ * transmitter. Packets are written when they arrive, along with their
+ * arrival time, and the I2S side reads one period of frames at a time.
+ *
+ * The buffer measures how late packets arrive compared to the earliest
+ * ones and steers the playout delay, the time between the earliest
+ * possible arrival of a frame and its playback, to just cover that
+ * lateness. Too late, it merges two frames into one; too early, it
+ * interpolates an extra frame, at most one frame per period either way.
+ * When it runs dry the last frame fades out, and playback resumes with a
+ * fade-in once the buffer is refilled.
+ *
+ * Samples are signed 16-bit and interleaved. There must be one writer and
+ * one reader, either of them may run in interrupt context.
+ *
+ * Add CONFIG_ARA_AUDIO_JITTER_STATS=y to the module config to get a
+ * character device per buffer reporting its depth and counters.
+ */
+
+#define AUDIO_JITTER_MAX_CHANNELS       2
+
+/* Frames faded out on an underrun and faded in when playback resumes */
+#define AUDIO_JITTER_FADE_FRAMES        32
+
+#define AUDIO_JITTER_LINE_LEN           96
+
+/**
+ * @brief Jitter buffer counters and state
+ */
+struct audio_jitter_stats {
+    /** Reads that found less than a period while playing */
+    uint32_t underruns;
+    /** Writes that did not fit */
+    uint32_t overruns;
+    /** Frames lost to overruns */
+    uint32_t dropped;
+    /** Frames faded out or silent between an underrun and the refill */
+    uint32_t concealed;
+    /** Frames merged away because the buffer was too deep */
+    uint32_t merged;
+    /** Frames interpolated because the buffer was too shallow */
+    uint32_t inserted;
+    /** Frames currently buffered */
+    uint32_t depth;
+    /** Playout delay and the delay it is steered to, in frames */
+    int32_t playout;
+    uint32_t target;
+    /** Interarrival jitter estimated as in RFC 3550, in microseconds */
+    uint32_t jitter_us;
+    /** Late arrival envelope the playout delay covers, in microseconds */
+    uint32_t delay_us;
+};
+
+/**
+ * @brief Jitter buffer, owned by the driver
+ *
+ * The fields are private, use audio_jitter_setup() to initialize it.
+ */
+struct audio_jitter {
+    /** Ring of capacity frames */
+    int16_t *ring;
+    uint32_t capacity;
+    uint32_t head;
+    uint32_t count;
+    uint8_t channels;
+    uint32_t rate;
+    /** Frames per read */
+    uint32_t period;
+
+    /** Playing, or refilling after an underrun or a reset */
+    bool playing;
+    /** Set once playback has started, silence before is not concealment */
+    bool primed;
+    /** Frames of fade-in left */
+    uint32_t fade_in;
+    /** Position in the fade-out of the last frame played */
+    uint32_t fade_out;
+    int16_t last[AUDIO_JITTER_MAX_CHANNELS];
+
+    /** Arrival tracking: media time of the next packet, in microseconds */
+    bool arrived;
+    uint32_t media_us;
+    uint32_t media_rem;
+    /** Arrival time of the latest packet that raised the envelope */
+    uint32_t peak_time;
+    /** Transit time of the earliest packets and of the previous one */
+    int32_t base;
+    int32_t transit;
+    /** RFC 3550 jitter, in 1/16 microseconds */
+    uint32_t jitter_q4;
+
+    struct audio_jitter_stats stats;
+};
+
+/**
+ * @brief Prepare an empty jitter buffer
+ * @param jb Jitter buffer
+ * @param ring Storage for capacity frames
+ * @param capacity Number of frames of the storage, at least 4 periods
+ * @param channels Samples per frame
+ * @param rate Frames per second
+ * @param period Frames per read, at least 2
+ * @return 0 on success, -EINVAL on invalid parameters
+ */
+int audio_jitter_setup(struct audio_jitter *jb, int16_t *ring,
+                       uint32_t capacity, uint8_t channels, uint32_t rate,
+                       uint32_t period);
+
+/**
+ * @brief Drop the buffered frames and the arrival history
+ *
+ * To be called when the stream stops, the counters are kept.
+ *
+ * @param jb Jitter buffer
+ */
+void audio_jitter_reset(struct audio_jitter *jb);
+
+/**
+ * @brief Queue a packet received from the data CPort
+ * @param jb Jitter buffer
+ * @param samples Interleaved samples
+ * @param frames Number of frames
+ * @param now Arrival time, in microseconds
+ * @return number of frames queued, less than frames on overrun
+ */
+uint32_t audio_jitter_write(struct audio_jitter *jb, const int16_t *samples,
+                            uint32_t frames, uint32_t now);
+
+/**
+ * @brief Get one period of frames for the I2S transmitter
+ *
+ * Always fills the period, with concealment or silence when the buffer has
+ * not enough frames.
+ *
+ * @param jb Jitter buffer
+ * @param samples Output buffer of one period
+ * @param now Current time, in microseconds
+ */
+void audio_jitter_read(struct audio_jitter *jb, int16_t *samples,
+                       uint32_t now);
+
+void audio_jitter_get_stats(struct audio_jitter *jb,
+                            struct audio_jitter_stats *stats);
+
+/**
+ * @brief Clear the counters, the depth and estimates are kept
+ * @param jb Jitter buffer
+ */
+void audio_jitter_reset_stats(struct audio_jitter *jb);
+
+#ifdef CONFIG_ARA_AUDIO_JITTER_STATS
+
+/**
+ * @brief Register the statistics device of a jitter buffer
+ * @param jb Jitter buffer
+ * @param path Path of the character device
+ * @return 0 on success, negative errno on error
+ */
+int audio_jitter_register(struct audio_jitter *jb, const char *path);
+
+#else
+
+static inline int audio_jitter_register(struct audio_jitter *jb,
+                                        const char *path)
+{
+    return 0;
+}
+
+#endif /* CONFIG_ARA_AUDIO_JITTER_STATS */
+
+#endif /* FDK_COMMON_AUDIO_JITTER_H */
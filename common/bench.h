@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FDK_COMMON_BENCH_H
+#define FDK_COMMON_BENCH_H
+
+#include <stdbool.h>
+#include <syslog.h>
+
+/*
+ * Helpers shared by the boot benches of the modules.
+ *
+ * A bench replays fixed scenarios through a driver, without the hardware
+ * or the AP, and checks what it measures against a budget per scenario.
+ * Each scenario logs one line ending with its verdict, and the bench ends
+ * with a summary line, so a run can be compared at a glance.
+ *
+ * Budgets are set from what the bench prints on target. Lower them when the
+ * code gets cheaper, never raise them to make a change pass.
+ */
+
+/**
+ * @brief Verdict of a scenario
+ * @param error The scenario could not run to its end
+ * @param regression A measurement is over its budget
+ * @return the string ending the scenario line
+ */
+static inline const char *bench_verdict(bool error, bool regression)
+{
+    return error ? "ERROR" : regression ? "REGRESSION" : "ok";
+}
+
+/**
+ * @brief Verdict of a check against a reference
+ * @param match The output matches the reference
+ * @return the string ending the check line
+ */
+static inline const char *bench_match(bool match)
+{
+    return match ? "ok" : "MISMATCH";
+}
+
+/**
+ * @brief Log the summary line of a bench
+ * @param prefix Prefix of the bench log lines
+ * @param what Scenarios, in the plural
+ * @param total Number of scenarios
+ * @param failures Number of scenarios over budget or in error
+ */
+static inline void bench_summary(const char *prefix, const char *what,
+                                 unsigned int total, unsigned int failures)
+{
+    lowsyslog("%s: %u/%u %s within budget\n", prefix, total - failures,
+              total, what);
+}
+
+#endif /* FDK_COMMON_BENCH_H */
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FDK_COMMON_CYCLE_COUNTER_H
+#define FDK_COMMON_CYCLE_COUNTER_H
+
+#include <stdint.h>
+
+/*
+ * Free-running cycle counter of the Cortex-M3, the DWT CYCCNT register, for
+ * timing intervals far shorter than the system tick.
+ *
+ * It counts core clock cycles and wraps every 2^32 cycles, about 89 s, so
+ * the difference of two reads is exact for any shorter interval. Keep raw
+ * reads as timestamps and only convert their differences. Without the DWT,
+ * on a host build for instance, it reads 0.
+ */
+
+/* Core clock of the bridge */
+#define CYCLE_COUNTER_HZ                48000000
+
+/* Cortex-M3 DWT registers */
+#define CYCLE_COUNTER_DEMCR             0xe000edfc
+#define CYCLE_COUNTER_DEMCR_TRCENA      (1 << 24)
+#define CYCLE_COUNTER_DWT_CTRL          0xe0001000
+#define CYCLE_COUNTER_DWT_CYCCNTENA     (1 << 0)
+#define CYCLE_COUNTER_DWT_CYCCNT        0xe0001004
+
+/**
+ * @brief Start the cycle counter
+ *
+ * Starting it again is harmless, every user can call it at init.
+ */
+static inline void cycle_counter_init(void)
+{
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+    *(volatile uint32_t *)CYCLE_COUNTER_DEMCR |= CYCLE_COUNTER_DEMCR_TRCENA;
+    *(volatile uint32_t *)CYCLE_COUNTER_DWT_CTRL |=
+        CYCLE_COUNTER_DWT_CYCCNTENA;
+#endif
+}
+
+/**
+ * @brief Read the cycle counter
+ * @return the cycle count, wrapping at 2^32
+ */
+static inline uint32_t cycle_counter_read(void)
+{
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+    return *(volatile uint32_t *)CYCLE_COUNTER_DWT_CYCCNT;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Convert a number of cycles to microseconds
+ * @param cycles Difference of two reads of the counter
+ * @return the interval in us, rounded down
+ */
+static inline uint32_t cycle_counter_to_us(uint32_t cycles)
+{
+    return cycles / (CYCLE_COUNTER_HZ / 1000000);
+}
+
+#endif /* FDK_COMMON_CYCLE_COUNTER_H */
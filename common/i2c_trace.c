@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <nuttx/config.h>
+
+#ifdef CONFIG_ARA_I2C_TRACE
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/i2c.h>
+#include <nuttx/util.h>
+
+#include <arch/irq.h>
+
+#include "i2c_trace.h"
+
+/* Longest histogram line: "H 0xffff", 3 + 16 counters of 10 digits, "\n" */
+#define I2C_TRACE_LINE_LEN \
+    (8 + (3 + I2C_TRACE_HIST_BUCKETS) * 11 + 2)
+
+/**
+ * @brief Per-slave latency statistics
+ */
+struct i2c_trace_device {
+    uint16_t addr;
+    uint32_t count;
+    uint32_t bytes;
+    uint32_t busy_us;
+    uint32_t hist[I2C_TRACE_HIST_BUCKETS];
+};
+
+/**
+ * @brief Tracer state
+ */
+struct i2c_trace_info {
+    /** Ring buffer of the latest transactions */
+    struct i2c_trace_entry ring[I2C_TRACE_RING_SIZE];
+    /** Index of the next ring entry to write */
+    unsigned int head;
+    /** Number of valid ring entries */
+    unsigned int count;
+    /** Number of histograms in use */
+    unsigned int num_devices;
+    struct i2c_trace_device devices[I2C_TRACE_MAX_DEVICES];
+};
+
+static struct i2c_trace_info i2c_trace;
+
+static uint32_t i2c_trace_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static unsigned int i2c_trace_bucket(uint32_t duration)
+{
+    unsigned int bucket = 0;
+
+    while (duration >>= 1) {
+        bucket++;
+    }
+
+    return bucket < I2C_TRACE_HIST_BUCKETS ?
+           bucket : I2C_TRACE_HIST_BUCKETS - 1;
+}
+
+static struct i2c_trace_device *i2c_trace_get_device(uint16_t addr)
+{
+    struct i2c_trace_device *tdev;
+    unsigned int i;
+
+    for (i = 0; i < i2c_trace.num_devices; i++) {
+        if (i2c_trace.devices[i].addr == addr) {
+            return &i2c_trace.devices[i];
+        }
+    }
+
+    /* Devices beyond the table size only show up in the ring. */
+    if (i2c_trace.num_devices == I2C_TRACE_MAX_DEVICES) {
+        return NULL;
+    }
+
+    tdev = &i2c_trace.devices[i2c_trace.num_devices++];
+    tdev->addr = addr;
+
+    return tdev;
+}
+
+static void i2c_trace_record(const struct i2c_trace_entry *entry)
+{
+    struct i2c_trace_device *tdev;
+    irqstate_t flags;
+
+    flags = irqsave();
+
+    i2c_trace.ring[i2c_trace.head] = *entry;
+    i2c_trace.head = (i2c_trace.head + 1) % I2C_TRACE_RING_SIZE;
+    if (i2c_trace.count < I2C_TRACE_RING_SIZE) {
+        i2c_trace.count++;
+    }
+
+    tdev = i2c_trace_get_device(entry->addr);
+    if (tdev) {
+        tdev->count++;
+        tdev->bytes += entry->length;
+        tdev->busy_us += entry->duration;
+        tdev->hist[i2c_trace_bucket(entry->duration)]++;
+    }
+
+    irqrestore(flags);
+}
+
+int i2c_trace_transfer(struct i2c_dev_s *dev, struct i2c_msg_s *msgs,
+                       int count)
+{
+    struct i2c_trace_entry entry;
+    int ret;
+    int i;
+
+    memset(&entry, 0, sizeof(entry));
+
+    entry.addr = msgs[0].addr;
+    for (i = 0; i < count; i++) {
+        entry.length += msgs[i].length;
+    }
+
+    if (!(msgs[0].flags & I2C_M_READ) && msgs[0].length) {
+        entry.reg = msgs[0].buffer[0];
+        if (msgs[0].length > 1) {
+            entry.reg = (entry.reg << 8) | msgs[0].buffer[1];
+        }
+    }
+
+    entry.timestamp = i2c_trace_now();
+    ret = I2C_TRANSFER(dev, msgs, count);
+    entry.duration = i2c_trace_now() - entry.timestamp;
+    entry.result = ret;
+
+    i2c_trace_record(&entry);
+
+    return ret;
+}
+
+void i2c_trace_reset(void)
+{
+    irqstate_t flags;
+
+    flags = irqsave();
+    memset(&i2c_trace, 0, sizeof(i2c_trace));
+    irqrestore(flags);
+}
+
+/**
+ * @brief Format one line of the trace dump
+ *
+ * Lines 0 to count - 1 are the ring entries, oldest first, followed by one
+ * line per histogram.
+ *
+ * @param index Line index
+ * @param line Output buffer
+ * @param size Size of the output buffer
+ * @return number of characters written, 0 past the last line
+ */
+static int i2c_trace_format(unsigned int index, char *line, size_t size)
+{
+    struct i2c_trace_entry entry;
+    struct i2c_trace_device tdev;
+    irqstate_t flags;
+    unsigned int i;
+    int len;
+
+    flags = irqsave();
+
+    if (index < i2c_trace.count) {
+        i = i2c_trace.head + I2C_TRACE_RING_SIZE - i2c_trace.count + index;
+        entry = i2c_trace.ring[i % I2C_TRACE_RING_SIZE];
+        irqrestore(flags);
+
+        len = snprintf(line, size, "T %u %u 0x%02x 0x%04x %u %d\n",
+                       entry.timestamp, entry.duration, entry.addr,
+                       entry.reg, entry.length, entry.result);
+        return MIN(len, (int)size - 1);
+    }
+
+    index -= i2c_trace.count;
+    if (index >= i2c_trace.num_devices) {
+        irqrestore(flags);
+        return 0;
+    }
+
+    tdev = i2c_trace.devices[index];
+    irqrestore(flags);
+
+    /* snprintf() returns the untruncated length, never step past the end */
+    len = snprintf(line, size, "H 0x%02x %u %u %u", tdev.addr, tdev.count,
+                   tdev.bytes, tdev.busy_us);
+    for (i = 0; i < I2C_TRACE_HIST_BUCKETS && len < (int)size - 1; i++) {
+        len += snprintf(line + len, size - len, " %u", tdev.hist[i]);
+    }
+    if (len < (int)size - 1) {
+        len += snprintf(line + len, size - len, "\n");
+    }
+
+    return MIN(len, (int)size - 1);
+}
+
+/*
+ * The file position is used as a line index so that the dump can be read
+ * with any buffer size, as long as it holds at least one line.
+ */
+static ssize_t i2c_trace_read(struct file *filep, char *buffer, size_t buflen)
+{
+    char line[I2C_TRACE_LINE_LEN];
+    size_t nread = 0;
+    int len;
+
+    while (nread < buflen) {
+        len = i2c_trace_format(filep->f_pos, line, sizeof(line));
+        if (len <= 0 || nread + len > buflen) {
+            break;
+        }
+
+        memcpy(buffer + nread, line, len);
+        nread += len;
+        filep->f_pos++;
+    }
+
+    return nread;
+}
+
+/* Writing anything to the device clears the trace. */
+static ssize_t i2c_trace_write(struct file *filep, const char *buffer,
+                               size_t buflen)
+{
+    i2c_trace_reset();
+    return buflen;
+}
+
+static const struct file_operations i2c_trace_fops = {
+    .read   = i2c_trace_read,
+    .write  = i2c_trace_write,
+};
+
+int i2c_trace_init(void)
+{
+    return register_driver(I2C_TRACE_DEVPATH, &i2c_trace_fops, 0666, NULL);
+}
+
+#endif /* CONFIG_ARA_I2C_TRACE */
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FDK_COMMON_I2C_TRACE_H
+#define FDK_COMMON_I2C_TRACE_H
+
+#include <nuttx/config.h>
+#include <nuttx/i2c.h>
+
+/*
+ * The tracer is opt-in: add CONFIG_ARA_I2C_TRACE=y to the module config to
+ * record every transaction issued through i2c_trace_transfer(). Without it,
+ * i2c_trace_transfer() is a plain I2C_TRANSFER() and costs nothing.
+ */
+
+/* Number of transactions kept in the ring buffer */
+#define I2C_TRACE_RING_SIZE             128
+
+/* Number of distinct slave addresses that get a latency histogram */
+#define I2C_TRACE_MAX_DEVICES           4
+
+/* Histogram bucket n counts transactions that took [2^n, 2^(n+1)) us */
+#define I2C_TRACE_HIST_BUCKETS          16
+
+/* Path of the character device dumping the trace (cat it from NSH) */
+#define I2C_TRACE_DEVPATH               "/dev/i2ctrace"
+
+/**
+ * @brief One recorded I2C transaction
+ */
+struct i2c_trace_entry {
+    /** Start of the transaction, in microseconds */
+    uint32_t timestamp;
+    /** Time spent in I2C_TRANSFER(), in microseconds */
+    uint32_t duration;
+    /** Slave address */
+    uint16_t addr;
+    /** Register address (first bytes of the first write message) */
+    uint16_t reg;
+    /** Total number of bytes in all messages */
+    uint16_t length;
+    /** Value returned by I2C_TRANSFER() */
+    int16_t result;
+};
+
+#ifdef CONFIG_ARA_I2C_TRACE
+
+/**
+ * @brief Register the trace dump device
+ * @return 0 on success, negative errno on error
+ */
+int i2c_trace_init(void);
+
+/**
+ * @brief Perform an I2C transfer and record it in the trace
+ * @param dev Pointer to structure of i2c device data
+ * @param msgs Messages to transfer
+ * @param count Number of messages
+ * @return the value returned by I2C_TRANSFER()
+ */
+int i2c_trace_transfer(struct i2c_dev_s *dev, struct i2c_msg_s *msgs,
+                       int count);
+
+/**
+ * @brief Clear the ring buffer and all histograms
+ */
+void i2c_trace_reset(void);
+
+#else
+
+static inline int i2c_trace_init(void)
+{
+    return 0;
+}
+
+#define i2c_trace_transfer(dev, msgs, count) I2C_TRANSFER(dev, msgs, count)
+
+static inline void i2c_trace_reset(void)
+{
+}
+
+#endif /* CONFIG_ARA_I2C_TRACE */
+
+#endif /* FDK_COMMON_I2C_TRACE_H */
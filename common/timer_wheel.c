@@ -0,0 +1,527 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <stdio.h>
+
+#include <nuttx/config.h>
+#include <nuttx/clock.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/wqueue.h>
+
+#include <arch/irq.h>
+
+#include "timer_wheel.h"
+
+/* The slot occupancy of a level is kept in one 32-bit word. */
+#if TIMER_WHEEL_SLOTS != 32
+#error "timer wheel levels must have 32 slots"
+#endif
+
+#define TIMER_WHEEL_SLOT_MASK           (TIMER_WHEEL_SLOTS - 1)
+
+/* Level of the timers waiting for their callback to run */
+#define TIMER_WHEEL_EXPIRED             TIMER_WHEEL_LEVELS
+
+#define TIMER_WHEEL_LINE_LEN            96
+
+/**
+ * @brief Wheel state
+ *
+ * A timer on level n is in the slot of the 2^(5n) ticks wide block holding
+ * its expiry. That block is always 1 to 31 blocks ahead of the wheel time on
+ * levels above 0, and the timer moves down a level when the wheel time
+ * reaches the start of the block.
+ */
+struct timer_wheel_info {
+    struct wheel_timer *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    /** Bit n set when slot n of the level holds timers */
+    uint32_t occupied[TIMER_WHEEL_LEVELS];
+    /** Timers due, in expiry order */
+    struct wheel_timer *expired;
+    struct wheel_timer **expired_tail;
+    /** Latest tick processed */
+    uint32_t time;
+    /** Work item running the callbacks, and the tick it is queued for */
+    struct work_s work;
+    uint32_t deadline;
+    bool scheduled;
+    /** Set while the callbacks run, the work item is queued after them */
+    bool running;
+    struct timer_wheel_stats stats;
+};
+
+static struct timer_wheel_info timer_wheel = {
+    .expired_tail = &timer_wheel.expired,
+};
+
+static uint32_t timer_wheel_now(void)
+{
+    return (uint32_t)clock_systimer();
+}
+
+static inline uint32_t timer_wheel_ror(uint32_t x, unsigned int n)
+{
+    return n ? (x >> n) | (x << (32 - n)) : x;
+}
+
+static void timer_wheel_unlink(struct wheel_timer *timer)
+{
+    *timer->pprev = timer->next;
+    if (timer->next) {
+        timer->next->pprev = timer->pprev;
+    } else if (timer->level == TIMER_WHEEL_EXPIRED) {
+        timer_wheel.expired_tail = timer->pprev;
+    }
+
+    if (timer->level < TIMER_WHEEL_LEVELS &&
+        !timer_wheel.slots[timer->level][timer->slot]) {
+        timer_wheel.occupied[timer->level] &= ~(1u << timer->slot);
+    }
+
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+static void timer_wheel_expire(struct wheel_timer *timer)
+{
+    timer->level = TIMER_WHEEL_EXPIRED;
+    timer->next = NULL;
+    timer->pprev = timer_wheel.expired_tail;
+    *timer_wheel.expired_tail = timer;
+    timer_wheel.expired_tail = &timer->next;
+}
+
+/* Link a timer in the slot matching its expiry, relative to the wheel time */
+static void timer_wheel_insert(struct wheel_timer *timer)
+{
+    struct wheel_timer **head;
+    unsigned int shift = 0;
+    unsigned int level;
+    uint32_t blocks;
+
+    if ((int32_t)(timer->expires - timer_wheel.time) <= 0) {
+        timer_wheel_expire(timer);
+        return;
+    }
+
+    for (level = 0; level < TIMER_WHEEL_LEVELS - 1; level++) {
+        shift = level * TIMER_WHEEL_SLOT_BITS;
+        blocks = ((timer->expires >> shift) - (timer_wheel.time >> shift)) &
+                 (UINT32_MAX >> shift);
+        if (blocks < TIMER_WHEEL_SLOTS) {
+            break;
+        }
+    }
+    shift = level * TIMER_WHEEL_SLOT_BITS;
+
+    timer->level = level;
+    timer->slot = (timer->expires >> shift) & TIMER_WHEEL_SLOT_MASK;
+
+    head = &timer_wheel.slots[level][timer->slot];
+    timer->next = *head;
+    timer->pprev = head;
+    if (*head) {
+        (*head)->pprev = &timer->next;
+    }
+    *head = timer;
+
+    timer_wheel.occupied[level] |= 1u << timer->slot;
+}
+
+/*
+ * Find the next tick with work to do: a level 0 slot expiring, or an upper
+ * level slot to cascade. Returns false when the wheel is empty.
+ */
+static bool timer_wheel_next_event(uint32_t *when)
+{
+    unsigned int level;
+    unsigned int shift;
+    uint32_t base;
+    uint32_t event;
+    bool found = false;
+
+    for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        if (!timer_wheel.occupied[level]) {
+            continue;
+        }
+
+        shift = level * TIMER_WHEEL_SLOT_BITS;
+        base = timer_wheel.time >> shift;
+        base += __builtin_ctz(timer_wheel_ror(timer_wheel.occupied[level],
+                                              base & TIMER_WHEEL_SLOT_MASK));
+        event = level ? base << shift : base;
+
+        if (!found || (int32_t)(event - *when) < 0) {
+            *when = event;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+/* Move the timers of an upper level slot down, now that its block started */
+static void timer_wheel_cascade(unsigned int level, unsigned int slot)
+{
+    struct wheel_timer *timer = timer_wheel.slots[level][slot];
+    struct wheel_timer *next;
+
+    timer_wheel.slots[level][slot] = NULL;
+    timer_wheel.occupied[level] &= ~(1u << slot);
+
+    for (; timer; timer = next) {
+        next = timer->next;
+        timer_wheel_insert(timer);
+        timer_wheel.stats.cascaded++;
+    }
+}
+
+/*
+ * Bring the wheel time up to now, jumping from one event to the next rather
+ * than walking every tick. Called with interrupts disabled.
+ */
+static void timer_wheel_advance(uint32_t now)
+{
+    struct wheel_timer *timer;
+    struct wheel_timer *next;
+    unsigned int level;
+    unsigned int shift;
+    unsigned int slot;
+    uint32_t event = 0;
+
+    while (timer_wheel_next_event(&event) && (int32_t)(event - now) <= 0) {
+        timer_wheel.time = event;
+
+        for (level = TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+            shift = level * TIMER_WHEEL_SLOT_BITS;
+            if (!(event & ((1u << shift) - 1))) {
+                slot = (event >> shift) & TIMER_WHEEL_SLOT_MASK;
+                timer_wheel_cascade(level, slot);
+            }
+        }
+
+        slot = event & TIMER_WHEEL_SLOT_MASK;
+        timer = timer_wheel.slots[0][slot];
+        timer_wheel.slots[0][slot] = NULL;
+        timer_wheel.occupied[0] &= ~(1u << slot);
+
+        for (; timer; timer = next) {
+            next = timer->next;
+            timer_wheel_expire(timer);
+        }
+    }
+
+    if ((int32_t)(now - timer_wheel.time) > 0) {
+        timer_wheel.time = now;
+    }
+}
+
+/*
+ * Earliest expiry of all the pending timers. Only the first occupied slot of
+ * each level needs to be looked at: later slots of a level expire later.
+ * Cascades need no wake-up of their own, they are done on the way to the
+ * expiry.
+ */
+static bool timer_wheel_next_expiry(uint32_t *when)
+{
+    struct wheel_timer *timer;
+    unsigned int level;
+    unsigned int shift;
+    unsigned int slot;
+    bool found = false;
+
+    if (timer_wheel.expired) {
+        *when = timer_wheel.time;
+        return true;
+    }
+
+    for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        if (!timer_wheel.occupied[level]) {
+            continue;
+        }
+
+        shift = level * TIMER_WHEEL_SLOT_BITS;
+        slot = (timer_wheel.time >> shift) & TIMER_WHEEL_SLOT_MASK;
+        slot += __builtin_ctz(timer_wheel_ror(timer_wheel.occupied[level],
+                                              slot));
+        slot &= TIMER_WHEEL_SLOT_MASK;
+
+        for (timer = timer_wheel.slots[level][slot]; timer;
+             timer = timer->next) {
+            if (!found || (int32_t)(timer->expires - *when) < 0) {
+                *when = timer->expires;
+                found = true;
+            }
+        }
+    }
+
+    return found;
+}
+
+static void timer_wheel_worker(void *data);
+
+/*
+ * Queue the work item for a tick, unless it is already queued to run at or
+ * before it. Called with interrupts disabled.
+ */
+static void timer_wheel_schedule(uint32_t now, uint32_t when)
+{
+    uint32_t delay = 0;
+
+    if (timer_wheel.running) {
+        return;
+    }
+
+    if ((int32_t)(when - now) > 0) {
+        delay = when - now;
+    }
+
+    if (timer_wheel.scheduled &&
+        (int32_t)(now + delay - timer_wheel.deadline) >= 0) {
+        return;
+    }
+
+    if (timer_wheel.scheduled) {
+        work_cancel(HPWORK, &timer_wheel.work);
+    }
+
+    work_queue(HPWORK, &timer_wheel.work, timer_wheel_worker, NULL, delay);
+    timer_wheel.scheduled = true;
+    timer_wheel.deadline = now + delay;
+}
+
+static void timer_wheel_worker(void *data)
+{
+    struct wheel_timer *timer;
+    timer_wheel_callback_t callback;
+    irqstate_t flags;
+    uint32_t when;
+    void *arg;
+
+    flags = irqsave();
+
+    timer_wheel.scheduled = false;
+    timer_wheel.running = true;
+    timer_wheel.stats.wakeups++;
+    timer_wheel_advance(timer_wheel_now());
+
+    while ((timer = timer_wheel.expired)) {
+        timer_wheel_unlink(timer);
+        timer_wheel.stats.expired++;
+        timer_wheel.stats.pending--;
+
+        callback = timer->callback;
+        arg = timer->arg;
+
+        /* The callback may re-arm or free the timer. */
+        irqrestore(flags);
+        callback(arg);
+        flags = irqsave();
+    }
+
+    timer_wheel.running = false;
+    if (timer_wheel_next_expiry(&when)) {
+        timer_wheel_schedule(timer_wheel_now(), when);
+    }
+
+    irqrestore(flags);
+}
+
+void timer_wheel_setup(struct wheel_timer *timer,
+                       timer_wheel_callback_t callback, void *arg)
+{
+    memset(timer, 0, sizeof(*timer));
+    timer->callback = callback;
+    timer->arg = arg;
+}
+
+void timer_wheel_arm(struct wheel_timer *timer, uint32_t ms)
+{
+    irqstate_t flags;
+    uint32_t ticks;
+    uint32_t now;
+
+    ticks = ms / MSEC_PER_TICK + (ms % MSEC_PER_TICK != 0);
+    if (ticks == 0) {
+        ticks = 1;
+    } else if (ticks > TIMER_WHEEL_MAX_TICKS) {
+        ticks = TIMER_WHEEL_MAX_TICKS;
+    }
+
+    flags = irqsave();
+
+    /* An empty wheel restarts from now, however long it has been idle. */
+    now = timer_wheel_now();
+    if (!timer_wheel.stats.pending) {
+        timer_wheel.time = now;
+    } else {
+        timer_wheel_advance(now);
+    }
+
+    timer_wheel.stats.armed++;
+    if (timer->pprev) {
+        timer_wheel_unlink(timer);
+        timer_wheel.stats.cancelled++;
+    } else {
+        timer_wheel.stats.pending++;
+    }
+
+    timer->expires = now + ticks;
+    timer_wheel_insert(timer);
+    timer_wheel_schedule(now, timer->expires);
+
+    irqrestore(flags);
+}
+
+void timer_wheel_cancel(struct wheel_timer *timer)
+{
+    irqstate_t flags;
+
+    flags = irqsave();
+
+    if (timer->pprev) {
+        timer_wheel_unlink(timer);
+        timer_wheel.stats.cancelled++;
+        timer_wheel.stats.pending--;
+    }
+
+    /* Nothing left to wait for, do not wake up for nothing. */
+    if (!timer_wheel.stats.pending && timer_wheel.scheduled) {
+        work_cancel(HPWORK, &timer_wheel.work);
+        timer_wheel.scheduled = false;
+    }
+
+    irqrestore(flags);
+}
+
+bool timer_wheel_pending(const struct wheel_timer *timer)
+{
+    return timer->pprev != NULL;
+}
+
+void timer_wheel_get_stats(struct timer_wheel_stats *stats)
+{
+    irqstate_t flags;
+
+    flags = irqsave();
+    *stats = timer_wheel.stats;
+    irqrestore(flags);
+}
+
+#ifdef CONFIG_ARA_TIMER_WHEEL_STATS
+
+/*
+ * One line per level, with the number of timers it holds, followed by the
+ * counters: "S wakeups expired cascaded armed cancelled pending".
+ */
+static int timer_wheel_format(unsigned int index, char *line, size_t size)
+{
+    struct timer_wheel_stats stats;
+    struct wheel_timer *timer;
+    irqstate_t flags;
+    unsigned int count = 0;
+    unsigned int slot;
+
+    if (index < TIMER_WHEEL_LEVELS) {
+        flags = irqsave();
+        for (slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+            for (timer = timer_wheel.slots[index][slot]; timer;
+                 timer = timer->next) {
+                count++;
+            }
+        }
+        irqrestore(flags);
+
+        return snprintf(line, size, "L %u %u\n", index, count);
+    }
+
+    if (index > TIMER_WHEEL_LEVELS) {
+        return 0;
+    }
+
+    timer_wheel_get_stats(&stats);
+
+    return snprintf(line, size, "S %u %u %u %u %u %u\n", stats.wakeups,
+                    stats.expired, stats.cascaded, stats.armed,
+                    stats.cancelled, stats.pending);
+}
+
+/*
+ * The file position is used as a line index so that the dump can be read
+ * with any buffer size, as long as it holds at least one line.
+ */
+static ssize_t timer_wheel_read(struct file *filep, char *buffer,
+                                size_t buflen)
+{
+    char line[TIMER_WHEEL_LINE_LEN];
+    size_t nread = 0;
+    int len;
+
+    while (nread < buflen) {
+        len = timer_wheel_format(filep->f_pos, line, sizeof(line));
+        if (len <= 0 || nread + len > buflen) {
+            break;
+        }
+
+        memcpy(buffer + nread, line, len);
+        nread += len;
+        filep->f_pos++;
+    }
+
+    return nread;
+}
+
+/* Writing anything to the device clears the counters. */
+static ssize_t timer_wheel_write(struct file *filep, const char *buffer,
+                                 size_t buflen)
+{
+    irqstate_t flags;
+    uint32_t pending;
+
+    flags = irqsave();
+    pending = timer_wheel.stats.pending;
+    memset(&timer_wheel.stats, 0, sizeof(timer_wheel.stats));
+    timer_wheel.stats.pending = pending;
+    irqrestore(flags);
+
+    return buflen;
+}
+
+static const struct file_operations timer_wheel_fops = {
+    .read   = timer_wheel_read,
+    .write  = timer_wheel_write,
+};
+
+int timer_wheel_init(void)
+{
+    return register_driver(TIMER_WHEEL_DEVPATH, &timer_wheel_fops, 0666,
+                           NULL);
+}
+
+#endif /* CONFIG_ARA_TIMER_WHEEL_STATS */
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FDK_COMMON_TIMER_WHEEL_H
+#define FDK_COMMON_TIMER_WHEEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <nuttx/config.h>
+
+/*
+ * Board-level software timers. Every timer of the module lives in one
+ * hierarchical wheel driven by a single work item on the high priority work
+ * queue. That work item is only queued for the next expiry, never as a
+ * periodic tick, so idle timers cost no wake-ups and timers expiring in the
+ * same tick share one. Arming and cancelling are constant time and may be
+ * done from interrupt context.
+ *
+ * Callbacks run on the high priority work queue: they must not block for
+ * long, and longer jobs should be queued from the callback instead.
+ *
+ * Add CONFIG_ARA_TIMER_WHEEL_STATS=y to the module config to register a
+ * character device reporting the wheel activity.
+ */
+
+/* Each level of the wheel has 2^TIMER_WHEEL_SLOT_BITS slots */
+#define TIMER_WHEEL_SLOT_BITS           5
+#define TIMER_WHEEL_SLOTS               (1 << TIMER_WHEEL_SLOT_BITS)
+
+/* Level n slots are 2^(n * TIMER_WHEEL_SLOT_BITS) ticks wide */
+#define TIMER_WHEEL_LEVELS              4
+
+/* Longer timeouts are clamped, 31 * 2^15 ticks is about 2.8 hours at 10 ms */
+#define TIMER_WHEEL_MAX_TICKS \
+    ((uint32_t)(TIMER_WHEEL_SLOTS - 1) << \
+     ((TIMER_WHEEL_LEVELS - 1) * TIMER_WHEEL_SLOT_BITS))
+
+/* Path of the character device dumping the statistics (cat it from NSH) */
+#define TIMER_WHEEL_DEVPATH             "/dev/timerwheel"
+
+typedef void (*timer_wheel_callback_t)(void *arg);
+
+/**
+ * @brief Software timer, owned by the driver and linked in the wheel
+ *
+ * The fields are private to the wheel, use timer_wheel_setup() to initialize
+ * a timer before arming it.
+ */
+struct wheel_timer {
+    struct wheel_timer *next;
+    struct wheel_timer **pprev;
+    /** Expiry, in system ticks */
+    uint32_t expires;
+    /** Wheel level and slot holding the timer */
+    uint8_t level;
+    uint8_t slot;
+    timer_wheel_callback_t callback;
+    void *arg;
+};
+
+/**
+ * @brief Wheel activity counters
+ */
+struct timer_wheel_stats {
+    /** Times the wheel work item ran */
+    uint32_t wakeups;
+    /** Callbacks run */
+    uint32_t expired;
+    /** Timers moved down from an upper level */
+    uint32_t cascaded;
+    /** Calls to timer_wheel_arm() */
+    uint32_t armed;
+    /** Pending timers cancelled or re-armed before their expiry */
+    uint32_t cancelled;
+    /** Timers currently pending */
+    uint32_t pending;
+};
+
+/**
+ * @brief Prepare a timer, it is left disarmed
+ * @param timer Timer to initialize
+ * @param callback Function called on expiry, from the work queue
+ * @param arg Argument given to the callback
+ */
+void timer_wheel_setup(struct wheel_timer *timer,
+                       timer_wheel_callback_t callback, void *arg);
+
+/**
+ * @brief Arm or re-arm a timer
+ *
+ * A pending timer is moved to its new expiry, the callback runs once.
+ *
+ * @param timer Timer prepared with timer_wheel_setup()
+ * @param ms Delay in milliseconds, rounded up to the next tick
+ */
+void timer_wheel_arm(struct wheel_timer *timer, uint32_t ms);
+
+/**
+ * @brief Disarm a timer
+ *
+ * The callback may still be running on the work queue when this returns.
+ *
+ * @param timer Timer prepared with timer_wheel_setup()
+ */
+void timer_wheel_cancel(struct wheel_timer *timer);
+
+/**
+ * @brief Check whether a timer is armed and has not expired yet
+ * @param timer Timer prepared with timer_wheel_setup()
+ * @return true if the callback is still to be called
+ */
+bool timer_wheel_pending(const struct wheel_timer *timer);
+
+void timer_wheel_get_stats(struct timer_wheel_stats *stats);
+
+#ifdef CONFIG_ARA_TIMER_WHEEL_STATS
+
+/**
+ * @brief Register the statistics device
+ * @return 0 on success, negative errno on error
+ */
+int timer_wheel_init(void);
+
+#else
+
+static inline int timer_wheel_init(void)
+{
+    return 0;
+}
+
+#endif /* CONFIG_ARA_TIMER_WHEEL_STATS */
+
+#endif /* FDK_COMMON_TIMER_WHEEL_H */
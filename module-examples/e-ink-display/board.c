@@ -36,6 +36,15 @@
 #include <nuttx/device_table.h>
 #include <nuttx/device_hid.h>
 
+#include "common/timer_wheel.h"
+
+#include "eink_display.h"
+#include "eink_panel_model.h"
+
+#ifdef CONFIG_ARA_EINK_BUTTON_BENCH
+int eink_button_bench(void);
+#endif
+
 static struct device devices[] = {
     {
         .type           = DEVICE_TYPE_HID_HW,
@@ -64,6 +73,20 @@ void ara_module_init(void)
 {
     lowsyslog("e-Ink-Display Module init\n");
 
+    timer_wheel_init();
+
     device_table_register(&module_device_table);
     module_driver_register();
+
+    if (eink_display_init()) {
+        lowsyslog("e-Ink-Display: no panel\n");
+    }
+
+#ifdef CONFIG_ARA_EINK_PANEL_MODEL
+    eink_panel_model_bench();
+#endif
+
+#ifdef CONFIG_ARA_EINK_BUTTON_BENCH
+    eink_button_bench();
+#endif
 }
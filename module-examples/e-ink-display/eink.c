@@ -29,72 +29,422 @@
  */
 
 #include <stddef.h>
+#include <stdio.h>
 #include <string.h>
 #include <errno.h>
+#include <syslog.h>
+#include <unistd.h>
 
+#include <nuttx/config.h>
 #include <nuttx/lib.h>
 #include <nuttx/kmalloc.h>
 #include <nuttx/gpio.h>
 #include <nuttx/clock.h>
 #include <nuttx/device_hid.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/util.h>
+#include <nuttx/wqueue.h>
+
+#include <arch/irq.h>
+
+#include "common/bench.h"
+#include "common/cycle_counter.h"
+#include "common/timer_wheel.h"
 
-#define MAX_IO_INPUT            2       /* two buttons for this module */
-#define GPIO_KBDPAGEUP          0
-#define GPIO_KBDPAGEDOWN        9
 #define KEYCODE_PAGEUP          0x4B    /* KEY_PAGEUP */
 #define KEYCODE_PAGEDOWN        0x4E    /* KEY_PAGEDOWN */
 #define DEFAULT_MODIFIER        0
 
-#define DEBOUNCE_TIMEING        25      /* 250ms (1 SysTick = 10ms) */
-#define COMMAND_INTERVAL        1000    /* 1ms */
-
 #define VENDORID                0x18D1  /* need discussion */
 #define PRODUCTID               0x1234  /* need discussion */
 
-#define HID_REPORT_DESC_LEN     35
+#define HID_REPORT_DESC_LEN     43
+
+#define MAX_REPORT_KEYS         6       /* 6-key rollover */
+#define KEYCODE_ERR_ROLLOVER    0x01    /* more keys pressed than reported */
+
+/* Changes merged into one report: one system tick, the shortest delay */
+#define REPORT_COALESCE_MS      10
+#define REPORT_RETRY_MS         20
+#define REPORT_QUEUE_DEPTH      4
+
+/*
+ * Key press latency statistics are opt-in: add CONFIG_ARA_EINK_LATENCY=y to
+ * the module config and cat LATENCY_DEVPATH from NSH. Writing anything to it
+ * clears the statistics. Histogram bucket n counts [2^n, 2^(n+1)) us.
+ *
+ * The timestamps come from the cycle counter, so stages shorter than the
+ * 10 ms system tick are resolved to the microsecond.
+ */
+#define LATENCY_DEVPATH         "/dev/einklat"
+#define LATENCY_HIST_BUCKETS    20
+/* Longest line: "H 65535 report", 1 + 20 counters of 10 digits, "\n" */
+#define LATENCY_LINE_LEN        (14 + (1 + LATENCY_HIST_BUCKETS) * 11 + 2)
+
+/*
+ * Add CONFIG_ARA_EINK_BUTTON_BENCH=y to the module config to run the button
+ * debounce against a fake GPIO line at boot: edge sequences are injected into
+ * btn_software_debounce() and the reports confirmed by the debounce timer are
+ * checked against the expected ones.
+ */
+#define BUTTON_BENCH_DEBOUNCE_MS    50
+#define BUTTON_BENCH_MAX_EDGES      8
+
+/*
+ * The buttons are debounced without a thread of their own, with one timer
+ * wheel expiry per debounce window however much the contact bounces. Neither
+ * the RAM saved nor the wake-ups per press have been measured on a module yet.
+ * To measure them, add CONFIG_ARA_TIMER_WHEEL_STATS=y, clear
+ * TIMER_WHEEL_DEVPATH, press a button N times with the panel idle and compare
+ * the wakeups and expired counts with 2N (press and release), and compare the
+ * NSH free and ps output with the thread-based debounce it replaced.
+ */
 
 /**
- * Private information for buttons
+ * Stages of a key press, measured between the timestamps of the button path
  */
-struct button_info {
-    /** Chain to button linking list. */
-    struct list_head list;
+enum latency_stage {
+    /** First edge to last edge: how long the contact bounced */
+    LATENCY_BOUNCE,
+    /** Last edge plus debounce time to confirmation: timer lateness */
+    LATENCY_SCHED,
+    /** Confirmation to event_callback return: coalescing and greybus */
+    LATENCY_REPORT,
+    /** First edge to event_callback return */
+    LATENCY_TOTAL,
+    LATENCY_NUM_STAGES,
+};
 
+/**
+ * Board description of a button
+ */
+struct button_desc {
     /** Connected GPIO number */
     uint16_t gpio;
 
-    /** Latest valid keyboard interrupt time */
-    uint32_t last_activetime;
+    /** The keycode for this button returned */
+    uint8_t keycode;
 
-    /** Latest valid keyboard state */
-    uint8_t last_keystate;
+    /** GPIO level when the button is pressed */
+    uint8_t active_high;
 
-    /** The keycode for this button returned */
-    uint8_t Keycode;
+    /** Time the GPIO must be stable before a change is reported */
+    uint16_t debounce_ms;
+};
 
-    /** Notifying debounce count start */
-    sem_t active_debounce;
+/**
+ * Buttons of this module, any number of them can be listed
+ */
+static const struct button_desc eink_buttons[] = {
+    {
+        .gpio           = 0,
+        .keycode        = KEYCODE_PAGEUP,
+        .active_high    = 1,
+        .debounce_ms    = 250,
+    },
+    {
+        .gpio           = 9,
+        .keycode        = KEYCODE_PAGEDOWN,
+        .active_high    = 1,
+        .debounce_ms    = 250,
+    },
+};
 
-    /** Handler for debounce count thread */
-    pthread_t pthread_handler;
+/**
+ * Private information for buttons
+ */
+struct button_info {
+    /** Board description of the button */
+    const struct button_desc *desc;
+
+    /** GPIO level at the latest edge */
+    uint8_t last_keystate;
 
-    /** inform the thread should be terminated */
-    uint8_t thread_stop;
+    /** Pressed state last reported to the host */
+    uint8_t reported_pressed;
+
+    /** Debounce timer, restarted on every edge */
+    struct wheel_timer debounce_timer;
+
+#ifdef CONFIG_ARA_EINK_LATENCY
+    /** Cycle counter at IRQ entry, debounce start and confirmation */
+    uint32_t irq_time;
+    uint32_t arm_time;
+    uint32_t confirm_time;
+    /** Start of the change waiting for its report */
+    uint32_t change_time;
+    bool in_burst;
+    bool report_pending;
+
+    uint32_t edges;
+    uint32_t changes;
+    /** Bursts that settled back to the reported state */
+    uint32_t glitches;
+    uint32_t hist[LATENCY_NUM_STAGES][LATENCY_HIST_BUCKETS];
+    uint32_t max_us[LATENCY_NUM_STAGES];
+#endif
 };
 
 /**
  * Report data for HID Button
  */
 struct hid_kbd_data {
-    /** modifier key: bit[0-4]: NumLock, CapsLock, ScrollLock, Compose, KANA */
+    /** modifier key: bit[0-7]: Left/Right Control, Shift, Alt, GUI */
     uint8_t modifier;
 
-    /** keycode, 0 ~ 101 key value  */
-    uint8_t keycode;
+    /** reserved, always 0 */
+    uint8_t reserved;
+
+    /** keycodes of the pressed keys, 0 ~ 101 key value, unused slots 0 */
+    uint8_t keycode[MAX_REPORT_KEYS];
 } __packed;
 
+/**
+ * Reports waiting for the HID core, oldest first
+ */
+struct report_queue {
+    struct hid_kbd_data reports[REPORT_QUEUE_DEPTH];
+    unsigned int head;
+    unsigned int count;
+
+    /** Latest report queued, to drop reports that change nothing */
+    struct hid_kbd_data last;
+
+    /** Coalescing window and retry timer */
+    struct work_s work;
+    bool pending;
+};
+
 static struct device *eink_dev = NULL;
 
+/** State of each entry of eink_buttons[] */
+static struct button_info *eink_btns;
+
+/** Buttons indexed by GPIO number, for constant time IRQ dispatch */
+static struct button_info **eink_btn_by_gpio;
+static unsigned int eink_btn_gpio_count;
+
+/** Debounced state of the buttons, bit n for eink_buttons[n] */
+static volatile uint32_t eink_pressed;
+
+static struct report_queue eink_report_queue;
+
+#ifdef CONFIG_ARA_EINK_BUTTON_BENCH
+/** Button debounced by the bench, and the level of its fake GPIO line */
+static const struct button_desc eink_bench_button = {
+    .gpio           = 0xffff,
+    .active_high    = 1,
+    .debounce_ms    = BUTTON_BENCH_DEBOUNCE_MS,
+};
+static volatile uint8_t eink_bench_level;
+
+/** Reports confirmed for the bench button, and the tick of the last one */
+static volatile unsigned int eink_bench_changes;
+static volatile uint32_t eink_bench_confirmed;
+#endif
+
+#ifdef CONFIG_ARA_EINK_LATENCY
+static const char *const latency_stage_names[LATENCY_NUM_STAGES] = {
+    "bounce", "sched", "report", "total",
+};
+
+static inline uint32_t latency_now(void)
+{
+    return cycle_counter_read();
+}
+
+static void latency_record(struct button_info *btn_info,
+                           enum latency_stage stage, uint32_t us)
+{
+    unsigned int bucket = 0;
+    uint32_t value = us;
+
+    while (value >>= 1) {
+        bucket++;
+    }
+
+    if (bucket >= LATENCY_HIST_BUCKETS) {
+        bucket = LATENCY_HIST_BUCKETS - 1;
+    }
+
+    btn_info->hist[stage][bucket]++;
+    if (us > btn_info->max_us[stage]) {
+        btn_info->max_us[stage] = us;
+    }
+}
+
+/* Called from the interrupt handler on every edge */
+static void latency_edge(struct button_info *btn_info, bool armed)
+{
+    uint32_t now = latency_now();
+
+    btn_info->edges++;
+
+    if (!btn_info->in_burst) {
+        btn_info->in_burst = true;
+        btn_info->irq_time = now;
+    }
+
+    if (armed) {
+        btn_info->arm_time = now;
+    }
+}
+
+/* Called when the debounce timer expires on a stable state */
+static void latency_confirm(struct button_info *btn_info, bool changed)
+{
+    uint32_t now = latency_now();
+    uint32_t debounce_us = btn_info->desc->debounce_ms * 1000;
+    uint32_t late = cycle_counter_to_us(now - btn_info->arm_time);
+
+    btn_info->in_burst = false;
+
+    if (!changed) {
+        btn_info->glitches++;
+        return;
+    }
+
+    btn_info->changes++;
+    btn_info->confirm_time = now;
+    btn_info->change_time = btn_info->irq_time;
+    btn_info->report_pending = true;
+
+    latency_record(btn_info, LATENCY_BOUNCE,
+                   cycle_counter_to_us(btn_info->arm_time -
+                                       btn_info->irq_time));
+    latency_record(btn_info, LATENCY_SCHED,
+                   late > debounce_us ? late - debounce_us : 0);
+}
+
+/* Called once every queued report has been taken by event_callback */
+static void latency_reported(void)
+{
+    struct button_info *btn_info;
+    uint32_t now = latency_now();
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_SIZE(eink_buttons); i++) {
+        btn_info = &eink_btns[i];
+        if (!btn_info->report_pending) {
+            continue;
+        }
+
+        btn_info->report_pending = false;
+        latency_record(btn_info, LATENCY_REPORT,
+                       cycle_counter_to_us(now - btn_info->confirm_time));
+        latency_record(btn_info, LATENCY_TOTAL,
+                       cycle_counter_to_us(now - btn_info->change_time));
+    }
+}
+
+/**
+ * @brief Format one line of the statistics dump
+ *
+ * Each button gets a summary line followed by one histogram line per stage.
+ *
+ * @param index Line index
+ * @param line Output buffer
+ * @param size Size of the output buffer
+ * @return number of characters written, 0 past the last line
+ */
+static int latency_format(unsigned int index, char *line, size_t size)
+{
+    struct button_info btn_info;
+    unsigned int button = index / (LATENCY_NUM_STAGES + 1);
+    unsigned int stage = index % (LATENCY_NUM_STAGES + 1);
+    irqstate_t flags;
+    unsigned int i;
+    int len;
+
+    flags = irqsave();
+    if (!eink_btns || button >= ARRAY_SIZE(eink_buttons)) {
+        irqrestore(flags);
+        return 0;
+    }
+    btn_info = eink_btns[button];
+    irqrestore(flags);
+
+    if (!stage) {
+        return snprintf(line, size, "K %u 0x%02x %u %u %u\n",
+                        eink_buttons[button].gpio,
+                        eink_buttons[button].keycode, btn_info.edges,
+                        btn_info.changes, btn_info.glitches);
+    }
+
+    stage--;
+    len = snprintf(line, size, "H %u %s %u", eink_buttons[button].gpio,
+                   latency_stage_names[stage], btn_info.max_us[stage]);
+    for (i = 0; i < LATENCY_HIST_BUCKETS && len < (int)size - 1; i++) {
+        len += snprintf(line + len, size - len, " %u",
+                        btn_info.hist[stage][i]);
+    }
+
+    if (len < (int)size - 1) {
+        len += snprintf(line + len, size - len, "\n");
+    }
+
+    return MIN(len, (int)size - 1);
+}
+
+static ssize_t latency_read(struct file *filep, char *buffer, size_t buflen)
+{
+    char line[LATENCY_LINE_LEN];
+    size_t nread = 0;
+    int len;
+
+    while (nread < buflen) {
+        len = latency_format(filep->f_pos, line, sizeof(line));
+        if (len <= 0 || nread + len > buflen) {
+            break;
+        }
+
+        memcpy(buffer + nread, line, len);
+        nread += len;
+        filep->f_pos++;
+    }
+
+    return nread;
+}
+
+static ssize_t latency_write(struct file *filep, const char *buffer,
+                             size_t buflen)
+{
+    struct button_info *btn_info;
+    irqstate_t flags;
+    unsigned int i;
+
+    flags = irqsave();
+    for (i = 0; eink_btns && i < ARRAY_SIZE(eink_buttons); i++) {
+        btn_info = &eink_btns[i];
+        btn_info->edges = 0;
+        btn_info->changes = 0;
+        btn_info->glitches = 0;
+        memset(btn_info->hist, 0, sizeof(btn_info->hist));
+        memset(btn_info->max_us, 0, sizeof(btn_info->max_us));
+    }
+    irqrestore(flags);
+
+    return buflen;
+}
+
+static const struct file_operations latency_fops = {
+    .read   = latency_read,
+    .write  = latency_write,
+};
+#else
+static inline void latency_edge(struct button_info *btn_info, bool armed)
+{
+}
+
+static inline void latency_confirm(struct button_info *btn_info, bool changed)
+{
+}
+
+static inline void latency_reported(void)
+{
+}
+#endif /* CONFIG_ARA_EINK_LATENCY */
+
 /**
  * Keyboard HID Device Descriptor
  */
@@ -107,12 +457,13 @@ struct hid_descriptor btn_dev_desc = {
     0x00, /* no country code */
 };
 
-// Input report - 4 bytes
+// Input report - 8 bytes
 //
 // Byte |  D7    D6    D5    D4     D3        D2        D1      D0
 // -----+-------------------------------------------------------------------
-//  0   |  0     0     0   KANA  Compose  ScrollLock CapsLock NumLock
-//  1   |                         Keycode
+//  0   | RGUI  RAlt RShift RCtrl  LGUI      LAlt     LShift   LCtrl
+//  1   |                         Reserved
+//  2-7 |                   Keycode 1 - Keycode 6
 //
 // Output report - n/a
 //
@@ -136,6 +487,10 @@ uint8_t btn_report_desc[HID_REPORT_DESC_LEN] = {
     0x81, 0x02,     /*   INPUT (Data,Var,Abs) */
     0x95, 0x01,     /*   REPORT_COUNT (1) */
     0x75, 0x08,     /*   REPORT_SIZE (8) */
+    0x81, 0x01,     /*   INPUT (Cnst,Ary,Abs) */
+    0x95, 0x06,     /*   REPORT_COUNT (6) */
+    0x75, 0x08,     /*   REPORT_SIZE (8) */
+    0x15, 0x00,     /*   LOGICAL_MINIMUM (0) */
     0x25, 0x65,     /*   LOGICAL_MAXIMUM (101) */
     0x19, 0x00,     /*   USAGE_MINIMUM (Reserved (no event)) */
     0x29, 0x65,     /*   USAGE_MAXIMUM (Keyboard Application) */
@@ -154,166 +509,318 @@ struct hid_size_info btn_sizeinfo[] =
      */
     { .id = 0,
       .reports = {
-          .size = { 2, 0, 0 }
+          .size = { sizeof(struct hid_kbd_data), 0, 0 }
        }
     },
 };
 
 /**
- * @brief Get eInk private data
+ * @brief Build a report from the debounced button state
  *
- * @param dev Pointer to structure of device data
- * @param gpio The button of gpio number
- * @return Return button_info struct pointer or NULL for not find.
+ * @param kbd Report to fill
  */
-static struct button_info *eink_get_info(struct device *dev, uint16_t gpio)
+static void eink_build_report(struct hid_kbd_data *kbd)
 {
-    struct hid_info *info = device_get_private(dev);
-    struct button_info *dev_info = NULL;
-    struct list_head *iter;
-
-    list_foreach(&info->device_list, iter) {
-        dev_info = list_entry(iter, struct button_info, list);
-        if (dev_info->gpio == gpio) {
-            return dev_info;
+    uint32_t pressed = eink_pressed;
+    unsigned int count = 0;
+    unsigned int i;
+
+    memset(kbd, 0, sizeof(*kbd));
+
+    for (i = 0; i < ARRAY_SIZE(eink_buttons) && pressed; i++, pressed >>= 1) {
+        if (!(pressed & 1)) {
+            continue;
+        }
+
+        if (count == MAX_REPORT_KEYS) {
+            memset(kbd->keycode, KEYCODE_ERR_ROLLOVER, sizeof(kbd->keycode));
+            return;
         }
-    }
 
-    return NULL;
+        kbd->keycode[count++] = eink_buttons[i].keycode;
+    }
 }
 
 /**
- * @brief Routine for all keys debounce check
+ * @brief Queue a report for the HID core
  *
- * @param dev Pointer to structure of device data
- * @param btn_info Pointer to structure of button_info
+ * When the queue is full the newest entry is replaced: it is a key state,
+ * not an event, so the new report carries everything the old one did.
+ *
+ * @param queue Pointer to structure of report_queue
+ * @param kbd Report to queue
  */
-static void btn_debounce_check_loop(struct device *dev,
-                                    struct button_info *btn_info)
+static void eink_queue_report(struct report_queue *queue,
+                              const struct hid_kbd_data *kbd)
 {
-    struct hid_info *info = device_get_private(dev);
-    struct hid_kbd_data kbd;
-    uint32_t elapsed = 0, cur_time = 0;
-    uint8_t value = 0;
-
-    for (;;) {
-        /* verify key status is still same during counting */
-        value = gpio_get_value(btn_info->gpio);
-        if (value != btn_info->last_keystate) {
-            btn_info->last_keystate = value;
-            break;
-        }
+    unsigned int tail;
 
-        /* count > 250mS routine */
-        cur_time = clock_systimer();
-        if (cur_time < btn_info->last_activetime) {
-            elapsed = cur_time + (0xFFFFFFFF - btn_info->last_activetime) + 1;
-            /* Ticks overflow, reset last_activatime to current ticks */
-            btn_info->last_activetime = cur_time;
-        } else {
-            elapsed = cur_time - btn_info->last_activetime;
-        }
+    if (!memcmp(&queue->last, kbd, sizeof(*kbd))) {
+        return;
+    }
 
-        if (elapsed > DEBOUNCE_TIMEING) {
-            kbd.modifier = 0;
-            kbd.keycode = btn_info->last_keystate ? btn_info->Keycode : 0;
+    queue->last = *kbd;
 
-            if (info->event_callback) {
-                info->event_callback(dev, HID_INPUT_REPORT, (uint8_t*)&kbd,
-                                     sizeof(struct hid_kbd_data));
-            }
-            break;
-        } else {
-            usleep(COMMAND_INTERVAL);
-        }
+    if (queue->count == REPORT_QUEUE_DEPTH) {
+        tail = (queue->head + queue->count - 1) % REPORT_QUEUE_DEPTH;
+    } else {
+        tail = (queue->head + queue->count) % REPORT_QUEUE_DEPTH;
+        queue->count++;
     }
+
+    queue->reports[tail] = *kbd;
 }
 
 /**
- * @brief Debounce check thread for PAGEDOWN
+ * @brief Close the coalescing window and send the queued reports
  *
- * @param dev Pointer to structure of device data
+ * Reports go out in order. One the HID core cannot take stays queued and is
+ * retried after REPORT_RETRY_MS.
+ *
+ * @param data Unused
  */
-static void *btn_pgdn_bebounce_thread(void *data)
+static void eink_report_worker(void *data)
 {
     struct device *dev = eink_dev;
-    struct button_info *btn_info = (struct button_info *) data;
+    struct report_queue *queue = &eink_report_queue;
+    struct hid_info *info;
+    struct hid_kbd_data kbd;
+    int ret;
 
-    if (!btn_info) {
-        return NULL;
+    queue->pending = false;
+
+    if (!dev || !device_get_private(dev)) {
+        return;
     }
 
-    while (1) {
-        sem_wait(&btn_info->active_debounce);
+    info = device_get_private(dev);
 
-        if (btn_info->thread_stop) {
-            break;
+    eink_build_report(&kbd);
+    eink_queue_report(queue, &kbd);
+
+    while (queue->count && info->event_callback) {
+        ret = info->event_callback(dev, HID_INPUT_REPORT,
+                                   (uint8_t *)&queue->reports[queue->head],
+                                   sizeof(struct hid_kbd_data));
+        if (ret) {
+            queue->pending = true;
+            work_queue(HPWORK, &queue->work, eink_report_worker, NULL,
+                       MSEC2TICK(REPORT_RETRY_MS));
+            return;
         }
 
-        btn_debounce_check_loop(dev, btn_info);
+        queue->head = (queue->head + 1) % REPORT_QUEUE_DEPTH;
+        queue->count--;
+    }
+
+    if (!queue->count) {
+        latency_reported();
+    }
+}
+
+/**
+ * @brief Read the GPIO line of a button
+ * @param btn_info Pointer to structure of button_info
+ * @return the line level
+ */
+static uint8_t btn_get_value(struct button_info *btn_info)
+{
+#ifdef CONFIG_ARA_EINK_BUTTON_BENCH
+    if (btn_info->desc == &eink_bench_button) {
+        return eink_bench_level;
     }
+#endif
 
-    return NULL;
+    return gpio_get_value(btn_info->desc->gpio);
 }
 
 /**
- * @brief Debounce check thread for PAGEUP
+ * @brief Debounce timer expiry
  *
- * @param dev Pointer to structure of device data
+ * Runs once a button has seen no edge for its debounce time, and reports its
+ * state if it differs from the last report.
+ *
+ * @param data Pointer to structure of button_info
  */
-static void *btn_pgup_bebounce_thread(void *data)
+static void btn_debounce_worker(void *data)
 {
-    struct device *dev = eink_dev;
-    struct button_info *btn_info = (struct button_info *) data;
+    struct button_info *btn_info = data;
+    irqstate_t flags;
+    uint8_t value;
+    uint8_t pressed;
+
+    /* An edge missed while the interrupt was masked restarts the period. */
+    flags = irqsave();
+    value = btn_get_value(btn_info);
+    if (value != btn_info->last_keystate) {
+        btn_info->last_keystate = value;
+        timer_wheel_arm(&btn_info->debounce_timer,
+                        btn_info->desc->debounce_ms);
+        irqrestore(flags);
+        return;
+    }
+    irqrestore(flags);
 
-    if (!btn_info) {
-        return NULL;
+    pressed = value == btn_info->desc->active_high;
+    latency_confirm(btn_info, pressed != btn_info->reported_pressed);
+    if (pressed == btn_info->reported_pressed) {
+        return;
     }
 
-    while (1) {
-        sem_wait(&btn_info->active_debounce);
+    btn_info->reported_pressed = pressed;
 
-        if (btn_info->thread_stop) {
-            break;
-        }
+#ifdef CONFIG_ARA_EINK_BUTTON_BENCH
+    if (btn_info->desc == &eink_bench_button) {
+        eink_bench_changes++;
+        eink_bench_confirmed = clock_systimer();
+        return;
+    }
+#endif
 
-        btn_debounce_check_loop(dev, btn_info);
+    if (pressed) {
+        eink_pressed |= 1 << (btn_info - eink_btns);
+    } else {
+        eink_pressed &= ~(1 << (btn_info - eink_btns));
     }
 
-    return NULL;
+    /* Open a coalescing window, later changes within it share the report. */
+    if (!eink_report_queue.pending) {
+        eink_report_queue.pending = true;
+        work_queue(HPWORK, &eink_report_queue.work, eink_report_worker, NULL,
+                   MSEC2TICK(REPORT_COALESCE_MS));
+    }
 }
 
 /**
  * @brief Enable GPIO signal debounce filter
  *
- * @param dev Pointer to structure of device data
+ * Called from the interrupt handler, with the button interrupt masked.
+ *
  * @param btn_info Pointer to structure of button_info
- * @param irq IRQ number.
  * @return 0 on success, negative errno on error
  */
-static int btn_software_debounce(struct device *dev,
-                                 struct button_info *btn_info, int irq)
+static int btn_software_debounce(struct button_info *btn_info)
 {
     uint8_t value = 0;
+    bool armed = false;
 
-    gpio_irq_mask(irq);
-
-    value = gpio_get_value(btn_info->gpio);
+    value = btn_get_value(btn_info);
 
     /* check whether the key state change or not */
     if (btn_info->last_keystate != value) {
         btn_info->last_keystate = value;
 
-        /* Enable counting thread */
-        btn_info->last_activetime = clock_systimer();
-        sem_post(&btn_info->active_debounce);
+        /* Restart the debounce period from this edge */
+        timer_wheel_arm(&btn_info->debounce_timer,
+                        btn_info->desc->debounce_ms);
+        armed = true;
     }
 
-    gpio_irq_unmask(irq);
+    latency_edge(btn_info, armed);
 
     return 0;
 }
 
+#ifdef CONFIG_ARA_EINK_BUTTON_BENCH
+/**
+ * @brief Edge sequence injected on the bench button
+ */
+struct button_bench_scenario {
+    const char *name;
+    /** Delay before each edge in ms, the line toggles on every edge */
+    uint16_t gaps_ms[BUTTON_BENCH_MAX_EDGES];
+    unsigned int num_edges;
+    /** Edges raised while the interrupt was masked, bit n for edge n */
+    uint8_t masked;
+    /** Reports expected once the line has settled */
+    unsigned int changes;
+};
+
+/* Delays are rounded up to the tick, bounces stay well within the debounce */
+static const struct button_bench_scenario button_bench_scenarios[] = {
+    { "press",          { 0 }, 1, 0x00, 1 },
+    { "bouncy-press",   { 0, 10, 10, 20, 10 }, 5, 0x00, 1 },
+    { "glitch",         { 0, 10 }, 2, 0x00, 0 },
+    { "press-release",  { 0, 150 }, 2, 0x00, 2 },
+    { "bouncy-release", { 0, 150, 10, 10 }, 4, 0x00, 2 },
+    { "masked-release", { 0, 10 }, 2, 0x02, 0 },
+};
+
+/**
+ * @brief Run the debounce against edge sequences on a fake GPIO line
+ *
+ * A report must be confirmed within the debounce time of the last edge, plus
+ * one tick for the timer wheel rounding and one for the tick in progress.
+ *
+ * @return 0 if all scenarios behave, -EINVAL otherwise
+ */
+int eink_button_bench(void)
+{
+    static struct button_info btn_info;
+    const struct button_bench_scenario *scenario;
+    uint32_t max_ticks;
+    uint32_t last_edge;
+    uint32_t ticks;
+    unsigned int failures = 0;
+    unsigned int i, j;
+    irqstate_t flags;
+    bool regression;
+
+    memset(&btn_info, 0, sizeof(btn_info));
+    btn_info.desc = &eink_bench_button;
+    timer_wheel_setup(&btn_info.debounce_timer, btn_debounce_worker,
+                      &btn_info);
+
+    max_ticks = MSEC2TICK(BUTTON_BENCH_DEBOUNCE_MS) + 2;
+
+    for (i = 0; i < ARRAY_SIZE(button_bench_scenarios); i++) {
+        scenario = &button_bench_scenarios[i];
+
+        eink_bench_level = 0;
+        btn_info.last_keystate = 0;
+        btn_info.reported_pressed = 0;
+        eink_bench_changes = 0;
+        last_edge = 0;
+
+        for (j = 0; j < scenario->num_edges; j++) {
+            if (scenario->gaps_ms[j]) {
+                usleep(scenario->gaps_ms[j] * 1000);
+            }
+
+            flags = irqsave();
+            eink_bench_level = !eink_bench_level;
+            if (!(scenario->masked & (1 << j))) {
+                btn_software_debounce(&btn_info);
+            }
+            last_edge = clock_systimer();
+            irqrestore(flags);
+        }
+
+        /* A masked edge is only seen at expiry, and restarts the period. */
+        usleep((2 * BUTTON_BENCH_DEBOUNCE_MS + 50) * 1000);
+        timer_wheel_cancel(&btn_info.debounce_timer);
+
+        ticks = eink_bench_changes ? eink_bench_confirmed - last_edge : 0;
+        regression = eink_bench_changes != scenario->changes ||
+                     ticks > max_ticks;
+        if (regression) {
+            failures++;
+        }
+
+        lowsyslog("eink-buttons: %s: %u edges, %u reports (%u expected), "
+                  "last confirmed %u ticks after the last edge (%u max): "
+                  "%s\n", scenario->name, scenario->num_edges,
+                  eink_bench_changes, scenario->changes, ticks, max_ticks,
+                  bench_verdict(false, regression));
+    }
+
+    bench_summary("eink-buttons", "scenarios",
+                  ARRAY_SIZE(button_bench_scenarios), failures);
+
+    return failures ? -EINVAL : 0;
+}
+#endif /* CONFIG_ARA_EINK_BUTTON_BENCH */
+
 /**
  * @brief HID device keys interrupt routing
  *
@@ -331,12 +838,18 @@ static int eink_handle_btn_irq_event(int irq, FAR void *context)
         return ERROR;
     }
 
-    btn_info = eink_get_info(dev, irq);
+    if ((unsigned int)irq >= eink_btn_gpio_count) {
+        return ERROR;
+    }
+
+    btn_info = eink_btn_by_gpio[irq];
     if (!btn_info) {
         return ERROR;
     }
 
-    ret = btn_software_debounce(dev, btn_info, irq);
+    gpio_irq_mask(irq);
+    ret = btn_software_debounce(btn_info);
+    gpio_irq_unmask(irq);
     if (ret) {
         return -EAGAIN;
     }
@@ -366,8 +879,7 @@ static int eink_get_input_report(struct device *dev, uint8_t report_id,
             }
             /* get keyboard data and return to upper layer */
             kbd = (struct hid_kbd_data *)data;
-            kbd->modifier = 0;
-            kbd->keycode = 0;
+            eink_build_report(kbd);
         } else {
             /* No multiple Report ID in this application. */
             ret = -EIO;
@@ -380,101 +892,80 @@ static int eink_get_input_report(struct device *dev, uint8_t report_id,
 }
 
 /**
- * @brief Specific GPIO deinitialize and release resource
+ * @brief Specific GPIO deinitialize
  *
- * @param dev Pointer to structure of button_info
+ * @param btn_info Pointer to structure of button_info
  */
 static void eink_gpio_deinit(struct button_info *btn_info)
 {
-    if (btn_info->pthread_handler != (pthread_t)0) {
-        btn_info->thread_stop = 1;
-        sem_post(&btn_info->active_debounce);
-        pthread_join(btn_info->pthread_handler, NULL);
-    }
-
-    sem_destroy(&btn_info->active_debounce);
-    gpio_irq_mask(btn_info->gpio);
-    gpio_deactivate(btn_info->gpio);
-    list_del(&btn_info->list);
-    free(btn_info);
+    gpio_irq_mask(btn_info->desc->gpio);
+    timer_wheel_cancel(&btn_info->debounce_timer);
+    gpio_deactivate(btn_info->desc->gpio);
+    eink_btn_by_gpio[btn_info->desc->gpio] = NULL;
+    btn_info->desc = NULL;
 }
 
 /**
  * @brief GPIOs deinitialize and release resources
- *
- * @param dev Pointer to structure of device data
  */
-static void eink_gpios_deinit(struct device *dev)
+static void eink_gpios_deinit(void)
 {
-    struct button_info *btn_info = NULL;
+    unsigned int i;
 
-    btn_info = eink_get_info(dev, GPIO_KBDPAGEUP);
-    if (btn_info)
-        eink_gpio_deinit(btn_info);
+    if (!eink_btns) {
+        return;
+    }
 
-    btn_info = eink_get_info(dev, GPIO_KBDPAGEDOWN);
-    if (btn_info)
-        eink_gpio_deinit(btn_info);
+    for (i = 0; i < ARRAY_SIZE(eink_buttons); i++) {
+        if (eink_btns[i].desc) {
+            eink_gpio_deinit(&eink_btns[i]);
+        }
+    }
 
-    return;
+    work_cancel(HPWORK, &eink_report_queue.work);
+    memset(&eink_report_queue, 0, sizeof(eink_report_queue));
+    eink_pressed = 0;
+
+    free(eink_btn_by_gpio);
+    free(eink_btns);
+    eink_btn_by_gpio = NULL;
+    eink_btns = NULL;
+    eink_btn_gpio_count = 0;
 }
 
 /**
- * @brief Initialze buttons GPIO
+ * @brief Initialze a button GPIO
  *
- * @param dev Pointer to structure of device data
- * @param gpio The gpio number for initialize
+ * @param btn_info Pointer to structure of button_info
+ * @param desc Board description of the button
+ * @return 0 on success, negative errno on error
  */
-static int eink_gpio_init(struct device *dev, uint16_t gpio)
+static int eink_gpio_init(struct button_info *btn_info,
+                          const struct button_desc *desc)
 {
-    struct hid_info *info = device_get_private(dev);
-    struct button_info *btn_info = NULL;
     int ret = 0;
 
-    if (gpio != GPIO_KBDPAGEUP && gpio != GPIO_KBDPAGEDOWN) {
-        return -EIO;
+    if (desc->gpio >= eink_btn_gpio_count || eink_btn_by_gpio[desc->gpio]) {
+        return -EINVAL;
     }
 
-    btn_info = zalloc(sizeof(*btn_info));
-    if (!btn_info)
-        return -ENOMEM;
-
-    btn_info->gpio = gpio;
-
-    ret = gpio_activate(gpio);
+    ret = gpio_activate(desc->gpio);
     if (ret != 0)
         return ret;
-    gpio_direction_in(gpio);
-    gpio_irq_mask(gpio);
-    gpio_irq_settriggering(gpio, IRQ_TYPE_EDGE_BOTH);
-    sem_init(&btn_info->active_debounce, 0, 0);
-    list_add(&info->device_list, &btn_info->list);
-
-    if (gpio == GPIO_KBDPAGEUP) {
-        btn_info->Keycode = KEYCODE_PAGEUP;
-        ret = pthread_create(&btn_info->pthread_handler, NULL,
-                             btn_pgup_bebounce_thread, btn_info);
-        if (ret) {
-            goto err_gpio_init;
-        }
-        gpio_irq_attach(gpio, eink_handle_btn_irq_event);
 
-    } else if (gpio == GPIO_KBDPAGEDOWN) {
-        btn_info->Keycode = KEYCODE_PAGEDOWN;
-        ret = pthread_create(&btn_info->pthread_handler, NULL,
-                             btn_pgdn_bebounce_thread, btn_info);
-        if (ret) {
-            goto err_gpio_init;
-        }
-        gpio_irq_attach(gpio, eink_handle_btn_irq_event);
-    } else {
-        goto err_gpio_init;
-    }
+    btn_info->desc = desc;
+    timer_wheel_setup(&btn_info->debounce_timer, btn_debounce_worker,
+                      btn_info);
 
-    return ret;
+    gpio_direction_in(desc->gpio);
+    gpio_irq_mask(desc->gpio);
+    gpio_irq_settriggering(desc->gpio, IRQ_TYPE_EDGE_BOTH);
+    btn_info->last_keystate = gpio_get_value(desc->gpio);
+    btn_info->reported_pressed = 0;
+
+    eink_btn_by_gpio[desc->gpio] = btn_info;
+    gpio_irq_attach(desc->gpio, eink_handle_btn_irq_event);
 
-err_gpio_init:
-    eink_gpios_deinit(dev);
     return ret;
 }
 
@@ -488,21 +979,34 @@ err_gpio_init:
  */
 static int eink_hw_initialize(struct device *dev, struct hid_info *dev_info)
 {
+    unsigned int i;
     int ret = 0;
 
-    /* initialize GPIO pin */
-    if (GPIO_KBDPAGEUP >= gpio_line_count() ||
-        GPIO_KBDPAGEDOWN >= gpio_line_count()) {
-        return -EIO;
+    if (ARRAY_SIZE(eink_buttons) > sizeof(eink_pressed) * 8) {
+        return -EINVAL;
     }
 
-    ret = eink_gpio_init(dev, GPIO_KBDPAGEUP);
-    if (ret)
-        return ret;
+    /* Build the GPIO indexed lookup used by the interrupt handler. */
+    eink_btn_gpio_count = gpio_line_count();
+    eink_btn_by_gpio = zalloc(eink_btn_gpio_count *
+                              sizeof(*eink_btn_by_gpio));
+    eink_btns = zalloc(ARRAY_SIZE(eink_buttons) * sizeof(*eink_btns));
+    if (!eink_btn_by_gpio || !eink_btns) {
+        ret = -ENOMEM;
+        goto err_gpios_init;
+    }
 
-    ret = eink_gpio_init(dev, GPIO_KBDPAGEDOWN);
-    if (ret)
-        return ret;
+    for (i = 0; i < ARRAY_SIZE(eink_buttons); i++) {
+        ret = eink_gpio_init(&eink_btns[i], &eink_buttons[i]);
+        if (ret)
+            goto err_gpios_init;
+    }
+
+    return 0;
+
+err_gpios_init:
+    eink_gpios_deinit();
+    return ret;
 }
 
 /**
@@ -515,20 +1019,22 @@ static int eink_hw_initialize(struct device *dev, struct hid_info *dev_info)
  */
 static int eink_hw_deinitialize(struct device *dev)
 {
-    eink_gpios_deinit(dev);
+    eink_gpios_deinit();
 
     return 0;
 }
 
 static int eink_power_set(struct device *dev, bool on)
 {
-    if (on) {
-        /* enable interrupt */
-        gpio_irq_unmask(GPIO_KBDPAGEUP);
-        gpio_irq_unmask(GPIO_KBDPAGEDOWN);
-    } else {
-        gpio_irq_mask(GPIO_KBDPAGEUP);
-        gpio_irq_mask(GPIO_KBDPAGEDOWN);
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_SIZE(eink_buttons); i++) {
+        if (on) {
+            /* enable interrupt */
+            gpio_irq_unmask(eink_buttons[i].gpio);
+        } else {
+            gpio_irq_mask(eink_buttons[i].gpio);
+        }
     }
 
     return 0;
@@ -571,6 +1077,11 @@ int hid_device_init(struct device *dev, struct hid_info *dev_info)
     dev_info->hid_dev_ops = &eink_btn_ops;
     eink_dev = dev;
 
+#ifdef CONFIG_ARA_EINK_LATENCY
+    cycle_counter_init();
+    register_driver(LATENCY_DEVPATH, &latency_fops, 0666, NULL);
+#endif
+
     return ret;
 
 }
@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <nuttx/config.h>
+
+#include "eink_convert.h"
+
+/*
+ * The kernels treat 32-bit words as two 16-bit lanes holding every other
+ * pixel, which leaves 8 bits of headroom per pixel for the additions below.
+ * Word loads go through memcpy, which the compiler turns into a single
+ * (unaligned) load on the Cortex-M3. The bridge is little endian: the
+ * leftmost pixel of a word is its low byte.
+ */
+#define LANES_LO        0x00ff00ff
+
+static const uint8_t eink_bayer[4][4] = {
+    {  0,  8,  2, 10 },
+    { 12,  4, 14,  6 },
+    {  3, 11,  1,  9 },
+    { 15,  7, 13,  5 },
+};
+
+static inline uint32_t eink_load32(const uint8_t *p)
+{
+    uint32_t word;
+
+    memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+static inline void eink_store32(uint8_t *p, uint32_t word)
+{
+    memcpy(p, &word, sizeof(word));
+}
+
+static inline uint32_t eink_rbit(uint32_t x)
+{
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+    uint32_t r;
+
+    __asm__ ("rbit %0, %1" : "=r" (r) : "r" (x));
+    return r;
+#else
+    x = ((x >> 1) & 0x55555555) | ((x & 0x55555555) << 1);
+    x = ((x >> 2) & 0x33333333) | ((x & 0x33333333) << 2);
+    x = ((x >> 4) & 0x0f0f0f0f) | ((x & 0x0f0f0f0f) << 4);
+    x = ((x >> 8) & 0x00ff00ff) | ((x & 0x00ff00ff) << 8);
+    return (x >> 16) | (x << 16);
+#endif
+}
+
+/* Per-lane thresholds, or dither offsets, of the even and odd pixels */
+static void eink_row_levels(unsigned int y, enum eink_dither dither,
+                            unsigned int flat, uint32_t *even,
+                            uint32_t *odd, bool negate)
+{
+    const uint8_t *m = eink_bayer[y & 3];
+    uint32_t level[4];
+    unsigned int i;
+
+    for (i = 0; i < 4; i++) {
+        level[i] = dither == EINK_DITHER_ORDERED ? m[i] * 16u + 8 : flat;
+        if (negate) {
+            level[i] = 256 - level[i];
+        }
+    }
+
+    *even = level[0] | (level[2] << 16);
+    *odd = level[1] | (level[3] << 16);
+}
+
+/*
+ * 4 pixels to 4 bits: adding 256 - threshold to a lane carries into its bit
+ * 8 exactly when the pixel reaches the threshold.
+ */
+static inline uint32_t eink_pack1_word(uint32_t w, uint32_t k_even,
+                                       uint32_t k_odd)
+{
+    uint32_t e = ((w & LANES_LO) + k_even) & 0x01000100;
+    uint32_t o = (((w >> 8) & LANES_LO) + k_odd) & 0x01000100;
+
+    return ((e >> 5) & 8) | ((o >> 6) & 4) | ((e >> 23) & 2) | (o >> 24);
+}
+
+void eink_pack1_row(uint8_t *dst, const uint8_t *src, unsigned int width,
+                    unsigned int y, enum eink_dither dither,
+                    uint8_t threshold)
+{
+    uint8_t tail[8];
+    uint32_t k_even, k_odd;
+    unsigned int i;
+
+    eink_row_levels(y, dither, threshold, &k_even, &k_odd, true);
+
+    for (i = 0; i < width / 8; i++, src += 8) {
+        dst[i] = (eink_pack1_word(eink_load32(src), k_even, k_odd) << 4) |
+                 eink_pack1_word(eink_load32(src + 4), k_even, k_odd);
+    }
+
+    if (width % 8) {
+        memset(tail, 0xff, sizeof(tail));
+        memcpy(tail, src, width % 8);
+        dst[i] = (eink_pack1_word(eink_load32(tail), k_even, k_odd) << 4) |
+                 eink_pack1_word(eink_load32(tail + 4), k_even, k_odd);
+    }
+}
+
+/*
+ * 4 pixels to 4 levels: level = (3 * pixel + offset) >> 8, where the offset
+ * is 128 to round or the dither threshold. The lanes have room for 3 * 255
+ * plus the offset.
+ */
+static inline uint8_t eink_pack2_word(uint32_t w, uint32_t d_even,
+                                      uint32_t d_odd)
+{
+    uint32_t e = (((w & LANES_LO) * 3 + d_even) >> 8) & 0x00030003;
+    uint32_t o = ((((w >> 8) & LANES_LO) * 3 + d_odd) >> 8) & 0x00030003;
+
+    return (e << 6) | (o << 4) | (e >> 14) | (o >> 16);
+}
+
+void eink_pack2_row(uint8_t *dst, const uint8_t *src, unsigned int width,
+                    unsigned int y, enum eink_dither dither)
+{
+    uint8_t tail[4];
+    uint32_t d_even, d_odd;
+    unsigned int i;
+
+    eink_row_levels(y, dither, 128, &d_even, &d_odd, false);
+
+    for (i = 0; i < width / 4; i++, src += 4) {
+        dst[i] = eink_pack2_word(eink_load32(src), d_even, d_odd);
+    }
+
+    if (width % 4) {
+        memset(tail, 0xff, sizeof(tail));
+        memcpy(tail, src, width % 4);
+        dst[i] = eink_pack2_word(eink_load32(tail), d_even, d_odd);
+    }
+}
+
+/*
+ * Transpose an 8x8 block of bits held in two words, from Hacker's Delight:
+ * source row i, column j lands in destination row j, column i.
+ */
+static void eink_transpose8(const uint8_t *src, int src_stride, uint8_t *dst,
+                            int dst_stride)
+{
+    uint32_t x, y, t;
+
+    x = (src[0] << 24) | (src[src_stride] << 16) |
+        (src[2 * src_stride] << 8) | src[3 * src_stride];
+    y = (src[4 * src_stride] << 24) | (src[5 * src_stride] << 16) |
+        (src[6 * src_stride] << 8) | src[7 * src_stride];
+
+    t = (x ^ (x >> 7)) & 0x00aa00aa;
+    x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00aa00aa;
+    y = y ^ t ^ (t << 7);
+
+    t = (x ^ (x >> 14)) & 0x0000cccc;
+    x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000cccc;
+    y = y ^ t ^ (t << 14);
+
+    t = (x & 0xf0f0f0f0) | ((y >> 4) & 0x0f0f0f0f);
+    y = ((x << 4) & 0xf0f0f0f0) | (y & 0x0f0f0f0f);
+    x = t;
+
+    dst[0] = x >> 24;
+    dst[dst_stride] = x >> 16;
+    dst[2 * dst_stride] = x >> 8;
+    dst[3 * dst_stride] = x;
+    dst[4 * dst_stride] = y >> 24;
+    dst[5 * dst_stride] = y >> 16;
+    dst[6 * dst_stride] = y >> 8;
+    dst[7 * dst_stride] = y;
+}
+
+/* Mirror a row: reversing the bits of a word mirrors its 32 pixels. */
+static void eink_mirror_row(uint8_t *dst, const uint8_t *src,
+                            unsigned int bytes)
+{
+    unsigned int i;
+
+    for (i = 0; i + 4 <= bytes; i += 4) {
+        eink_store32(dst + i, eink_rbit(eink_load32(src + bytes - 4 - i)));
+    }
+
+    for (; i < bytes; i++) {
+        dst[i] = eink_rbit(src[bytes - 1 - i]) >> 24;
+    }
+}
+
+int eink_rotate1(uint8_t *dst, unsigned int dst_stride, const uint8_t *src,
+                 unsigned int src_stride, unsigned int width,
+                 unsigned int height, enum eink_rotation rotation)
+{
+    unsigned int bytes = width / 8;
+    unsigned int bx, by, y;
+
+    if (width % 8) {
+        return -EINVAL;
+    }
+
+    switch (rotation) {
+    case EINK_ROTATE_0:
+        for (y = 0; y < height; y++) {
+            memcpy(dst + y * dst_stride, src + y * src_stride, bytes);
+        }
+        return 0;
+    case EINK_ROTATE_180:
+        for (y = 0; y < height; y++) {
+            eink_mirror_row(dst + y * dst_stride,
+                            src + (height - 1 - y) * src_stride, bytes);
+        }
+        return 0;
+    case EINK_ROTATE_90:
+    case EINK_ROTATE_270:
+        break;
+    default:
+        return -EINVAL;
+    }
+
+    if (height % 8) {
+        return -EINVAL;
+    }
+
+    /*
+     * 90 degrees is the transpose of the upside down image, 270 degrees the
+     * upside down transpose: only the walking direction differs.
+     */
+    for (by = 0; by < height / 8; by++) {
+        for (bx = 0; bx < bytes; bx++) {
+            if (rotation == EINK_ROTATE_90) {
+                eink_transpose8(src + (height - 1 - by * 8) * src_stride + bx,
+                                -(int)src_stride,
+                                dst + bx * 8 * dst_stride + by, dst_stride);
+            } else {
+                eink_transpose8(src + by * 8 * src_stride + bx, src_stride,
+                                dst + (width - 1 - bx * 8) * dst_stride + by,
+                                -(int)dst_stride);
+            }
+        }
+    }
+
+    return 0;
+}
+
+void eink_blit1_row(uint8_t *dst, unsigned int dx, const uint8_t *src,
+                    unsigned int width)
+{
+    unsigned int shift = dx & 7;
+    unsigned int first = dx / 8;
+    unsigned int last = (dx + width - 1) / 8;
+    unsigned int bytes = (width + 7) / 8;
+    unsigned int i, n;
+    uint32_t window = 0;
+    uint8_t mask;
+
+    if (!width) {
+        return;
+    }
+
+    /* Each output byte takes 8 bits from a two byte window of the source. */
+    for (i = first, n = 0; i <= last; i++, n++) {
+        window = (window << 8) | (n < bytes ? src[n] : 0);
+
+        mask = 0xff;
+        if (i == first) {
+            mask >>= shift;
+        }
+        if (i == last) {
+            mask &= 0xff << (7 - (dx + width - 1) % 8);
+        }
+
+        dst[i] = (dst[i] & ~mask) | ((window >> shift) & mask);
+    }
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FDK_EINK_CONVERT_H
+#define FDK_EINK_CONVERT_H
+
+#include <stdint.h>
+
+/*
+ * Pixel conversion kernels for the e-Ink panel.
+ *
+ * Packed rows are most significant bits leftmost, the level of a pixel grows
+ * with its brightness: in 1 bpp, 1 is white. Every kernel works on whole
+ * words or bytes of pixels, no kernel branches per pixel.
+ */
+
+enum eink_dither {
+    /** Compare every pixel to the same threshold */
+    EINK_DITHER_NONE,
+    /** 4x4 Bayer matrix, the pattern is anchored on the row and column 0 */
+    EINK_DITHER_ORDERED,
+};
+
+enum eink_rotation {
+    EINK_ROTATE_0,
+    /** Clockwise */
+    EINK_ROTATE_90,
+    EINK_ROTATE_180,
+    EINK_ROTATE_270,
+};
+
+/**
+ * @brief Convert a row of 8 bpp grayscale to 1 bpp
+ * @param dst Packed output, (width + 7) / 8 bytes
+ * @param src Grayscale input
+ * @param width Number of pixels
+ * @param y Row number, selects the dither pattern row
+ * @param dither Dithering mode
+ * @param threshold Lowest white level without dithering, 1 to 255
+ */
+void eink_pack1_row(uint8_t *dst, const uint8_t *src, unsigned int width,
+                    unsigned int y, enum eink_dither dither,
+                    uint8_t threshold);
+
+/**
+ * @brief Convert a row of 8 bpp grayscale to 2 bpp
+ * @param dst Packed output, (width + 3) / 4 bytes
+ * @param src Grayscale input
+ * @param width Number of pixels
+ * @param y Row number, selects the dither pattern row
+ * @param dither Dithering mode, EINK_DITHER_NONE rounds to the nearest level
+ */
+void eink_pack2_row(uint8_t *dst, const uint8_t *src, unsigned int width,
+                    unsigned int y, enum eink_dither dither);
+
+/**
+ * @brief Rotate a 1 bpp image
+ *
+ * The width must be a multiple of 8, and so must the height for 90 and 270
+ * degrees. The output is height pixels wide for 90 and 270 degrees.
+ *
+ * @param dst Output image
+ * @param dst_stride Bytes per output row
+ * @param src Input image
+ * @param src_stride Bytes per input row
+ * @param width Input width in pixels
+ * @param height Input height in pixels
+ * @param rotation Rotation to apply
+ * @return 0 on success, -EINVAL if the size is not supported
+ */
+int eink_rotate1(uint8_t *dst, unsigned int dst_stride, const uint8_t *src,
+                 unsigned int src_stride, unsigned int width,
+                 unsigned int height, enum eink_rotation rotation);
+
+/**
+ * @brief Copy a row of 1 bpp pixels to any pixel position
+ * @param dst Destination row
+ * @param dx First destination pixel
+ * @param src Source row, starting at its first pixel
+ * @param width Number of pixels
+ */
+void eink_blit1_row(uint8_t *dst, unsigned int dx, const uint8_t *src,
+                    unsigned int width);
+
+#endif /* FDK_EINK_CONVERT_H */
@@ -0,0 +1,734 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <semaphore.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <unistd.h>
+
+#include <nuttx/config.h>
+#include <nuttx/clock.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/gpio.h>
+#include <nuttx/spi/spi.h>
+#include <nuttx/util.h>
+#include <nuttx/wqueue.h>
+
+#include "eink_convert.h"
+#include "eink_display.h"
+#include "eink_panel_model.h"
+
+#define EINK_UPDATE_DELAY_MS    20      /* changes merged into one update */
+#define EINK_RESET_MS           10
+#define EINK_BUSY_POLL_MS       10
+#define EINK_BUSY_TIMEOUT_MS    5000
+/* A failed update is retried, the delay doubling up to the maximum */
+#define EINK_RETRY_MIN_MS       100
+#define EINK_RETRY_MAX_MS       10000
+
+/*
+ * Ghosting is tracked per horizontal band: a band takes EINK_GHOST_LIMIT
+ * partial updates before the next update touching it uses the full waveform.
+ */
+#define EINK_GHOST_BANDS        8
+#define EINK_GHOST_LIMIT        5
+#define EINK_BAND_ROWS          ((EINK_HEIGHT + EINK_GHOST_BANDS - 1) / \
+                                 EINK_GHOST_BANDS)
+
+/* SSD1680 commands */
+#define EINK_CMD_DRIVER_OUTPUT  0x01
+#define EINK_CMD_DATA_ENTRY     0x11
+#define EINK_CMD_SW_RESET       0x12
+#define EINK_CMD_TEMP_SENSOR    0x18
+#define EINK_CMD_ACTIVATE       0x20
+#define EINK_CMD_UPDATE_CTRL2   0x22
+#define EINK_CMD_WRITE_RAM      0x24
+#define EINK_CMD_WRITE_OLD_RAM  0x26
+#define EINK_CMD_BORDER         0x3c
+#define EINK_CMD_RAM_X_RANGE    0x44
+#define EINK_CMD_RAM_Y_RANGE    0x45
+#define EINK_CMD_RAM_X_COUNTER  0x4e
+#define EINK_CMD_RAM_Y_COUNTER  0x4f
+
+#define EINK_DATA_ENTRY_XY_INC  0x03
+#define EINK_BORDER_WHITE       0x05
+#define EINK_TEMP_INTERNAL      0x80
+#define EINK_UPDATE_FULL        0xf7
+#define EINK_UPDATE_PARTIAL     0xff
+
+struct eink_display {
+    struct spi_dev_s *spi;
+
+    /** Protects everything below, held for a whole panel update */
+    sem_t lock;
+
+    /** Update timer, armed by the first change or to retry a failure */
+    struct work_s work;
+    bool pending;
+
+    /** Delay before the next retry, zero after a successful update */
+    unsigned int retry_ms;
+
+    /** The panel went through its reset sequence */
+    bool ready;
+
+    /** Next update uses the full waveform */
+    bool full;
+
+    struct eink_region damage[EINK_MAX_REGIONS];
+    unsigned int num_damage;
+
+    /** Partial updates since the last full one, per band */
+    uint8_t ghost[EINK_GHOST_BANDS];
+
+    uint8_t fb[EINK_FB_SIZE];
+};
+
+static struct eink_display eink_disp;
+
+static void eink_display_worker(void *data);
+
+static unsigned int eink_region_area(const struct eink_region *region)
+{
+    return (region->x1 - region->x0) * (region->y1 - region->y0);
+}
+
+/* Overlapping or adjacent */
+static bool eink_region_touch(const struct eink_region *a,
+                              const struct eink_region *b)
+{
+    return a->x0 <= b->x1 && b->x0 <= a->x1 &&
+           a->y0 <= b->y1 && b->y0 <= a->y1;
+}
+
+static void eink_region_union(struct eink_region *a,
+                              const struct eink_region *b)
+{
+    a->x0 = MIN(a->x0, b->x0);
+    a->x1 = MAX(a->x1, b->x1);
+    a->y0 = MIN(a->y0, b->y0);
+    a->y1 = MAX(a->y1, b->y1);
+}
+
+/**
+ * @brief Add a rectangle to the damage list
+ *
+ * The rectangle absorbs every region it touches, repeatedly since the union
+ * can reach further regions. When the list is full, it is merged with the
+ * region whose bounding box grows the least, which wastes the fewest bytes.
+ *
+ * @param region Damaged rectangle
+ */
+static void eink_damage_add(const struct eink_region *region)
+{
+    struct eink_region new = *region;
+    struct eink_region merged;
+    unsigned int best, cost, best_cost;
+    unsigned int i;
+    bool changed;
+
+    do {
+        changed = false;
+
+        for (i = 0; i < eink_disp.num_damage; i++) {
+            if (eink_region_touch(&eink_disp.damage[i], &new)) {
+                eink_region_union(&new, &eink_disp.damage[i]);
+                eink_disp.damage[i] =
+                    eink_disp.damage[--eink_disp.num_damage];
+                changed = true;
+                break;
+            }
+        }
+
+        if (changed || eink_disp.num_damage < EINK_MAX_REGIONS) {
+            continue;
+        }
+
+        best = 0;
+        best_cost = ~0;
+        for (i = 0; i < eink_disp.num_damage; i++) {
+            merged = eink_disp.damage[i];
+            eink_region_union(&merged, &new);
+            cost = eink_region_area(&merged) -
+                   eink_region_area(&eink_disp.damage[i]);
+            if (cost < best_cost) {
+                best = i;
+                best_cost = cost;
+            }
+        }
+
+        eink_region_union(&new, &eink_disp.damage[best]);
+        eink_disp.damage[best] = eink_disp.damage[--eink_disp.num_damage];
+        changed = true;
+    } while (changed);
+
+    eink_disp.damage[eink_disp.num_damage++] = new;
+}
+
+static void eink_display_schedule(void)
+{
+    if (!eink_disp.pending) {
+        eink_disp.pending = true;
+        work_queue(LPWORK, &eink_disp.work, eink_display_worker, NULL,
+                   MSEC2TICK(EINK_UPDATE_DELAY_MS));
+    }
+}
+
+/**
+ * @brief Copy data into the framebuffer and damage what changed
+ *
+ * Called with the lock held, one run of rectangles is added per block of
+ * consecutive changed rows.
+ *
+ * @param offset Byte offset in the framebuffer
+ * @param buf Data to copy
+ * @param len Number of bytes, offset + len must be within the framebuffer
+ */
+static void eink_display_store(size_t offset, const uint8_t *buf, size_t len)
+{
+    struct eink_region run;
+    bool in_run = false;
+    unsigned int row, col, lo, hi;
+    size_t pos, end, row_end;
+
+    for (pos = offset, end = offset + len; pos < end; ) {
+        row = pos / EINK_STRIDE;
+        row_end = MIN(end, (row + 1) * EINK_STRIDE);
+        lo = EINK_STRIDE;
+        hi = 0;
+
+        for (; pos < row_end; pos++, buf++) {
+            if (eink_disp.fb[pos] == *buf) {
+                continue;
+            }
+
+            eink_disp.fb[pos] = *buf;
+            col = pos % EINK_STRIDE;
+            lo = MIN(lo, col);
+            hi = col + 1;
+        }
+
+        if (lo >= hi) {
+            if (in_run) {
+                eink_damage_add(&run);
+                in_run = false;
+            }
+            continue;
+        }
+
+        if (in_run) {
+            run.x0 = MIN(run.x0, lo);
+            run.x1 = MAX(run.x1, hi);
+            run.y1 = row + 1;
+            continue;
+        }
+
+        run.x0 = lo;
+        run.x1 = hi;
+        run.y0 = row;
+        run.y1 = row + 1;
+        in_run = true;
+    }
+
+    if (in_run) {
+        eink_damage_add(&run);
+    }
+
+    if (eink_disp.num_damage) {
+        eink_display_schedule();
+    }
+}
+
+ssize_t eink_display_write(off_t offset, const uint8_t *buf, size_t len)
+{
+    if (offset < 0 || offset > EINK_FB_SIZE) {
+        return -EINVAL;
+    }
+
+    if (offset == EINK_FB_SIZE) {
+        return len ? -EFBIG : 0;
+    }
+
+    len = MIN(len, EINK_FB_SIZE - offset);
+
+    sem_wait(&eink_disp.lock);
+    eink_display_store(offset, buf, len);
+    sem_post(&eink_disp.lock);
+
+    return len;
+}
+
+/**
+ * @brief Draw a 1 bpp image at any pixel position
+ * @param x Panel column of the left edge
+ * @param y Panel row of the top edge
+ * @param width Image width in pixels
+ * @param height Image height in pixels
+ * @param bits Packed image
+ * @param stride Bytes per image row
+ * @return 0 on success, -EINVAL if the image does not fit the panel
+ */
+static int eink_display_blit1(unsigned int x, unsigned int y,
+                              unsigned int width, unsigned int height,
+                              const uint8_t *bits, unsigned int stride)
+{
+    uint8_t row[EINK_STRIDE];
+    unsigned int i;
+
+    if (x + width > EINK_WIDTH || y + height > EINK_HEIGHT) {
+        return -EINVAL;
+    }
+
+    sem_wait(&eink_disp.lock);
+    for (i = 0; i < height; i++, bits += stride) {
+        memcpy(row, &eink_disp.fb[(y + i) * EINK_STRIDE], EINK_STRIDE);
+        eink_blit1_row(row, x, bits, width);
+        eink_display_store((y + i) * EINK_STRIDE, row, EINK_STRIDE);
+    }
+    sem_post(&eink_disp.lock);
+
+    return 0;
+}
+
+int eink_display_blit_gray(const struct eink_gray_blit *blit)
+{
+    unsigned int width = blit->width;
+    unsigned int height = blit->height;
+    unsigned int stride = (width + 7) / 8;
+    const uint8_t *src = blit->pixels;
+    uint8_t *bits;
+    uint8_t *rotated = NULL;
+    unsigned int i;
+    int ret;
+
+    if (!width || !height) {
+        return 0;
+    }
+
+    bits = malloc(stride * height);
+    if (!bits) {
+        return -ENOMEM;
+    }
+
+    for (i = 0; i < height; i++, src += blit->stride) {
+        eink_pack1_row(bits + i * stride, src, width, i, blit->dither,
+                       blit->threshold);
+    }
+
+    if (blit->rotation == EINK_ROTATE_0) {
+        ret = eink_display_blit1(blit->x, blit->y, width, height, bits,
+                                 stride);
+        goto out;
+    }
+
+    rotated = malloc(stride * height);
+    if (!rotated) {
+        ret = -ENOMEM;
+        goto out;
+    }
+
+    if (blit->rotation == EINK_ROTATE_180) {
+        ret = eink_rotate1(rotated, stride, bits, stride, width, height,
+                           blit->rotation);
+        if (!ret) {
+            ret = eink_display_blit1(blit->x, blit->y, width, height,
+                                     rotated, stride);
+        }
+        goto out;
+    }
+
+    ret = eink_rotate1(rotated, height / 8, bits, stride, width, height,
+                       blit->rotation);
+    if (!ret) {
+        ret = eink_display_blit1(blit->x, blit->y, height, width, rotated,
+                                 height / 8);
+    }
+
+out:
+    free(rotated);
+    free(bits);
+    return ret;
+}
+
+void eink_display_request_full(void)
+{
+    struct eink_region all = { 0, EINK_STRIDE, 0, EINK_HEIGHT };
+
+    sem_wait(&eink_disp.lock);
+    eink_disp.full = true;
+    eink_disp.num_damage = 0;
+    eink_damage_add(&all);
+    eink_display_schedule();
+    sem_post(&eink_disp.lock);
+}
+
+static void eink_panel_cmd(uint8_t cmd, const uint8_t *data, size_t len)
+{
+    struct spi_dev_s *spi = eink_disp.spi;
+
+    gpio_set_value(EINK_GPIO_DC, 0);
+    SPI_SELECT(spi, SPIDEV_DISPLAY, true);
+    SPI_SEND(spi, cmd);
+    if (len) {
+        gpio_set_value(EINK_GPIO_DC, 1);
+        SPI_SNDBLOCK(spi, data, len);
+    }
+    SPI_SELECT(spi, SPIDEV_DISPLAY, false);
+}
+
+static int eink_panel_wait(void)
+{
+    unsigned int waited = 0;
+
+    while (gpio_get_value(EINK_GPIO_BUSY)) {
+        if (waited >= EINK_BUSY_TIMEOUT_MS) {
+            return -ETIMEDOUT;
+        }
+
+        usleep(EINK_BUSY_POLL_MS * 1000);
+        waited += EINK_BUSY_POLL_MS;
+    }
+
+    return 0;
+}
+
+static int eink_panel_reset(void)
+{
+    uint8_t data[3];
+    int ret;
+
+    gpio_set_value(EINK_GPIO_RESET, 0);
+    usleep(EINK_RESET_MS * 1000);
+    gpio_set_value(EINK_GPIO_RESET, 1);
+    usleep(EINK_RESET_MS * 1000);
+
+    eink_panel_cmd(EINK_CMD_SW_RESET, NULL, 0);
+    ret = eink_panel_wait();
+    if (ret) {
+        return ret;
+    }
+
+    data[0] = (EINK_HEIGHT - 1) & 0xff;
+    data[1] = (EINK_HEIGHT - 1) >> 8;
+    data[2] = 0;
+    eink_panel_cmd(EINK_CMD_DRIVER_OUTPUT, data, 3);
+
+    data[0] = EINK_DATA_ENTRY_XY_INC;
+    eink_panel_cmd(EINK_CMD_DATA_ENTRY, data, 1);
+
+    data[0] = EINK_BORDER_WHITE;
+    eink_panel_cmd(EINK_CMD_BORDER, data, 1);
+
+    data[0] = EINK_TEMP_INTERNAL;
+    eink_panel_cmd(EINK_CMD_TEMP_SENSOR, data, 1);
+
+    return 0;
+}
+
+/**
+ * @brief Stream the rows of a region into one of the panel RAMs
+ *
+ * Full width regions are contiguous in the framebuffer and go out as one
+ * block, narrower ones one row at a time.
+ *
+ * @param cmd EINK_CMD_WRITE_RAM or EINK_CMD_WRITE_OLD_RAM
+ * @param region Region to send
+ */
+static void eink_panel_write_region(uint8_t cmd,
+                                    const struct eink_region *region)
+{
+    struct spi_dev_s *spi = eink_disp.spi;
+    unsigned int width = region->x1 - region->x0;
+    const uint8_t *row;
+    uint8_t data[4];
+    unsigned int y;
+
+    data[0] = region->x0;
+    data[1] = region->x1 - 1;
+    eink_panel_cmd(EINK_CMD_RAM_X_RANGE, data, 2);
+
+    data[0] = region->y0 & 0xff;
+    data[1] = region->y0 >> 8;
+    data[2] = (region->y1 - 1) & 0xff;
+    data[3] = (region->y1 - 1) >> 8;
+    eink_panel_cmd(EINK_CMD_RAM_Y_RANGE, data, 4);
+
+    /* Y counter bytes are still in data[0] and data[1] */
+    eink_panel_cmd(EINK_CMD_RAM_Y_COUNTER, data, 2);
+    data[0] = region->x0;
+    eink_panel_cmd(EINK_CMD_RAM_X_COUNTER, data, 1);
+
+    row = &eink_disp.fb[region->y0 * EINK_STRIDE + region->x0];
+
+    gpio_set_value(EINK_GPIO_DC, 0);
+    SPI_SELECT(spi, SPIDEV_DISPLAY, true);
+    SPI_SEND(spi, cmd);
+    gpio_set_value(EINK_GPIO_DC, 1);
+
+    if (width == EINK_STRIDE) {
+        SPI_SNDBLOCK(spi, row, eink_region_area(region));
+    } else {
+        for (y = region->y0; y < region->y1; y++, row += EINK_STRIDE) {
+            SPI_SNDBLOCK(spi, row, width);
+        }
+    }
+
+    SPI_SELECT(spi, SPIDEV_DISPLAY, false);
+}
+
+/**
+ * @brief Pick the waveform a region needs
+ *
+ * @param region Damaged region
+ * @return EINK_WAVEFORM_FULL if a band it covers has had too many partial
+ * updates, EINK_WAVEFORM_PARTIAL otherwise
+ */
+static enum eink_waveform eink_region_waveform(const struct eink_region *region)
+{
+    unsigned int band;
+
+    for (band = region->y0 / EINK_BAND_ROWS;
+         band * EINK_BAND_ROWS < region->y1; band++) {
+        if (eink_disp.ghost[band] >= EINK_GHOST_LIMIT) {
+            return EINK_WAVEFORM_FULL;
+        }
+    }
+
+    return EINK_WAVEFORM_PARTIAL;
+}
+
+/* Count a partial update once for every band any region touched */
+static void eink_ghost_account(enum eink_waveform waveform)
+{
+    const struct eink_region *region;
+    uint32_t touched = 0;
+    unsigned int band;
+    unsigned int i;
+
+    if (waveform == EINK_WAVEFORM_FULL) {
+        memset(eink_disp.ghost, 0, sizeof(eink_disp.ghost));
+        return;
+    }
+
+    for (i = 0; i < eink_disp.num_damage; i++) {
+        region = &eink_disp.damage[i];
+        for (band = region->y0 / EINK_BAND_ROWS;
+             band * EINK_BAND_ROWS < region->y1; band++) {
+            touched |= 1 << band;
+        }
+    }
+
+    for (band = 0; band < EINK_GHOST_BANDS; band++) {
+        if ((touched & (1 << band)) &&
+            eink_disp.ghost[band] < EINK_GHOST_LIMIT) {
+            eink_disp.ghost[band]++;
+        }
+    }
+}
+
+/* Called with the lock held, after a failed update kept its damage */
+static void eink_display_retry(void)
+{
+    eink_disp.retry_ms = eink_disp.retry_ms ?
+                         MIN(eink_disp.retry_ms * 2, EINK_RETRY_MAX_MS) :
+                         EINK_RETRY_MIN_MS;
+
+    eink_disp.pending = true;
+    work_queue(LPWORK, &eink_disp.work, eink_display_worker, NULL,
+               MSEC2TICK(eink_disp.retry_ms));
+}
+
+/*
+ * The SSD1680 runs one waveform per activation over the whole panel: the
+ * regions are loaded together and the strongest waveform any of them needs
+ * drives the activation. The partial waveform only moves the pixels that
+ * differ between the new and old image RAMs, so the regions are copied to
+ * the old image RAM once the panel is done.
+ */
+int eink_display_flush(void)
+{
+    struct spi_dev_s *spi = eink_disp.spi;
+    enum eink_waveform waveform;
+    uint8_t ctrl;
+    unsigned int i;
+    int ret = 0;
+
+    sem_wait(&eink_disp.lock);
+
+    work_cancel(LPWORK, &eink_disp.work);
+    eink_disp.pending = false;
+
+    if (!spi) {
+        ret = -ENODEV;
+        goto out;
+    }
+
+    if (!eink_disp.num_damage) {
+        goto out;
+    }
+
+    SPI_LOCK(spi, true);
+    SPI_SETMODE(spi, SPIDEV_MODE0);
+    SPI_SETBITS(spi, 8);
+    SPI_SETFREQUENCY(spi, EINK_SPI_FREQUENCY);
+
+    if (!eink_disp.ready) {
+        ret = eink_panel_reset();
+        if (ret) {
+            goto out_unlock;
+        }
+        eink_disp.ready = true;
+    }
+
+    waveform = eink_disp.full ? EINK_WAVEFORM_FULL : EINK_WAVEFORM_PARTIAL;
+    for (i = 0; i < eink_disp.num_damage; i++) {
+        eink_panel_write_region(EINK_CMD_WRITE_RAM, &eink_disp.damage[i]);
+        if (eink_region_waveform(&eink_disp.damage[i]) == EINK_WAVEFORM_FULL) {
+            waveform = EINK_WAVEFORM_FULL;
+        }
+    }
+
+    ctrl = waveform == EINK_WAVEFORM_FULL ? EINK_UPDATE_FULL :
+                                            EINK_UPDATE_PARTIAL;
+    eink_panel_cmd(EINK_CMD_UPDATE_CTRL2, &ctrl, 1);
+    eink_panel_cmd(EINK_CMD_ACTIVATE, NULL, 0);
+
+    /* The damage is kept, a panel that timed out is reset and redrawn. */
+    ret = eink_panel_wait();
+    if (ret) {
+        eink_disp.ready = false;
+        goto out_unlock;
+    }
+
+    for (i = 0; i < eink_disp.num_damage; i++) {
+        eink_panel_write_region(EINK_CMD_WRITE_OLD_RAM, &eink_disp.damage[i]);
+    }
+
+    eink_ghost_account(waveform);
+    eink_disp.num_damage = 0;
+    eink_disp.full = false;
+    eink_disp.retry_ms = 0;
+
+out_unlock:
+    SPI_LOCK(spi, false);
+    if (ret) {
+        eink_display_retry();
+    }
+out:
+    sem_post(&eink_disp.lock);
+    return ret;
+}
+
+static void eink_display_worker(void *data)
+{
+    int ret;
+
+    ret = eink_display_flush();
+    if (ret) {
+        lowsyslog("eink: display update failed: %d\n", ret);
+    }
+}
+
+static ssize_t eink_fb_write(struct file *filep, const char *buffer,
+                             size_t buflen)
+{
+    ssize_t ret;
+
+    ret = eink_display_write(filep->f_pos, (const uint8_t *)buffer, buflen);
+    if (ret > 0) {
+        filep->f_pos += ret;
+    }
+
+    return ret;
+}
+
+static int eink_fb_ioctl(struct file *filep, int cmd, unsigned long arg)
+{
+    switch (cmd) {
+    case EINKIOC_FULL_REFRESH:
+        eink_display_request_full();
+        return 0;
+    case EINKIOC_BLIT_GRAY:
+        return eink_display_blit_gray((const struct eink_gray_blit *)arg);
+    default:
+        return -ENOTTY;
+    }
+}
+
+static const struct file_operations eink_fb_fops = {
+    .write  = eink_fb_write,
+    .ioctl  = eink_fb_ioctl,
+};
+
+int eink_display_init(void)
+{
+    int ret;
+
+    sem_init(&eink_disp.lock, 0, 1);
+
+    ret = gpio_activate(EINK_GPIO_DC);
+    if (ret) {
+        return ret;
+    }
+
+    ret = gpio_activate(EINK_GPIO_RESET);
+    if (ret) {
+        goto err_deactivate_dc;
+    }
+
+    ret = gpio_activate(EINK_GPIO_BUSY);
+    if (ret) {
+        goto err_deactivate_reset;
+    }
+
+    gpio_direction_out(EINK_GPIO_DC, 1);
+    gpio_direction_out(EINK_GPIO_RESET, 1);
+    gpio_direction_in(EINK_GPIO_BUSY);
+
+    eink_disp.spi = up_spiinitialize(EINK_SPI_PORT);
+    if (!eink_disp.spi) {
+        ret = -ENODEV;
+        goto err_deactivate_busy;
+    }
+
+    /* The panel content is unknown, start from a full white redraw. */
+    memset(eink_disp.fb, 0xff, sizeof(eink_disp.fb));
+    eink_display_request_full();
+
+    return register_driver(EINK_FB_DEVPATH, &eink_fb_fops, 0222, NULL);
+
+err_deactivate_busy:
+    gpio_deactivate(EINK_GPIO_BUSY);
+err_deactivate_reset:
+    gpio_deactivate(EINK_GPIO_RESET);
+err_deactivate_dc:
+    gpio_deactivate(EINK_GPIO_DC);
+    return ret;
+}
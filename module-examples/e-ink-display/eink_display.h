@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FDK_EINK_DISPLAY_H
+#define FDK_EINK_DISPLAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/*
+ * Display update engine of the e-Ink panel.
+ *
+ * The framebuffer is written through EINK_FB_DEVPATH: one bit per pixel,
+ * 1 for white, rows of EINK_STRIDE bytes, most significant bit leftmost. Only
+ * the bytes that change are damaged. Damage is merged into at most
+ * EINK_MAX_REGIONS rectangles and sent to the panel EINK_UPDATE_DELAY_MS
+ * after the first change, so a page written in several pieces is one update.
+ */
+
+#define EINK_WIDTH              128
+#define EINK_HEIGHT             296
+#define EINK_STRIDE             (EINK_WIDTH / 8)
+#define EINK_FB_SIZE            (EINK_STRIDE * EINK_HEIGHT)
+
+#define EINK_FB_DEVPATH         "/dev/einkfb"
+
+/* Panel wiring: SSD1680 controller on SPI, data/command, reset and busy */
+#define EINK_SPI_PORT           0
+#define EINK_SPI_FREQUENCY      4000000
+#define EINK_GPIO_DC            3
+#define EINK_GPIO_RESET         4
+#define EINK_GPIO_BUSY          5
+
+/* ioctl: redraw the whole panel with the full waveform to clear ghosting */
+#define EINKIOC_FULL_REFRESH    0x4501
+/* ioctl: draw a struct eink_gray_blit */
+#define EINKIOC_BLIT_GRAY       0x4502
+
+#define EINK_MAX_REGIONS        8
+
+enum eink_waveform {
+    /** Changed pixels only, no flash, leaves some ghosting */
+    EINK_WAVEFORM_PARTIAL,
+    /** Every pixel through black and white, flashes */
+    EINK_WAVEFORM_FULL,
+};
+
+/**
+ * @brief Damaged rectangle, in byte columns and rows, ends exclusive
+ */
+struct eink_region {
+    uint8_t x0;
+    uint8_t x1;
+    uint16_t y0;
+    uint16_t y1;
+};
+
+/**
+ * @brief 8 bpp grayscale image, converted and rotated on the module
+ */
+struct eink_gray_blit {
+    const uint8_t *pixels;
+    /** Size of the image before rotation */
+    uint16_t width;
+    uint16_t height;
+    /** Bytes per row of pixels */
+    uint16_t stride;
+    /** Panel position of the top left corner of the rotated image */
+    uint16_t x;
+    uint16_t y;
+    /** enum eink_rotation */
+    uint8_t rotation;
+    /** enum eink_dither */
+    uint8_t dither;
+    /** Lowest white level without dithering */
+    uint8_t threshold;
+};
+
+/**
+ * @brief Set up the panel and register EINK_FB_DEVPATH
+ *
+ * The panel is reset and cleared from the work queue, this returns at once.
+ *
+ * @return 0 on success, negative errno on error
+ */
+int eink_display_init(void);
+
+/**
+ * @brief Copy data into the framebuffer and damage what changed
+ * @param offset Byte offset in the framebuffer
+ * @param buf Data to copy
+ * @param len Number of bytes
+ * @return number of bytes copied, negative errno on error
+ */
+ssize_t eink_display_write(off_t offset, const uint8_t *buf, size_t len);
+
+/**
+ * @brief Convert a grayscale image to 1 bpp and draw it
+ *
+ * Rotated images must be a multiple of 8 pixels wide, and high for 90 and
+ * 270 degrees.
+ *
+ * @param blit Image and position
+ * @return 0 on success, negative errno on error
+ */
+int eink_display_blit_gray(const struct eink_gray_blit *blit);
+
+/**
+ * @brief Damage the whole panel and force the full waveform
+ */
+void eink_display_request_full(void);
+
+/**
+ * @brief Send the pending damage to the panel now
+ *
+ * If the panel does not respond, the damage is kept and the update retried
+ * from the work queue, with a delay doubling on each failure.
+ *
+ * @return 0 on success, negative errno on error
+ */
+int eink_display_flush(void);
+
+#endif /* FDK_EINK_DISPLAY_H */
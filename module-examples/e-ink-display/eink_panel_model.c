@@ -0,0 +1,781 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <nuttx/config.h>
+
+#ifdef CONFIG_ARA_EINK_PANEL_MODEL
+
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+#include <syslog.h>
+#include <time.h>
+
+#include <nuttx/spi/spi.h>
+#include <nuttx/util.h>
+
+#include "common/bench.h"
+
+#include "eink_convert.h"
+#include "eink_display.h"
+#include "eink_panel_model.h"
+
+/* Commands decoded by the model */
+#define EINK_MODEL_CMD_ACTIVATE         0x20
+#define EINK_MODEL_CMD_UPDATE_CTRL2     0x22
+#define EINK_MODEL_CMD_WRITE_RAM        0x24
+#define EINK_MODEL_CMD_WRITE_OLD_RAM    0x26
+#define EINK_MODEL_CMD_RAM_X_RANGE      0x44
+#define EINK_MODEL_CMD_RAM_Y_RANGE      0x45
+
+#define EINK_MODEL_UPDATE_FULL          0xf7
+
+#define EINK_MODEL_MAX_PARAMS           4
+
+/**
+ * @brief Model state
+ */
+struct eink_panel_model_info {
+    struct spi_dev_s spi;
+    /** Data/command line, high for data */
+    bool dc_data;
+    uint8_t cmd;
+    uint8_t params[EINK_MODEL_MAX_PARAMS];
+    unsigned int num_params;
+    /** RAM window set by the X and Y range commands */
+    struct eink_region window;
+    uint8_t update_ctrl;
+    uint32_t byte_time_ns;
+    /** Sub-microsecond remainder of the bus time */
+    uint32_t bus_ns;
+    struct eink_panel_model_stats stats;
+    struct eink_panel_model_update log[EINK_PANEL_MODEL_LOG_SIZE];
+    unsigned int log_count;
+    /** First log entry not displayed yet */
+    unsigned int log_shown;
+};
+
+static struct eink_panel_model_info eink_panel_model;
+
+static void eink_panel_model_charge_byte(void)
+{
+    eink_panel_model.stats.bytes++;
+    eink_panel_model.bus_ns += eink_panel_model.byte_time_ns;
+    eink_panel_model.stats.bus_us += eink_panel_model.bus_ns / 1000;
+    eink_panel_model.bus_ns %= 1000;
+}
+
+static void eink_panel_model_activate(void)
+{
+    enum eink_waveform waveform;
+    unsigned int i;
+
+    if (eink_panel_model.update_ctrl == EINK_MODEL_UPDATE_FULL) {
+        waveform = EINK_WAVEFORM_FULL;
+        eink_panel_model.stats.full_updates++;
+        eink_panel_model.stats.waveform_us += EINK_PANEL_MODEL_FULL_US;
+    } else {
+        waveform = EINK_WAVEFORM_PARTIAL;
+        eink_panel_model.stats.partial_updates++;
+        eink_panel_model.stats.waveform_us += EINK_PANEL_MODEL_PARTIAL_US;
+    }
+
+    for (i = eink_panel_model.log_shown; i < eink_panel_model.log_count; i++) {
+        eink_panel_model.log[i].waveform = waveform;
+    }
+    eink_panel_model.log_shown = eink_panel_model.log_count;
+}
+
+static void eink_panel_model_command(uint8_t cmd)
+{
+    struct eink_panel_model_update *update;
+
+    eink_panel_model.cmd = cmd;
+    eink_panel_model.num_params = 0;
+    eink_panel_model.stats.commands++;
+
+    switch (cmd) {
+    case EINK_MODEL_CMD_ACTIVATE:
+        eink_panel_model_activate();
+        break;
+    case EINK_MODEL_CMD_WRITE_RAM:
+        eink_panel_model.stats.windows++;
+        if (eink_panel_model.log_count < EINK_PANEL_MODEL_LOG_SIZE) {
+            update = &eink_panel_model.log[eink_panel_model.log_count++];
+            update->region = eink_panel_model.window;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void eink_panel_model_param(uint8_t value)
+{
+    uint8_t *params = eink_panel_model.params;
+
+    switch (eink_panel_model.cmd) {
+    case EINK_MODEL_CMD_WRITE_RAM:
+        eink_panel_model.stats.ram_bytes++;
+        return;
+    case EINK_MODEL_CMD_WRITE_OLD_RAM:
+        return;
+    default:
+        break;
+    }
+
+    if (eink_panel_model.num_params == EINK_MODEL_MAX_PARAMS) {
+        return;
+    }
+
+    params[eink_panel_model.num_params++] = value;
+
+    switch (eink_panel_model.cmd) {
+    case EINK_MODEL_CMD_UPDATE_CTRL2:
+        eink_panel_model.update_ctrl = params[0];
+        break;
+    case EINK_MODEL_CMD_RAM_X_RANGE:
+        if (eink_panel_model.num_params == 2) {
+            eink_panel_model.window.x0 = params[0];
+            eink_panel_model.window.x1 = params[1] + 1;
+        }
+        break;
+    case EINK_MODEL_CMD_RAM_Y_RANGE:
+        if (eink_panel_model.num_params == 4) {
+            eink_panel_model.window.y0 = params[0] | (params[1] << 8);
+            eink_panel_model.window.y1 = (params[2] | (params[3] << 8)) + 1;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void eink_panel_model_byte(uint8_t value)
+{
+    eink_panel_model_charge_byte();
+
+    if (eink_panel_model.dc_data) {
+        eink_panel_model_param(value);
+    } else {
+        eink_panel_model_command(value);
+    }
+}
+
+#ifndef CONFIG_SPI_OWNBUS
+static int eink_panel_model_lock(struct spi_dev_s *dev, bool lock)
+{
+    return 0;
+}
+#endif
+
+static void eink_panel_model_select(struct spi_dev_s *dev,
+                                    enum spi_dev_e devid, bool selected)
+{
+}
+
+static uint32_t eink_panel_model_setfrequency(struct spi_dev_s *dev,
+                                              uint32_t frequency)
+{
+    /* 8 clocks per byte, no gap between bytes */
+    eink_panel_model.byte_time_ns = 8000000 / (frequency / 1000);
+    return frequency;
+}
+
+static void eink_panel_model_setmode(struct spi_dev_s *dev,
+                                     enum spi_mode_e mode)
+{
+}
+
+static void eink_panel_model_setbits(struct spi_dev_s *dev, int nbits)
+{
+}
+
+static uint8_t eink_panel_model_status(struct spi_dev_s *dev,
+                                       enum spi_dev_e devid)
+{
+    return 0;
+}
+
+static uint16_t eink_panel_model_send(struct spi_dev_s *dev, uint16_t wd)
+{
+    eink_panel_model_byte(wd);
+    return 0;
+}
+
+#ifdef CONFIG_SPI_EXCHANGE
+static void eink_panel_model_exchange(struct spi_dev_s *dev,
+                                      const void *txbuffer, void *rxbuffer,
+                                      size_t nwords)
+{
+    const uint8_t *tx = txbuffer;
+    size_t i;
+
+    for (i = 0; i < nwords; i++) {
+        eink_panel_model_byte(tx ? tx[i] : 0xff);
+    }
+
+    if (rxbuffer) {
+        memset(rxbuffer, 0, nwords);
+    }
+}
+#else
+static void eink_panel_model_sndblock(struct spi_dev_s *dev,
+                                      const void *buffer, size_t nwords)
+{
+    const uint8_t *tx = buffer;
+    size_t i;
+
+    for (i = 0; i < nwords; i++) {
+        eink_panel_model_byte(tx[i]);
+    }
+}
+
+static void eink_panel_model_recvblock(struct spi_dev_s *dev, void *buffer,
+                                       size_t nwords)
+{
+    size_t i;
+
+    for (i = 0; i < nwords; i++) {
+        eink_panel_model_byte(0xff);
+    }
+    memset(buffer, 0, nwords);
+}
+#endif
+
+static const struct spi_ops_s eink_panel_model_spi_ops = {
+#ifndef CONFIG_SPI_OWNBUS
+    .lock           = eink_panel_model_lock,
+#endif
+    .select         = eink_panel_model_select,
+    .setfrequency   = eink_panel_model_setfrequency,
+    .setmode        = eink_panel_model_setmode,
+    .setbits        = eink_panel_model_setbits,
+    .status         = eink_panel_model_status,
+    .send           = eink_panel_model_send,
+#ifdef CONFIG_SPI_EXCHANGE
+    .exchange       = eink_panel_model_exchange,
+#else
+    .sndblock       = eink_panel_model_sndblock,
+    .recvblock      = eink_panel_model_recvblock,
+#endif
+};
+
+struct spi_dev_s *eink_panel_model_spiinitialize(int port)
+{
+    eink_panel_model.spi.ops = &eink_panel_model_spi_ops;
+    eink_panel_model_setfrequency(&eink_panel_model.spi, EINK_SPI_FREQUENCY);
+    return &eink_panel_model.spi;
+}
+
+void eink_panel_model_gpio_set(uint8_t which, uint8_t value)
+{
+    if (which == EINK_GPIO_DC) {
+        eink_panel_model.dc_data = value;
+    }
+}
+
+uint8_t eink_panel_model_gpio_get(uint8_t which)
+{
+    /* Busy never asserts */
+    return 0;
+}
+
+void eink_panel_model_get_stats(struct eink_panel_model_stats *stats)
+{
+    *stats = eink_panel_model.stats;
+}
+
+void eink_panel_model_reset_stats(void)
+{
+    memset(&eink_panel_model.stats, 0, sizeof(eink_panel_model.stats));
+    eink_panel_model.bus_ns = 0;
+    eink_panel_model.log_count = 0;
+    eink_panel_model.log_shown = 0;
+}
+
+unsigned int eink_panel_model_get_log(struct eink_panel_model_update *log,
+                                      unsigned int size)
+{
+    unsigned int count = MIN(size, eink_panel_model.log_count);
+
+    memcpy(log, eink_panel_model.log, count * sizeof(*log));
+    return count;
+}
+
+/* Text line layout used by the scenarios: 16 pixel glyphs, 24 pixel lines */
+#define EINK_BENCH_LINE_ROWS    24
+#define EINK_BENCH_GLYPH_ROWS   16
+#define EINK_BENCH_MARGIN       4
+#define EINK_BENCH_NUM_LINES    (EINK_HEIGHT / EINK_BENCH_LINE_ROWS)
+
+/**
+ * @brief Write a line of text, one framebuffer row at a time
+ * @param line Line number
+ * @param x0 First byte column of the text
+ * @param x1 End byte column of the text
+ * @param seed Selects the glyphs
+ */
+static void eink_bench_text(unsigned int line, unsigned int x0,
+                            unsigned int x1, unsigned int seed)
+{
+    uint8_t row[EINK_STRIDE];
+    unsigned int y0 = line * EINK_BENCH_LINE_ROWS + EINK_BENCH_MARGIN;
+    unsigned int x, y;
+
+    for (y = y0; y < y0 + EINK_BENCH_GLYPH_ROWS; y++) {
+        memset(row, 0xff, sizeof(row));
+        for (x = x0; x < x1; x++) {
+            row[x] = (seed * 0x3b + y * 7 + x * 13) & 0x7f;
+        }
+        eink_display_write(y * EINK_STRIDE, row, sizeof(row));
+    }
+}
+
+static void eink_bench_page(unsigned int seed)
+{
+    unsigned int line;
+
+    for (line = 0; line < EINK_BENCH_NUM_LINES; line++) {
+        eink_bench_text(line, 1, EINK_STRIDE - 1, seed);
+    }
+}
+
+static void eink_bench_cursor(void)
+{
+    uint8_t black[2] = { 0x80, 0x80 };
+    unsigned int y;
+
+    /* Two overlapping damaged areas over text, one window */
+    for (y = 200; y < 216; y++) {
+        eink_display_write(y * EINK_STRIDE + 8, black, 1);
+    }
+    for (y = 208; y < 224; y++) {
+        eink_display_write(y * EINK_STRIDE + 8, black, 2);
+    }
+}
+
+/**
+ * @brief Budget of one display update scenario
+ *
+ * The figures are the ones the bench prints on target. Nothing is timed: the
+ * bus time follows from the bytes sent at EINK_SPI_FREQUENCY and the waveform
+ * times are fixed, so they only change with the engine or the model.
+ */
+struct eink_panel_model_budget {
+    const char *name;
+    /** Number of updates the scenario flushes */
+    unsigned int updates;
+    uint32_t max_windows;
+    uint32_t max_bytes;
+    uint32_t full_updates;
+    uint32_t max_latency_us;
+};
+
+enum {
+    EINK_BENCH_CLEAR,
+    EINK_BENCH_PAGE,
+    EINK_BENCH_TURN,
+    EINK_BENCH_LINE,
+    EINK_BENCH_CURSOR,
+    EINK_BENCH_NOOP,
+    EINK_BENCH_GHOST,
+};
+
+static const struct eink_panel_model_budget eink_panel_model_budgets[] = {
+    [EINK_BENCH_CLEAR]  = { "clear",  1, 1, 9514, 1, 1519028 },
+    [EINK_BENCH_PAGE]   = { "page",   1, 8, 6499, 0,  312998 },
+    [EINK_BENCH_TURN]   = { "turn",   1, 8, 6499, 0,  312998 },
+    [EINK_BENCH_LINE]   = { "line",   1, 1,  479, 0,  300958 },
+    [EINK_BENCH_CURSOR] = { "cursor", 1, 1,  127, 0,  300254 },
+    [EINK_BENCH_NOOP]   = { "noop",   1, 0,    0, 0,       0 },
+    [EINK_BENCH_GHOST]  = { "ghost",  3, 3, 1245, 1, 2102490 },
+};
+
+static void eink_bench_draw(unsigned int scenario, unsigned int update)
+{
+    switch (scenario) {
+    case EINK_BENCH_PAGE:
+        eink_bench_page(1);
+        break;
+    case EINK_BENCH_TURN:
+        eink_bench_page(2);
+        break;
+    case EINK_BENCH_LINE:
+    case EINK_BENCH_NOOP:
+        eink_bench_text(5, 2, EINK_STRIDE - 2, 3);
+        break;
+    case EINK_BENCH_CURSOR:
+        eink_bench_cursor();
+        break;
+    case EINK_BENCH_GHOST:
+        eink_bench_text(5, 2, EINK_STRIDE - 2, 4 + update);
+        break;
+    default:
+        break;
+    }
+}
+
+/* Conversion kernels, timed over a full panel frame */
+#define EINK_CONVERT_REPEAT     8
+#define EINK_CONVERT_TILE_ROWS  8
+
+static uint8_t eink_convert_tile[EINK_CONVERT_TILE_ROWS][EINK_WIDTH];
+static uint8_t eink_convert_out[2][2 * EINK_FB_SIZE];
+
+static const uint8_t eink_convert_bayer[4][4] = {
+    {  0,  8,  2, 10 },
+    { 12,  4, 14,  6 },
+    {  3, 11,  1,  9 },
+    { 15,  7, 13,  5 },
+};
+
+static uint32_t eink_convert_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static unsigned int eink_convert_level(unsigned int x, unsigned int y,
+                                       enum eink_dither dither,
+                                       unsigned int flat)
+{
+    return dither == EINK_DITHER_ORDERED ?
+           eink_convert_bayer[y & 3][x & 3] * 16 + 8 : flat;
+}
+
+/* Per-pixel references the kernels are checked against */
+static void eink_convert_ref_pack1(uint8_t *dst, unsigned int y,
+                                   enum eink_dither dither)
+{
+    const uint8_t *src = eink_convert_tile[y % EINK_CONVERT_TILE_ROWS];
+    unsigned int x;
+
+    memset(dst, 0, EINK_STRIDE);
+    for (x = 0; x < EINK_WIDTH; x++) {
+        if (src[x] >= eink_convert_level(x, y, dither, 128)) {
+            dst[x / 8] |= 0x80 >> (x % 8);
+        }
+    }
+}
+
+static void eink_convert_ref_pack2(uint8_t *dst, unsigned int y,
+                                   enum eink_dither dither)
+{
+    const uint8_t *src = eink_convert_tile[y % EINK_CONVERT_TILE_ROWS];
+    unsigned int x, level;
+
+    memset(dst, 0, 2 * EINK_STRIDE);
+    for (x = 0; x < EINK_WIDTH; x++) {
+        level = (3 * src[x] + eink_convert_level(x, y, dither, 128)) >> 8;
+        dst[x / 4] |= level << (6 - 2 * (x % 4));
+    }
+}
+
+static unsigned int eink_convert_get(const uint8_t *image,
+                                     unsigned int stride, unsigned int x,
+                                     unsigned int y)
+{
+    return (image[y * stride + x / 8] >> (7 - x % 8)) & 1;
+}
+
+static void eink_convert_set(uint8_t *image, unsigned int stride,
+                             unsigned int x, unsigned int y,
+                             unsigned int value)
+{
+    uint8_t bit = 0x80 >> (x % 8);
+
+    if (value) {
+        image[y * stride + x / 8] |= bit;
+    } else {
+        image[y * stride + x / 8] &= ~bit;
+    }
+}
+
+static void eink_convert_ref_rotate(uint8_t *dst, const uint8_t *src,
+                                    enum eink_rotation rotation)
+{
+    unsigned int x, y, value;
+
+    for (y = 0; y < EINK_HEIGHT; y++) {
+        for (x = 0; x < EINK_WIDTH; x++) {
+            value = eink_convert_get(src, EINK_STRIDE, x, y);
+            switch (rotation) {
+            case EINK_ROTATE_90:
+                eink_convert_set(dst, EINK_HEIGHT / 8, EINK_HEIGHT - 1 - y, x,
+                                 value);
+                break;
+            case EINK_ROTATE_180:
+                eink_convert_set(dst, EINK_STRIDE, EINK_WIDTH - 1 - x,
+                                 EINK_HEIGHT - 1 - y, value);
+                break;
+            case EINK_ROTATE_270:
+                eink_convert_set(dst, EINK_HEIGHT / 8, y, EINK_WIDTH - 1 - x,
+                                 value);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
+
+static void eink_convert_ref_blit(uint8_t *dst, const uint8_t *src,
+                                  unsigned int dx, unsigned int width)
+{
+    unsigned int x, y;
+
+    for (y = 0; y < EINK_HEIGHT; y++) {
+        for (x = 0; x < width; x++) {
+            eink_convert_set(dst, EINK_STRIDE, dx + x, y,
+                             eink_convert_get(src, EINK_STRIDE, x, y));
+        }
+    }
+}
+
+enum {
+    EINK_CONVERT_PACK1,
+    EINK_CONVERT_PACK1_DITHER,
+    EINK_CONVERT_PACK2,
+    EINK_CONVERT_PACK2_DITHER,
+    EINK_CONVERT_ROTATE_90,
+    EINK_CONVERT_ROTATE_180,
+    EINK_CONVERT_ROTATE_270,
+    EINK_CONVERT_BLIT,
+    EINK_CONVERT_NUM_KERNELS,
+};
+
+static const char *const eink_convert_names[EINK_CONVERT_NUM_KERNELS] = {
+    "1bpp threshold", "1bpp dither", "2bpp round", "2bpp dither",
+    "rotate 90", "rotate 180", "rotate 270", "blit x+3",
+};
+
+/* The 1 bpp frame the rotations and the blit start from */
+static void eink_convert_source(void)
+{
+    unsigned int y;
+
+    for (y = 0; y < EINK_HEIGHT; y++) {
+        eink_pack1_row(&eink_convert_out[0][y * EINK_STRIDE],
+                       eink_convert_tile[y % EINK_CONVERT_TILE_ROWS],
+                       EINK_WIDTH, y, EINK_DITHER_ORDERED, 128);
+    }
+}
+
+static void eink_convert_run(unsigned int kernel, bool reference)
+{
+    uint8_t *src = eink_convert_out[0];
+    uint8_t *out = eink_convert_out[reference];
+    enum eink_dither dither;
+    unsigned int y;
+
+    /* Rotations and blits read the source frame, their outputs share out[1] */
+    if (kernel >= EINK_CONVERT_ROTATE_90) {
+        out = &eink_convert_out[1][reference ? EINK_FB_SIZE : 0];
+    }
+
+    switch (kernel) {
+    case EINK_CONVERT_PACK1:
+    case EINK_CONVERT_PACK1_DITHER:
+        dither = kernel == EINK_CONVERT_PACK1 ? EINK_DITHER_NONE :
+                                                EINK_DITHER_ORDERED;
+        for (y = 0; y < EINK_HEIGHT; y++, out += EINK_STRIDE) {
+            if (reference) {
+                eink_convert_ref_pack1(out, y, dither);
+            } else {
+                eink_pack1_row(out,
+                               eink_convert_tile[y % EINK_CONVERT_TILE_ROWS],
+                               EINK_WIDTH, y, dither, 128);
+            }
+        }
+        break;
+    case EINK_CONVERT_PACK2:
+    case EINK_CONVERT_PACK2_DITHER:
+        dither = kernel == EINK_CONVERT_PACK2 ? EINK_DITHER_NONE :
+                                                EINK_DITHER_ORDERED;
+        for (y = 0; y < EINK_HEIGHT; y++, out += 2 * EINK_STRIDE) {
+            if (reference) {
+                eink_convert_ref_pack2(out, y, dither);
+            } else {
+                eink_pack2_row(out,
+                               eink_convert_tile[y % EINK_CONVERT_TILE_ROWS],
+                               EINK_WIDTH, y, dither);
+            }
+        }
+        break;
+    case EINK_CONVERT_ROTATE_90:
+    case EINK_CONVERT_ROTATE_180:
+    case EINK_CONVERT_ROTATE_270:
+        if (reference) {
+            eink_convert_ref_rotate(out, src, kernel - EINK_CONVERT_ROTATE_90 +
+                                              EINK_ROTATE_90);
+        } else {
+            eink_rotate1(out, kernel == EINK_CONVERT_ROTATE_180 ?
+                              EINK_STRIDE : EINK_HEIGHT / 8,
+                         src, EINK_STRIDE, EINK_WIDTH, EINK_HEIGHT,
+                         kernel - EINK_CONVERT_ROTATE_90 + EINK_ROTATE_90);
+        }
+        break;
+    case EINK_CONVERT_BLIT:
+        memset(out, 0, EINK_FB_SIZE);
+        if (reference) {
+            eink_convert_ref_blit(out, src, 3, EINK_WIDTH - 8);
+        } else {
+            for (y = 0; y < EINK_HEIGHT; y++) {
+                eink_blit1_row(out + y * EINK_STRIDE, 3,
+                               src + y * EINK_STRIDE, EINK_WIDTH - 8);
+            }
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Time every conversion kernel and check it against its reference
+ * @return number of kernels whose output differs from the reference
+ */
+static unsigned int eink_convert_bench(void)
+{
+    uint32_t kernel_us, ref_us, start;
+    unsigned int failures = 0;
+    unsigned int kernel;
+    unsigned int i, x, y;
+    size_t size;
+    bool match;
+
+    /* Gradient with noise, to hit every threshold */
+    for (y = 0; y < EINK_CONVERT_TILE_ROWS; y++) {
+        for (x = 0; x < EINK_WIDTH; x++) {
+            eink_convert_tile[y][x] = x * 2 + ((x * 37 + y * 101) & 0x0f);
+        }
+    }
+
+    eink_convert_source();
+
+    for (kernel = 0; kernel < EINK_CONVERT_NUM_KERNELS; kernel++) {
+        start = eink_convert_now();
+        for (i = 0; i < EINK_CONVERT_REPEAT; i++) {
+            eink_convert_run(kernel, false);
+        }
+        kernel_us = (eink_convert_now() - start) / EINK_CONVERT_REPEAT;
+
+        start = eink_convert_now();
+        for (i = 0; i < EINK_CONVERT_REPEAT; i++) {
+            eink_convert_run(kernel, true);
+        }
+        ref_us = (eink_convert_now() - start) / EINK_CONVERT_REPEAT;
+
+        if (kernel >= EINK_CONVERT_ROTATE_90) {
+            match = !memcmp(eink_convert_out[1],
+                            &eink_convert_out[1][EINK_FB_SIZE], EINK_FB_SIZE);
+        } else {
+            size = kernel >= EINK_CONVERT_PACK2 ? 2 * EINK_FB_SIZE :
+                                                  EINK_FB_SIZE;
+            match = !memcmp(eink_convert_out[0], eink_convert_out[1], size);
+            /* The packers overwrote the source frame */
+            eink_convert_source();
+        }
+
+        if (!match) {
+            failures++;
+        }
+
+        lowsyslog("eink-convert: %s: %u us per %ux%u frame, "
+                  "per-pixel reference %u us: %s\n",
+                  eink_convert_names[kernel], kernel_us, EINK_WIDTH,
+                  EINK_HEIGHT, ref_us, bench_match(match));
+    }
+
+    return failures;
+}
+
+int eink_panel_model_bench(void)
+{
+    const struct eink_panel_model_budget *budget;
+    struct eink_panel_model_update log[EINK_PANEL_MODEL_LOG_SIZE];
+    struct eink_panel_model_stats stats;
+    unsigned int failures = 0;
+    unsigned int count;
+    unsigned int i, j;
+    uint32_t latency;
+    bool regression;
+    int ret;
+
+    for (i = 0; i < ARRAY_SIZE(eink_panel_model_budgets); i++) {
+        budget = &eink_panel_model_budgets[i];
+
+        eink_panel_model_reset_stats();
+        ret = 0;
+        for (j = 0; j < budget->updates && !ret; j++) {
+            eink_bench_draw(i, j);
+            ret = eink_display_flush();
+        }
+        eink_panel_model_get_stats(&stats);
+
+        latency = stats.bus_us + stats.waveform_us;
+        regression = stats.windows > budget->max_windows ||
+                     stats.bytes > budget->max_bytes ||
+                     stats.full_updates != budget->full_updates ||
+                     latency > budget->max_latency_us;
+        if (ret || regression) {
+            failures++;
+        }
+
+        lowsyslog("eink-bench: %s: %u windows (%u max), %u image bytes, "
+                  "%u bytes (%u max), bus %u us, %u partial, %u full, "
+                  "latency %u us (%u max): %s\n",
+                  budget->name, stats.windows, budget->max_windows,
+                  stats.ram_bytes, stats.bytes, budget->max_bytes,
+                  stats.bus_us, stats.partial_updates, stats.full_updates,
+                  latency, budget->max_latency_us,
+                  bench_verdict(ret, regression));
+
+        count = eink_panel_model_get_log(log, ARRAY_SIZE(log));
+        for (j = 0; j < count; j++) {
+            lowsyslog("eink-bench:   x %u-%u y %u-%u %s\n",
+                      log[j].region.x0 * 8, log[j].region.x1 * 8,
+                      log[j].region.y0, log[j].region.y1,
+                      log[j].waveform == EINK_WAVEFORM_FULL ? "full" :
+                                                              "partial");
+        }
+    }
+
+    bench_summary("eink-bench", "scenarios",
+                  ARRAY_SIZE(eink_panel_model_budgets), failures);
+
+    failures += eink_convert_bench();
+
+    return failures ? -EINVAL : 0;
+}
+
+#endif /* CONFIG_ARA_EINK_PANEL_MODEL */
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FDK_EINK_PANEL_MODEL_H
+#define FDK_EINK_PANEL_MODEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <nuttx/config.h>
+#include <nuttx/gpio.h>
+#include <nuttx/spi/spi.h>
+
+#include "eink_display.h"
+
+/*
+ * Stand-in for the SSD1680 panel, used to measure the display update engine
+ * without a panel. Add CONFIG_ARA_EINK_PANEL_MODEL=y to the module config to
+ * replace the panel SPI bus and control lines with the model and run the
+ * benchmark at boot. The busy line never asserts: the waveform time is
+ * accounted in the statistics instead of being waited for.
+ */
+
+/* Waveform durations of a 2.9" panel at room temperature */
+#define EINK_PANEL_MODEL_PARTIAL_US     300000
+#define EINK_PANEL_MODEL_FULL_US        1500000
+
+#define EINK_PANEL_MODEL_LOG_SIZE       16
+
+/**
+ * @brief Transfer and timing statistics accumulated by the model
+ */
+struct eink_panel_model_stats {
+    /** Number of command bytes */
+    uint32_t commands;
+    /** Bytes on the wire, commands and parameters included */
+    uint32_t bytes;
+    /** Image bytes written to the new image RAM */
+    uint32_t ram_bytes;
+    /** Number of windows written to the new image RAM */
+    uint32_t windows;
+    /** Simulated bus time in microseconds */
+    uint32_t bus_us;
+    uint32_t partial_updates;
+    uint32_t full_updates;
+    /** Simulated waveform time in microseconds */
+    uint32_t waveform_us;
+};
+
+/**
+ * @brief A window written to the new image RAM and how it was displayed
+ */
+struct eink_panel_model_update {
+    struct eink_region region;
+    enum eink_waveform waveform;
+};
+
+#ifdef CONFIG_ARA_EINK_PANEL_MODEL
+
+struct spi_dev_s *eink_panel_model_spiinitialize(int port);
+
+void eink_panel_model_gpio_set(uint8_t which, uint8_t value);
+uint8_t eink_panel_model_gpio_get(uint8_t which);
+
+void eink_panel_model_get_stats(struct eink_panel_model_stats *stats);
+void eink_panel_model_reset_stats(void);
+
+/**
+ * @brief Get the windows displayed since the last statistics reset
+ * @param log Output array
+ * @param size Number of entries of the output array
+ * @return number of entries filled
+ */
+unsigned int eink_panel_model_get_log(struct eink_panel_model_update *log,
+                                      unsigned int size);
+
+/**
+ * @brief Run the display update scenarios against the model
+ * @return 0 if all scenarios are within budget, -EINVAL otherwise
+ */
+int eink_panel_model_bench(void);
+
+/* Route the display engine's bus and control line accesses to the model. */
+#define up_spiinitialize(port)          eink_panel_model_spiinitialize(port)
+#define gpio_set_value(which, value)    eink_panel_model_gpio_set(which, value)
+#define gpio_get_value(which)           eink_panel_model_gpio_get(which)
+
+#endif /* CONFIG_ARA_EINK_PANEL_MODEL */
+
+#endif /* FDK_EINK_PANEL_MODEL_H */
@@ -2,6 +2,10 @@ config		= config
 manifest	= manifest.mnfs
 board-files	= board.c
 board-files	+= eink.c
+board-files	+= eink_convert.c
+board-files	+= eink_display.c
+board-files	+= eink_panel_model.c
+board-files	+= common/timer_wheel.c
 
 vendor_id      = 0x18D1
 product_id     = 0x1234
@@ -0,0 +1,10 @@
+config		= config
+manifest	= manifest.mnfs
+board-files	= board.c
+board-files	+= touch.c
+board-files	+= touch_model.c
+board-files	+= common/i2c_trace.c
+board-files	+= common/timer_wheel.c
+
+vendor_id      = 0x18D1
+product_id     = 0x1236
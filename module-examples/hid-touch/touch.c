@@ -0,0 +1,819 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Multi-touch HID device for an I2C touch controller.
+ *
+ * The controller pulls its interrupt line low once per scan while touched.
+ * Each scan is read in one burst starting at TD_STATUS, sized for one more
+ * contact than the previous scan held, and merged into the contact slots.
+ * Every contact goes out in one report (parallel mode), and reports are rate
+ * limited: a contact landing or lifting is sent right away, motion at most
+ * once per report interval with the latest positions. A report identical to
+ * the last one sent is dropped.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include <nuttx/config.h>
+#include <nuttx/lib.h>
+#include <nuttx/gpio.h>
+#include <nuttx/clock.h>
+#include <nuttx/device_hid.h>
+#include <nuttx/i2c.h>
+#include <nuttx/wqueue.h>
+
+#include <arch/irq.h>
+
+#include "common/i2c_trace.h"
+#include "common/timer_wheel.h"
+
+#include "touch.h"
+#include "touch_model.h"
+
+#define VENDORID                0x18D1  /* need discussion */
+#define PRODUCTID               0x1236  /* need discussion */
+
+/* Bytes of a burst holding every point */
+#define TOUCH_BURST_MAX         (1 + TOUCH_MAX_CONTACTS * TOUCH_POINT_SIZE)
+
+/* Size of the feature reports: report ID and one value */
+#define TOUCH_FEATURE_SIZE      2
+
+/**
+ * State of a contact slot
+ */
+enum touch_slot_state {
+    TOUCH_SLOT_FREE,
+    TOUCH_SLOT_DOWN,
+    /** Lifted, the next report carries it with the tip switch off */
+    TOUCH_SLOT_LIFTED,
+};
+
+struct touch_slot {
+    uint8_t state;
+    uint8_t id;
+    uint16_t x;
+    uint16_t y;
+};
+
+/**
+ * Touch panel state
+ */
+struct touch_info {
+    struct i2c_dev_s *i2c;
+
+    struct touch_slot slots[TOUCH_MAX_CONTACTS];
+
+    /** Points read by the next burst */
+    unsigned int burst;
+
+    /** Minimum time between two reports carrying only motion */
+    uint8_t interval_ms;
+
+    /** Report of the latest scan, and the last one sent */
+    struct touch_report current;
+    struct touch_report sent;
+    /** Time the last report was sent, in microseconds */
+    uint32_t sent_time;
+    /** current differs from sent and waits for the interval */
+    bool pending;
+
+    bool powered;
+
+    struct work_s irq_work;
+    struct wheel_timer report_timer;
+};
+
+static struct device *touch_dev = NULL;
+
+static struct touch_info touch = {
+    .burst = 1,
+    .interval_ms = TOUCH_DEFAULT_INTERVAL_MS,
+};
+
+/* One finger of the input report, see struct touch_contact_report */
+#define TOUCH_FINGER_DESC \
+    0x05, 0x0d,         /*   USAGE_PAGE (Digitizers) */ \
+    0x09, 0x22,         /*   USAGE (Finger) */ \
+    0xa1, 0x02,         /*   COLLECTION (Logical) */ \
+    0x09, 0x42,         /*     USAGE (Tip Switch) */ \
+    0x15, 0x00,         /*     LOGICAL_MINIMUM (0) */ \
+    0x25, 0x01,         /*     LOGICAL_MAXIMUM (1) */ \
+    0x75, 0x01,         /*     REPORT_SIZE (1) */ \
+    0x95, 0x01,         /*     REPORT_COUNT (1) */ \
+    0x81, 0x02,         /*     INPUT (Data,Var,Abs) */ \
+    0x95, 0x07,         /*     REPORT_COUNT (7) */ \
+    0x81, 0x03,         /*     INPUT (Cnst,Var,Abs) */ \
+    0x09, 0x51,         /*     USAGE (Contact Identifier) */ \
+    0x25, TOUCH_ID_MAX, /*     LOGICAL_MAXIMUM (14) */ \
+    0x75, 0x08,         /*     REPORT_SIZE (8) */ \
+    0x95, 0x01,         /*     REPORT_COUNT (1) */ \
+    0x81, 0x02,         /*     INPUT (Data,Var,Abs) */ \
+    0x05, 0x01,         /*     USAGE_PAGE (Generic Desktop) */ \
+    0x26, 0xff, 0x0f,   /*     LOGICAL_MAXIMUM (4095) */ \
+    0x75, 0x10,         /*     REPORT_SIZE (16) */ \
+    0x09, 0x30,         /*     USAGE (X) */ \
+    0x81, 0x02,         /*     INPUT (Data,Var,Abs) */ \
+    0x09, 0x31,         /*     USAGE (Y) */ \
+    0x81, 0x02,         /*     INPUT (Data,Var,Abs) */ \
+    0xc0                /*   END_COLLECTION */
+
+/**
+ * Report descriptor: the touch screen, with its contact count maximum
+ * feature, and a vendor feature holding the report interval in ms, a multiple
+ * of the 10 ms system tick
+ */
+static uint8_t touch_report_desc[] = {
+    0x05, 0x0d,         /* USAGE_PAGE (Digitizers) */
+    0x09, 0x04,         /* USAGE (Touch Screen) */
+    0xa1, 0x01,         /* COLLECTION (Application) */
+    0x85, TOUCH_REPORT_ID_INPUT,    /* REPORT_ID */
+    TOUCH_FINGER_DESC,
+    TOUCH_FINGER_DESC,
+    TOUCH_FINGER_DESC,
+    TOUCH_FINGER_DESC,
+    TOUCH_FINGER_DESC,
+    0x05, 0x0d,         /*   USAGE_PAGE (Digitizers) */
+    0x55, 0x0c,         /*   UNIT_EXPONENT (-4) */
+    0x66, 0x01, 0x10,   /*   UNIT (Seconds) */
+    0x47, 0xff, 0xff, 0x00, 0x00,   /* PHYSICAL_MAXIMUM (65535) */
+    0x27, 0xff, 0xff, 0x00, 0x00,   /* LOGICAL_MAXIMUM (65535) */
+    0x75, 0x10,         /*   REPORT_SIZE (16) */
+    0x95, 0x01,         /*   REPORT_COUNT (1) */
+    0x09, 0x56,         /*   USAGE (Scan Time) */
+    0x81, 0x02,         /*   INPUT (Data,Var,Abs) */
+    0x55, 0x00,         /*   UNIT_EXPONENT (0) */
+    0x65, 0x00,         /*   UNIT (None) */
+    0x45, 0x00,         /*   PHYSICAL_MAXIMUM (0) */
+    0x09, 0x54,         /*   USAGE (Contact Count) */
+    0x25, TOUCH_MAX_CONTACTS,       /* LOGICAL_MAXIMUM */
+    0x75, 0x08,         /*   REPORT_SIZE (8) */
+    0x81, 0x02,         /*   INPUT (Data,Var,Abs) */
+    0x85, TOUCH_REPORT_ID_MAX_COUNT,    /* REPORT_ID */
+    0x09, 0x55,         /*   USAGE (Contact Count Maximum) */
+    0xb1, 0x02,         /*   FEATURE (Data,Var,Abs) */
+    0xc0,               /* END_COLLECTION */
+    0x06, 0x00, 0xff,   /* USAGE_PAGE (Vendor Defined Page 1) */
+    0x09, 0x01,         /* USAGE (Vendor Usage 1) */
+    0xa1, 0x01,         /* COLLECTION (Application) */
+    0x85, TOUCH_REPORT_ID_INTERVAL,     /* REPORT_ID */
+    0x09, 0x02,         /*   USAGE (Vendor Usage 2) */
+    0x15, 0x0a,         /*   LOGICAL_MINIMUM (10) */
+    0x26, 0xfa, 0x00,   /*   LOGICAL_MAXIMUM (250) */
+    0x75, 0x08,         /*   REPORT_SIZE (8) */
+    0x95, 0x01,         /*   REPORT_COUNT (1) */
+    0xb1, 0x02,         /*   FEATURE (Data,Var,Abs) */
+    0xc0                /* END_COLLECTION */
+};
+
+/**
+ * Touch HID Device Descriptor
+ */
+static struct hid_descriptor touch_dev_desc = {
+    0x0A,
+    sizeof(touch_report_desc),
+    0x0111, /* HID v1.11 compliant */
+    PRODUCTID,
+    VENDORID,
+    0x00, /* no country code */
+};
+
+/**
+ * report length of each HID Reports in HID Report Descriptor, report ID
+ * included
+ */
+static struct hid_size_info touch_sizeinfo[] = {
+    { .id = TOUCH_REPORT_ID_INPUT,
+      .reports = {
+          .size = { sizeof(struct touch_report), 0, 0 }
+       }
+    },
+    { .id = TOUCH_REPORT_ID_MAX_COUNT,
+      .reports = {
+          .size = { 0, 0, TOUCH_FEATURE_SIZE }
+       }
+    },
+    { .id = TOUCH_REPORT_ID_INTERVAL,
+      .reports = {
+          .size = { 0, 0, TOUCH_FEATURE_SIZE }
+       }
+    },
+};
+
+static uint32_t touch_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief Read consecutive controller registers in one transaction
+ *
+ * @param reg First register
+ * @param buf Output buffer
+ * @param len Number of registers to read
+ * @return 0 on success, negative errno on error
+ */
+static int touch_read_regs(uint8_t reg, uint8_t *buf, size_t len)
+{
+    struct i2c_msg_s msg[] = {
+        {
+            .addr = TOUCH_I2C_ADDR,
+            .flags = 0,
+            .buffer = &reg,
+            .length = 1,
+        }, {
+            .addr = TOUCH_I2C_ADDR,
+            .flags = I2C_M_READ,
+            .buffer = buf,
+            .length = len,
+        }
+    };
+
+    return i2c_trace_transfer(touch.i2c, msg, 2);
+}
+
+/**
+ * @brief Read TD_STATUS and the points of a scan
+ *
+ * The burst holds one more contact than the previous scan, so that a finger
+ * landing is read with the others. More fingers landing within one scan
+ * cost a second read for the remaining points.
+ *
+ * @param buf Output buffer, TD_STATUS then the points
+ * @return number of contacts, negative errno on error
+ */
+static int touch_read_scan(uint8_t *buf)
+{
+    unsigned int burst = touch.burst;
+    unsigned int count;
+    int ret;
+
+    ret = touch_read_regs(TOUCH_REG_TD_STATUS, buf,
+                          1 + burst * TOUCH_POINT_SIZE);
+    if (ret) {
+        return ret;
+    }
+
+    /* The count reads 0xf while the controller initializes. */
+    count = buf[0] & 0x0f;
+    if (count > TOUCH_MAX_CONTACTS) {
+        count = 0;
+    }
+
+    if (count > burst) {
+        ret = touch_read_regs(TOUCH_REG_POINTS + burst * TOUCH_POINT_SIZE,
+                              buf + 1 + burst * TOUCH_POINT_SIZE,
+                              (count - burst) * TOUCH_POINT_SIZE);
+        if (ret) {
+            return ret;
+        }
+    }
+
+    touch.burst = count < TOUCH_MAX_CONTACTS ? count + 1 : TOUCH_MAX_CONTACTS;
+
+    return count;
+}
+
+/**
+ * @brief Merge a scan into the contact slots
+ *
+ * @param buf Scan read by touch_read_scan()
+ * @param count Number of contacts in the scan
+ * @return true if a contact landed or lifted
+ */
+static bool touch_merge(const uint8_t *buf, unsigned int count)
+{
+    struct touch_slot *slot;
+    struct touch_slot *free;
+    const uint8_t *point;
+    uint8_t seen = 0;
+    bool edge = false;
+    unsigned int i, j;
+    uint8_t id;
+
+    for (i = 0; i < count; i++) {
+        point = buf + 1 + i * TOUCH_POINT_SIZE;
+        id = point[2] >> 4;
+        if (id > TOUCH_ID_MAX || (point[0] >> 6) == TOUCH_EVENT_UP) {
+            continue;
+        }
+
+        slot = NULL;
+        free = NULL;
+        for (j = 0; j < TOUCH_MAX_CONTACTS; j++) {
+            if (touch.slots[j].state == TOUCH_SLOT_DOWN &&
+                touch.slots[j].id == id) {
+                slot = &touch.slots[j];
+                break;
+            }
+
+            if (!free && touch.slots[j].state == TOUCH_SLOT_FREE) {
+                free = &touch.slots[j];
+            }
+        }
+
+        if (!slot) {
+            /* Every slot holds a contact or a lift not reported yet */
+            if (!free) {
+                continue;
+            }
+
+            slot = free;
+            slot->state = TOUCH_SLOT_DOWN;
+            slot->id = id;
+            edge = true;
+        }
+
+        slot->x = ((point[0] & 0x0f) << 8) | point[1];
+        slot->y = ((point[2] & 0x0f) << 8) | point[3];
+        seen |= 1 << (slot - touch.slots);
+    }
+
+    for (j = 0; j < TOUCH_MAX_CONTACTS; j++) {
+        if (touch.slots[j].state == TOUCH_SLOT_DOWN && !(seen & (1 << j))) {
+            touch.slots[j].state = TOUCH_SLOT_LIFTED;
+            edge = true;
+        }
+    }
+
+    return edge;
+}
+
+/**
+ * @brief Build a report from the contact slots
+ *
+ * @param report Report to fill
+ * @param now Time of the scan, in microseconds
+ */
+static void touch_build_report(struct touch_report *report, uint32_t now)
+{
+    struct touch_contact_report *contact;
+    const struct touch_slot *slot;
+    unsigned int i;
+
+    memset(report, 0, sizeof(*report));
+    report->report_id = TOUCH_REPORT_ID_INPUT;
+    report->scan_time = now / 100;
+
+    for (i = 0; i < TOUCH_MAX_CONTACTS; i++) {
+        slot = &touch.slots[i];
+        if (slot->state == TOUCH_SLOT_FREE) {
+            continue;
+        }
+
+        contact = &report->contacts[report->count++];
+        contact->flags = slot->state == TOUCH_SLOT_DOWN ? TOUCH_FLAG_TIP : 0;
+        contact->id = slot->id;
+        contact->x = slot->x;
+        contact->y = slot->y;
+    }
+}
+
+/* The scan time changes with every scan and does not count. */
+static bool touch_report_changed(void)
+{
+    return touch.current.count != touch.sent.count ||
+           memcmp(touch.current.contacts, touch.sent.contacts,
+                  sizeof(touch.current.contacts));
+}
+
+/**
+ * @brief Send the report of the latest scan
+ *
+ * @param now Current time, in microseconds
+ * @return 0 on success, negative errno on error
+ */
+static int touch_send_report(uint32_t now)
+{
+    struct device *dev = touch_dev;
+    struct touch_report report;
+    struct hid_info *info;
+    irqstate_t flags;
+    unsigned int i;
+    int ret;
+
+    if (!dev || !device_get_private(dev)) {
+        return -ENODEV;
+    }
+
+    info = device_get_private(dev);
+    if (!info->event_callback) {
+        return -ENODEV;
+    }
+
+    ret = info->event_callback(dev, HID_INPUT_REPORT,
+                               (uint8_t *)&touch.current,
+                               sizeof(touch.current));
+    if (ret) {
+        return ret;
+    }
+
+    /*
+     * The host has seen the lifts, free their slots. The report without
+     * them is what the host now knows, so the next scan does not resend it.
+     */
+    for (i = 0; i < TOUCH_MAX_CONTACTS; i++) {
+        if (touch.slots[i].state == TOUCH_SLOT_LIFTED) {
+            touch.slots[i].state = TOUCH_SLOT_FREE;
+        }
+    }
+
+    touch_build_report(&report, now);
+
+    flags = irqsave();
+    touch.current = report;
+    irqrestore(flags);
+
+    touch.sent = report;
+    touch.sent_time = now;
+    touch.pending = false;
+
+    return 0;
+}
+
+bool touch_sample(uint32_t now, uint32_t *deadline)
+{
+    uint32_t interval = touch.interval_ms * 1000;
+    uint8_t buf[TOUCH_BURST_MAX];
+    struct touch_report report;
+    irqstate_t flags;
+    bool edge;
+    int count;
+
+    count = touch_read_scan(buf);
+    if (count < 0) {
+        *deadline = touch.sent_time + interval;
+        return touch.pending;
+    }
+
+    edge = touch_merge(buf, count);
+    touch_build_report(&report, now);
+
+    flags = irqsave();
+    touch.current = report;
+    irqrestore(flags);
+
+    /* Back where the host last saw it, or not moved: nothing to send. */
+    if (!touch_report_changed()) {
+        touch.pending = false;
+        return false;
+    }
+
+    touch.pending = true;
+
+    if (edge || now - touch.sent_time >= interval) {
+        if (!touch_send_report(now)) {
+            return false;
+        }
+
+        *deadline = now + interval;
+        return true;
+    }
+
+    /* Motion within the interval waits, later scans replace it. */
+    *deadline = touch.sent_time + interval;
+    return true;
+}
+
+bool touch_report_timeout(uint32_t now, uint32_t *deadline)
+{
+    if (!touch.pending) {
+        return false;
+    }
+
+    if (!touch_send_report(now)) {
+        return false;
+    }
+
+    *deadline = now + touch.interval_ms * 1000;
+    return true;
+}
+
+/**
+ * @brief Arm the report timer for a deferred report
+ *
+ * @param now Current time, in microseconds
+ * @param deadline Time of the report, in microseconds
+ */
+static void touch_arm_report(uint32_t now, uint32_t deadline)
+{
+    uint32_t delay = (int32_t)(deadline - now) > 0 ? deadline - now : 0;
+
+    timer_wheel_arm(&touch.report_timer, (delay + 999) / 1000);
+}
+
+/* Report timer expiry, from the timer wheel */
+static void touch_report_worker(void *data)
+{
+    uint32_t now = touch_now();
+    uint32_t deadline;
+
+    if (touch_report_timeout(now, &deadline)) {
+        touch_arm_report(now, deadline);
+    }
+}
+
+/**
+ * @brief Read the scan signalled by the controller interrupt
+ *
+ * @param data Unused
+ */
+static void touch_irq_worker(void *data)
+{
+    uint32_t now = touch_now();
+    uint32_t deadline;
+
+    if (touch_sample(now, &deadline)) {
+        touch_arm_report(now, deadline);
+    } else {
+        timer_wheel_cancel(&touch.report_timer);
+    }
+
+    if (touch.powered) {
+        gpio_irq_unmask(TOUCH_GPIO_INT);
+    }
+}
+
+/**
+ * @brief Controller interrupt: a scan is ready
+ *
+ * The interrupt stays masked until the scan has been read.
+ *
+ * @param irq IRQ number, same as GPIO number.
+ * @param context Unused
+ * @return 0 on success, negative errno on error
+ */
+static int touch_handle_irq(int irq, FAR void *context)
+{
+    gpio_irq_mask(irq);
+
+    if (!touch_dev) {
+        return ERROR;
+    }
+
+    work_queue(HPWORK, &touch.irq_work, touch_irq_worker, NULL, 0);
+
+    return OK;
+}
+
+/**
+ * @brief Forget every contact
+ */
+static void touch_reset_state(void)
+{
+    irqstate_t flags;
+
+    memset(touch.slots, 0, sizeof(touch.slots));
+    touch.burst = 1;
+    touch.pending = false;
+    touch_build_report(&touch.sent, 0);
+
+    flags = irqsave();
+    touch.current = touch.sent;
+    irqrestore(flags);
+}
+
+/**
+ * @brief Stop reading the controller
+ */
+static void touch_stop(void)
+{
+    touch.powered = false;
+    gpio_irq_mask(TOUCH_GPIO_INT);
+    work_cancel(HPWORK, &touch.irq_work);
+    timer_wheel_cancel(&touch.report_timer);
+    touch_reset_state();
+}
+
+/**
+ * @brief Get HID Input report data
+ *
+ * @param dev Pointer to structure of device data
+ * @param report_id HID report id
+ * @param data Pointer of input buffer size
+ * @param len Max input buffer size
+ * @return 0 on success, negative for error
+ */
+static int touch_get_input_report(struct device *dev, uint8_t report_id,
+                                  uint8_t *data, uint16_t len)
+{
+    irqstate_t flags;
+
+    if (report_id != TOUCH_REPORT_ID_INPUT) {
+        return -EIO;
+    }
+
+    if (len < sizeof(struct touch_report)) {
+        return -EINVAL;
+    }
+
+    flags = irqsave();
+    memcpy(data, &touch.current, sizeof(touch.current));
+    irqrestore(flags);
+
+    return 0;
+}
+
+/**
+ * @brief Get HID Feature report data
+ *
+ * @param dev Pointer to structure of device data
+ * @param report_id HID report id
+ * @param data Pointer of feature buffer
+ * @param len Max feature buffer size
+ * @return 0 on success, negative for error
+ */
+static int touch_get_feature_report(struct device *dev, uint8_t report_id,
+                                    uint8_t *data, uint16_t len)
+{
+    if (len < TOUCH_FEATURE_SIZE) {
+        return -EINVAL;
+    }
+
+    switch (report_id) {
+    case TOUCH_REPORT_ID_MAX_COUNT:
+        data[1] = TOUCH_MAX_CONTACTS;
+        break;
+    case TOUCH_REPORT_ID_INTERVAL:
+        data[1] = touch.interval_ms;
+        break;
+    default:
+        return -EIO;
+    }
+
+    data[0] = report_id;
+
+    return 0;
+}
+
+/**
+ * @brief Set the report interval from the host
+ *
+ * The interval is in ms and must be a whole number of system ticks: the
+ * report timer cannot wait for a fraction of a tick.
+ *
+ * @param dev Pointer to structure of device data
+ * @param report_type HID report type
+ * @param report_id HID report id
+ * @param data Report, report ID first
+ * @param len Report size
+ * @return 0 on success, negative for error
+ */
+static int touch_set_report(struct device *dev, uint8_t report_type,
+                            uint8_t report_id, uint8_t *data, uint16_t len)
+{
+    if (report_type != HID_FEATURE_REPORT ||
+        report_id != TOUCH_REPORT_ID_INTERVAL) {
+        return -EINVAL;
+    }
+
+    if (len < TOUCH_FEATURE_SIZE || !data[1] || data[1] % MSEC_PER_TICK) {
+        return -EINVAL;
+    }
+
+    touch.interval_ms = data[1];
+
+    return 0;
+}
+
+static int touch_get_report(struct device *dev, uint8_t report_type,
+                            uint8_t report_id, uint8_t *data, uint16_t len)
+{
+    switch (report_type) {
+    case HID_INPUT_REPORT:
+        return touch_get_input_report(dev, report_id, data, len);
+    case HID_FEATURE_REPORT:
+        return touch_get_feature_report(dev, report_id, data, len);
+    default:
+        return -EINVAL;
+    }
+}
+
+/**
+ * @brief Open the controller bus and its interrupt line
+ *
+ * @param dev Pointer to structure of device data
+ * @param dev_info The pointer for hid_info struct
+ *
+ * @return 0 on success, negative errno on error
+ */
+static int touch_hw_initialize(struct device *dev, struct hid_info *dev_info)
+{
+    uint8_t status;
+    int ret;
+
+    touch.i2c = up_i2cinitialize(TOUCH_I2C_PORT);
+    if (!touch.i2c) {
+        return -ENODEV;
+    }
+
+    /* Make sure the controller answers. */
+    ret = touch_read_regs(TOUCH_REG_TD_STATUS, &status, 1);
+    if (ret) {
+        goto err_i2c;
+    }
+
+    ret = gpio_activate(TOUCH_GPIO_INT);
+    if (ret) {
+        goto err_i2c;
+    }
+
+    gpio_direction_in(TOUCH_GPIO_INT);
+    gpio_irq_mask(TOUCH_GPIO_INT);
+    gpio_irq_settriggering(TOUCH_GPIO_INT, IRQ_TYPE_EDGE_FALLING);
+    gpio_irq_attach(TOUCH_GPIO_INT, touch_handle_irq);
+
+    timer_wheel_setup(&touch.report_timer, touch_report_worker, NULL);
+    touch_reset_state();
+
+    return 0;
+
+err_i2c:
+    up_i2cuninitialize(touch.i2c);
+    touch.i2c = NULL;
+    return ret;
+}
+
+/**
+ * @brief Release the controller bus and its interrupt line
+ *
+ * @param dev Pointer to structure of device data
+ *
+ * @return 0 on success, negative errno on error
+ */
+static int touch_hw_deinitialize(struct device *dev)
+{
+    touch_stop();
+    gpio_deactivate(TOUCH_GPIO_INT);
+
+    up_i2cuninitialize(touch.i2c);
+    touch.i2c = NULL;
+
+    return 0;
+}
+
+static int touch_power_set(struct device *dev, bool on)
+{
+    if (!on) {
+        touch_stop();
+        return 0;
+    }
+
+    touch.powered = true;
+    gpio_irq_unmask(TOUCH_GPIO_INT);
+
+    return 0;
+}
+
+static struct hid_vendor_ops touch_ops = {
+    .hw_initialize = touch_hw_initialize,
+    .hw_deinitialize = touch_hw_deinitialize,
+    .power_control = touch_power_set,
+    .get_report = touch_get_report,
+    .set_report = touch_set_report,
+};
+
+int hid_device_init(struct device *dev, struct hid_info *dev_info)
+{
+    dev_info->hdesc = &touch_dev_desc;
+    dev_info->rdesc = touch_report_desc;
+    dev_info->sinfo = touch_sizeinfo;
+    dev_info->num_ids = ARRAY_SIZE(touch_sizeinfo);
+    dev_info->hid_dev_ops = &touch_ops;
+    touch_dev = dev;
+
+    return 0;
+}
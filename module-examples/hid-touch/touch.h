@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FDK_HID_TOUCH_H
+#define FDK_HID_TOUCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <nuttx/compiler.h>
+
+/* Touch controller wiring */
+#define TOUCH_I2C_PORT                  0
+#define TOUCH_I2C_ADDR                  0x38
+#define TOUCH_GPIO_INT                  2
+
+/* Controller registers, FocalTech FT5x06 layout */
+#define TOUCH_REG_TD_STATUS             0x02    /* contacts in bits 3:0 */
+#define TOUCH_REG_POINTS                0x03    /* first contact */
+#define TOUCH_POINT_SIZE                6
+#define TOUCH_MAX_CONTACTS              5
+#define TOUCH_COORD_MAX                 4095
+
+/* Contact event, bits 7:6 of the first byte of a point */
+#define TOUCH_EVENT_DOWN                0
+#define TOUCH_EVENT_UP                  1
+#define TOUCH_EVENT_CONTACT             2
+
+/* Contact identifiers above this one mark an empty point */
+#define TOUCH_ID_MAX                    0x0e
+
+/* HID reports: contacts, contact count maximum, report interval */
+#define TOUCH_REPORT_ID_INPUT           1
+#define TOUCH_REPORT_ID_MAX_COUNT       2
+#define TOUCH_REPORT_ID_INTERVAL        3
+
+/*
+ * Default time between two reports carrying only motion. The report timer
+ * runs on the system tick, so intervals are whole ticks (MSEC_PER_TICK, 10 ms
+ * in the module config) and deferred reports go out on a tick boundary.
+ */
+#define TOUCH_DEFAULT_INTERVAL_MS       10
+
+/* Tip switch bit of touch_contact_report.flags */
+#define TOUCH_FLAG_TIP                  0x01
+
+/**
+ * One contact of the input report
+ */
+struct touch_contact_report {
+    uint8_t flags;
+    uint8_t id;
+    uint16_t x;
+    uint16_t y;
+} __packed;
+
+/**
+ * Input report, every contact at once (parallel mode)
+ */
+struct touch_report {
+    uint8_t report_id;
+    struct touch_contact_report contacts[TOUCH_MAX_CONTACTS];
+    /** Time of the controller scan, in 100 us units */
+    uint16_t scan_time;
+    /** Number of valid entries in contacts[] */
+    uint8_t count;
+} __packed;
+
+/*
+ * The two functions below run the driver for one controller interrupt and
+ * one report timer expiry, with the time given by the caller. They are used
+ * by the driver itself and by the controller model to replay traces.
+ */
+
+/**
+ * @brief Read a controller scan, then send or defer a report
+ * @param now Time of the scan, in microseconds
+ * @param deadline Set to the time of the deferred report, if any
+ * @return true if a report waits for the deadline
+ */
+bool touch_sample(uint32_t now, uint32_t *deadline);
+
+/**
+ * @brief Send the report deferred by touch_sample()
+ * @param now Time of the expiry, in microseconds
+ * @param deadline Set to the time of the next attempt, if the report failed
+ * @return true if a report still waits
+ */
+bool touch_report_timeout(uint32_t now, uint32_t *deadline);
+
+#endif /* FDK_HID_TOUCH_H */
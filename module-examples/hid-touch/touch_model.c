@@ -0,0 +1,598 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <nuttx/config.h>
+
+#ifdef CONFIG_ARA_TOUCH_MODEL
+
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+#include <syslog.h>
+
+#include <nuttx/clock.h>
+#include <nuttx/device.h>
+#include <nuttx/device_hid.h>
+#include <nuttx/i2c.h>
+#include <nuttx/util.h>
+
+#include "common/bench.h"
+
+#include "touch.h"
+#include "touch_model.h"
+
+/* Size of the register file */
+#define TOUCH_MODEL_NUM_REGS            64
+
+/* Weight and area reported for every contact */
+#define TOUCH_MODEL_WEIGHT              0x40
+#define TOUCH_MODEL_AREA                0x10
+
+/* Idle time between two traces, longer than any report interval */
+#define TOUCH_MODEL_TRACE_GAP_US        1000000
+
+/**
+ * @brief A finger moving in a straight line
+ */
+struct touch_model_stroke {
+    /** Contact identifier, unique within a trace */
+    uint8_t id;
+    /** Landing and lift, in ms from the start of the trace */
+    uint16_t down_ms;
+    uint16_t up_ms;
+    uint16_t x0, y0;
+    uint16_t x1, y1;
+};
+
+/**
+ * @brief A touch trace and its budget
+ */
+struct touch_model_trace {
+    const char *name;
+    /** Controller scan rate */
+    uint16_t scan_hz;
+    /** Report interval, set through the feature report */
+    uint8_t interval_ms;
+    const struct touch_model_stroke *strokes;
+    unsigned int num_strokes;
+    uint32_t max_reports;
+    uint32_t max_latency_us;
+};
+
+/**
+ * @brief Model state
+ */
+struct touch_model_info {
+    struct i2c_dev_s i2c;
+    uint8_t regs[TOUCH_MODEL_NUM_REGS];
+    uint32_t byte_time_ns;
+    /** Sub-microsecond remainder of the bus time */
+    uint32_t bus_ns;
+    struct touch_model_stats stats;
+
+    /** Trace being replayed, and the simulated time of its start */
+    const struct touch_model_trace *trace;
+    uint32_t base;
+    /** Time of the driver call in progress, and the bus time at its start */
+    uint32_t now;
+    uint32_t bus_mark;
+    /** Oldest scan the host has not seen yet, if waiting */
+    uint32_t change_time;
+    bool waiting;
+
+    /** Last report received, as the host sees the touch screen */
+    struct touch_report report;
+    uint32_t reports;
+    uint32_t latency_sum;
+    uint32_t latency_max;
+    /** Contacts reported down and reported lifted, bit n for id n */
+    uint32_t landed;
+    uint32_t lifted;
+};
+
+static struct touch_model_info touch_model = {
+    .byte_time_ns = TOUCH_MODEL_BYTE_TIME_NS,
+};
+
+static void touch_model_charge_bytes(unsigned int count)
+{
+    touch_model.stats.bytes += count;
+    touch_model.bus_ns += count * touch_model.byte_time_ns;
+    touch_model.stats.bus_us += touch_model.bus_ns / 1000;
+    touch_model.bus_ns %= 1000;
+}
+
+/*
+ * Each transaction starts with a register address and the address
+ * auto-increments for every data byte, as on the real controller.
+ */
+static int touch_model_transfer(struct i2c_dev_s *dev, struct i2c_msg_s *msgs,
+                                int count)
+{
+    uint8_t addr = 0;
+    int i, j;
+
+    touch_model.stats.transactions++;
+
+    for (i = 0; i < count; i++) {
+        struct i2c_msg_s *msg = &msgs[i];
+
+        /* The slave address byte goes on the wire even when NACKed. */
+        if (msg->addr != TOUCH_I2C_ADDR) {
+            touch_model_charge_bytes(1);
+            return -EIO;
+        }
+
+        touch_model_charge_bytes(msg->length + 1);
+
+        if (msg->flags & I2C_M_READ) {
+            for (j = 0; j < msg->length; j++) {
+                msg->buffer[j] = touch_model.regs[addr++ %
+                                                  TOUCH_MODEL_NUM_REGS];
+            }
+            continue;
+        }
+
+        if (msg->length < 1) {
+            return -EIO;
+        }
+
+        addr = msg->buffer[0];
+    }
+
+    return OK;
+}
+
+static const struct i2c_ops_s touch_model_i2c_ops = {
+    .transfer = touch_model_transfer,
+};
+
+struct i2c_dev_s *touch_model_i2cinitialize(int port)
+{
+    touch_model.i2c.ops = &touch_model_i2c_ops;
+    return &touch_model.i2c;
+}
+
+int touch_model_i2cuninitialize(struct i2c_dev_s *dev)
+{
+    return 0;
+}
+
+void touch_model_irq_unmask(uint8_t which)
+{
+}
+
+void touch_model_get_stats(struct touch_model_stats *stats)
+{
+    *stats = touch_model.stats;
+}
+
+void touch_model_reset_stats(void)
+{
+    memset(&touch_model.stats, 0, sizeof(touch_model.stats));
+    touch_model.bus_ns = 0;
+}
+
+static const struct touch_model_stroke touch_model_tap[] = {
+    { 0, 100, 180, 500, 800, 500, 800 },
+};
+
+static const struct touch_model_stroke touch_model_swipe[] = {
+    { 1, 0, 300, 200, 1600, 900, 300 },
+};
+
+static const struct touch_model_stroke touch_model_pinch[] = {
+    { 2, 0, 400, 400, 800, 200, 600 },
+    { 3, 0, 400, 700, 1100, 900, 1300 },
+};
+
+static const struct touch_model_stroke touch_model_hold[] = {
+    { 4, 0, 500, 540, 960, 540, 960 },
+};
+
+/* Five fingers landing in the same scan, then dragged */
+static const struct touch_model_stroke touch_model_grab[] = {
+    { 5, 0, 400, 100, 1000, 100, 600 },
+    { 6, 0, 400, 300, 1000, 300, 600 },
+    { 7, 0, 400, 500, 1000, 500, 600 },
+    { 8, 0, 400, 700, 1000, 700, 600 },
+    { 9, 0, 400, 900, 1000, 900, 600 },
+};
+
+/* Two quick taps, the second landing as the first lifts */
+static const struct touch_model_stroke touch_model_double_tap[] = {
+    { 10, 0, 60, 500, 500, 500, 500 },
+    { 11, 60, 120, 520, 510, 520, 510 },
+};
+
+#define TOUCH_MODEL_TRACE(name, hz, interval, strokes) \
+    name, hz, interval, strokes, ARRAY_SIZE(strokes)
+
+static const struct touch_model_trace touch_model_traces[] = {
+    { TOUCH_MODEL_TRACE("tap", 240, 10, touch_model_tap), 2, 360 },
+    { TOUCH_MODEL_TRACE("swipe", 240, 10, touch_model_swipe), 32, 9210 },
+    { TOUCH_MODEL_TRACE("swipe-20ms", 240, 20, touch_model_swipe), 17,
+      19202 },
+    { TOUCH_MODEL_TRACE("swipe-120hz", 120, 10, touch_model_swipe), 32, 8345 },
+    { TOUCH_MODEL_TRACE("pinch", 240, 10, touch_model_pinch), 42, 9226 },
+    { TOUCH_MODEL_TRACE("hold", 240, 10, touch_model_hold), 2, 360 },
+    { TOUCH_MODEL_TRACE("grab", 240, 10, touch_model_grab), 42, 9226 },
+    { TOUCH_MODEL_TRACE("double-tap", 240, 10, touch_model_double_tap), 3,
+      360 },
+};
+
+/**
+ * @brief Position of a finger at a time of its trace
+ *
+ * @param stroke Finger
+ * @param t Time from the start of the trace, in microseconds
+ * @param x Set to the horizontal position
+ * @param y Set to the vertical position
+ * @return true if the finger is down at that time
+ */
+static bool touch_model_position(const struct touch_model_stroke *stroke,
+                                 uint32_t t, uint16_t *x, uint16_t *y)
+{
+    uint32_t down = stroke->down_ms * 1000;
+    uint32_t up = stroke->up_ms * 1000;
+    int32_t elapsed;
+    int32_t span;
+
+    if (t < down || t >= up) {
+        return false;
+    }
+
+    /* In 100 us units, so that the products fit */
+    elapsed = (t - down) / 100;
+    span = (up - down) / 100;
+
+    *x = stroke->x0 + (stroke->x1 - stroke->x0) * elapsed / span;
+    *y = stroke->y0 + (stroke->y1 - stroke->y0) * elapsed / span;
+
+    return true;
+}
+
+/**
+ * @brief Load the controller registers with a scan
+ *
+ * @param t Time from the start of the trace, in microseconds
+ * @param period Scan period, in microseconds
+ * @return number of contacts in the scan
+ */
+static unsigned int touch_model_load(uint32_t t, uint32_t period)
+{
+    const struct touch_model_trace *trace = touch_model.trace;
+    const struct touch_model_stroke *stroke;
+    unsigned int count = 0;
+    unsigned int i;
+    uint8_t *point;
+    uint8_t event;
+    uint16_t x, y;
+
+    memset(&touch_model.regs[TOUCH_REG_POINTS], 0xff,
+           TOUCH_MAX_CONTACTS * TOUCH_POINT_SIZE);
+
+    for (i = 0; i < trace->num_strokes && count < TOUCH_MAX_CONTACTS; i++) {
+        stroke = &trace->strokes[i];
+        if (!touch_model_position(stroke, t, &x, &y)) {
+            continue;
+        }
+
+        event = t - stroke->down_ms * 1000 < period ? TOUCH_EVENT_DOWN :
+                                                      TOUCH_EVENT_CONTACT;
+
+        point = &touch_model.regs[TOUCH_REG_POINTS +
+                                  count * TOUCH_POINT_SIZE];
+        point[0] = (event << 6) | (x >> 8);
+        point[1] = x & 0xff;
+        point[2] = (stroke->id << 4) | (y >> 8);
+        point[3] = y & 0xff;
+        point[4] = TOUCH_MODEL_WEIGHT;
+        point[5] = TOUCH_MODEL_AREA;
+        count++;
+    }
+
+    touch_model.regs[TOUCH_REG_TD_STATUS] = count;
+
+    return count;
+}
+
+/**
+ * @brief Tell whether the host view differs from a scan
+ *
+ * @param t Time of the scan from the start of the trace, in microseconds
+ * @return true if the last report does not match the scan
+ */
+static bool touch_model_differs(uint32_t t)
+{
+    const struct touch_model_trace *trace = touch_model.trace;
+    const struct touch_contact_report *contact;
+    unsigned int down = 0;
+    unsigned int tips = 0;
+    unsigned int i, j;
+    uint16_t x, y;
+
+    for (i = 0; i < trace->num_strokes; i++) {
+        if (!touch_model_position(&trace->strokes[i], t, &x, &y)) {
+            continue;
+        }
+
+        down++;
+
+        for (j = 0; j < touch_model.report.count; j++) {
+            contact = &touch_model.report.contacts[j];
+            if ((contact->flags & TOUCH_FLAG_TIP) &&
+                contact->id == trace->strokes[i].id &&
+                contact->x == x && contact->y == y) {
+                break;
+            }
+        }
+
+        if (j == touch_model.report.count) {
+            return true;
+        }
+    }
+
+    for (j = 0; j < touch_model.report.count; j++) {
+        tips += touch_model.report.contacts[j].flags & TOUCH_FLAG_TIP;
+    }
+
+    return tips != down;
+}
+
+/* Stands for the HID core, receives the reports sent to the host */
+static int touch_model_event(struct device *dev, uint8_t report_type,
+                             uint8_t *report, uint16_t len)
+{
+    const struct touch_contact_report *contact;
+    uint32_t latency;
+    unsigned int i;
+
+    if (report_type != HID_INPUT_REPORT ||
+        len != sizeof(touch_model.report)) {
+        return -EINVAL;
+    }
+
+    memcpy(&touch_model.report, report, len);
+    touch_model.reports++;
+
+    for (i = 0; i < touch_model.report.count; i++) {
+        contact = &touch_model.report.contacts[i];
+        if (contact->flags & TOUCH_FLAG_TIP) {
+            touch_model.landed |= 1 << contact->id;
+        } else {
+            touch_model.lifted |= 1 << contact->id;
+        }
+    }
+
+    /* The report is sent once the scan has been read over the bus. */
+    if (touch_model.waiting) {
+        latency = touch_model.now - touch_model.change_time +
+                  touch_model.stats.bus_us - touch_model.bus_mark;
+        touch_model.latency_sum += latency;
+        if (latency > touch_model.latency_max) {
+            touch_model.latency_max = latency;
+        }
+        touch_model.waiting = false;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Time the report timer expires when armed for a deadline
+ *
+ * Like the timer wheel, the delay is rounded up to whole ticks counted from
+ * the tick in progress, so the timer expires on a tick boundary.
+ *
+ * @param now Time the timer is armed, in microseconds
+ * @param deadline Requested time, in microseconds
+ * @return the expiry time, in microseconds
+ */
+static uint32_t touch_model_expiry(uint32_t now, uint32_t deadline)
+{
+    uint32_t delay = (int32_t)(deadline - now) > 0 ? deadline - now : 0;
+    uint32_t ms = (delay + 999) / 1000;
+    uint32_t ticks = ms / MSEC_PER_TICK + (ms % MSEC_PER_TICK != 0);
+
+    if (!ticks) {
+        ticks = 1;
+    }
+
+    return (now / (MSEC_PER_TICK * 1000) + ticks) * MSEC_PER_TICK * 1000;
+}
+
+/**
+ * @brief Replay a trace in simulated time
+ *
+ * The controller interrupts once per scan while touched, and once more
+ * after the last lift. Deferred reports are sent when their timer expires
+ * before the next scan.
+ *
+ * @param dev HID device
+ * @param trace Trace to replay
+ * @param scans Set to the number of controller interrupts
+ * @return 0 on success, negative errno on error
+ */
+static int touch_model_replay(struct device *dev,
+                              const struct touch_model_trace *trace,
+                              uint32_t *scans)
+{
+    uint32_t period = 1000000 / trace->scan_hz;
+    uint8_t feature[2];
+    uint32_t deadline = 0;
+    uint32_t expiry = 0;
+    uint32_t end = 0;
+    uint32_t now;
+    uint32_t t;
+    bool pending = false;
+    bool touched = false;
+    unsigned int count;
+    unsigned int i;
+    int ret;
+
+    feature[0] = TOUCH_REPORT_ID_INTERVAL;
+    feature[1] = trace->interval_ms;
+    ret = device_hid_set_report(dev, HID_FEATURE_REPORT,
+                                TOUCH_REPORT_ID_INTERVAL, feature,
+                                sizeof(feature));
+    if (ret) {
+        return ret;
+    }
+
+    for (i = 0; i < trace->num_strokes; i++) {
+        if (trace->strokes[i].up_ms * 1000 > end) {
+            end = trace->strokes[i].up_ms * 1000;
+        }
+    }
+
+    touch_model.trace = trace;
+    *scans = 0;
+
+    for (i = 0, t = 0; t <= end + period; i++, t = i * period) {
+        now = touch_model.base + t;
+
+        while (pending && (int32_t)(expiry - now) <= 0) {
+            touch_model.now = expiry;
+            touch_model.bus_mark = touch_model.stats.bus_us;
+            pending = touch_report_timeout(expiry, &deadline);
+            expiry = touch_model_expiry(expiry, deadline);
+        }
+
+        count = touch_model_load(t, period);
+        if (!count && !touched) {
+            continue;
+        }
+        touched = count != 0;
+
+        if (!touch_model.waiting && touch_model_differs(t)) {
+            touch_model.waiting = true;
+            touch_model.change_time = now;
+        }
+
+        touch_model.now = now;
+        touch_model.bus_mark = touch_model.stats.bus_us;
+        pending = touch_sample(now, &deadline);
+        expiry = touch_model_expiry(now, deadline);
+        (*scans)++;
+    }
+
+    /* A report failing for good would retry forever. */
+    for (i = 0; pending && i < 4; i++) {
+        touch_model.now = expiry;
+        touch_model.bus_mark = touch_model.stats.bus_us;
+        pending = touch_report_timeout(expiry, &deadline);
+        expiry = touch_model_expiry(expiry, deadline);
+    }
+
+    touch_model.base += end + TOUCH_MODEL_TRACE_GAP_US;
+
+    return pending ? -EIO : 0;
+}
+
+int touch_model_bench(void)
+{
+    const struct touch_model_trace *trace;
+    struct touch_model_stats stats;
+    unsigned int failures = 0;
+    uint32_t expected;
+    uint32_t scans;
+    bool complete;
+    bool regression;
+    struct device *dev;
+    unsigned int i, j;
+    int ret;
+
+    dev = device_open(DEVICE_TYPE_HID_HW, 0);
+    if (!dev) {
+        return -ENODEV;
+    }
+
+    ret = device_hid_register_callback(dev, touch_model_event);
+    if (ret) {
+        device_close(dev);
+        return ret;
+    }
+
+    touch_model.base = TOUCH_MODEL_TRACE_GAP_US;
+
+    for (i = 0; i < ARRAY_SIZE(touch_model_traces); i++) {
+        trace = &touch_model_traces[i];
+
+        memset(&touch_model.report, 0, sizeof(touch_model.report));
+        touch_model.reports = 0;
+        touch_model.latency_sum = 0;
+        touch_model.latency_max = 0;
+        touch_model.landed = 0;
+        touch_model.lifted = 0;
+        touch_model.waiting = false;
+        scans = 0;
+
+        ret = device_hid_power_on(dev);
+        if (!ret) {
+            touch_model_reset_stats();
+            ret = touch_model_replay(dev, trace, &scans);
+            touch_model_get_stats(&stats);
+            device_hid_power_off(dev);
+        }
+
+        /* Every finger must have been seen landing and lifting. */
+        expected = 0;
+        for (j = 0; j < trace->num_strokes; j++) {
+            expected |= 1 << trace->strokes[j].id;
+        }
+        complete = touch_model.landed == expected &&
+                   touch_model.lifted == expected && !touch_model.waiting;
+
+        regression = touch_model.reports > trace->max_reports ||
+                     touch_model.latency_max > trace->max_latency_us;
+        if (ret || !complete || regression) {
+            failures++;
+        }
+
+        lowsyslog("touch-bench: %s: %u scans, %u reports (%u max), "
+                  "%u transactions, %u bytes, bus %u us, latency avg %u us, "
+                  "max %u us (%u max): %s\n",
+                  trace->name, scans, touch_model.reports, trace->max_reports,
+                  stats.transactions, stats.bytes, stats.bus_us,
+                  touch_model.reports ?
+                  touch_model.latency_sum / touch_model.reports : 0,
+                  touch_model.latency_max, trace->max_latency_us,
+                  bench_verdict(ret || !complete, regression));
+    }
+
+    bench_summary("touch-bench", "traces", ARRAY_SIZE(touch_model_traces),
+                  failures);
+
+    device_hid_unregister_callback(dev);
+    device_close(dev);
+
+    return failures ? -EINVAL : 0;
+}
+
+#endif /* CONFIG_ARA_TOUCH_MODEL */
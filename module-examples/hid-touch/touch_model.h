@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FDK_TOUCH_MODEL_H
+#define FDK_TOUCH_MODEL_H
+
+#include <stdint.h>
+
+#include <nuttx/config.h>
+#include <nuttx/gpio.h>
+#include <nuttx/i2c.h>
+
+/*
+ * Stand-in for the touch controller, replaying touch traces to measure the
+ * report path without a panel. Add CONFIG_ARA_TOUCH_MODEL=y to the module
+ * config to replace the controller bus with the model and run the benchmark
+ * at boot. The controller interrupt is never unmasked: the benchmark runs
+ * touch_sample() itself, in simulated time, once per controller scan.
+ */
+
+/* Default bus cost per byte: 9 bits at 400 kHz */
+#define TOUCH_MODEL_BYTE_TIME_NS        22500
+
+/**
+ * @brief Bus statistics accumulated by the model
+ */
+struct touch_model_stats {
+    /** Number of I2C transactions */
+    uint32_t transactions;
+    /** Bytes on the wire, including slave address bytes */
+    uint32_t bytes;
+    /** Simulated bus time in microseconds */
+    uint32_t bus_us;
+};
+
+#ifdef CONFIG_ARA_TOUCH_MODEL
+
+struct i2c_dev_s *touch_model_i2cinitialize(int port);
+int touch_model_i2cuninitialize(struct i2c_dev_s *dev);
+void touch_model_irq_unmask(uint8_t which);
+
+void touch_model_get_stats(struct touch_model_stats *stats);
+void touch_model_reset_stats(void);
+
+/**
+ * @brief Replay every touch trace through the driver
+ * @return 0 if all traces are within budget, -EINVAL otherwise
+ */
+int touch_model_bench(void);
+
+/* Route the driver's bus and interrupt accesses to the model. */
+#define up_i2cinitialize(port)          touch_model_i2cinitialize(port)
+#define up_i2cuninitialize(dev)         touch_model_i2cuninitialize(dev)
+#define gpio_irq_unmask(which)          touch_model_irq_unmask(which)
+
+#endif /* CONFIG_ARA_TOUCH_MODEL */
+
+#endif /* FDK_TOUCH_MODEL_H */
@@ -0,0 +1,839 @@
+/**
+ * Copyright (c) 2016 Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Matrix keypad scanned through the GPIO block.
+ *
+ * The rows are inputs with pull-ups on consecutive GPIO lines, so a single
+ * read of the GPIO data register samples all of them. While no key is down
+ * every column is driven low and the keypad costs nothing: the first press
+ * pulls its row low and the falling edge wakes the scanner. Scanning then
+ * drives one column low at a time and runs every KEYPAD_SCAN_MS until all
+ * keys are released and debounced, before going back to sleep.
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include <nuttx/config.h>
+#include <nuttx/arch.h>
+#include <nuttx/lib.h>
+#include <nuttx/gpio.h>
+#include <nuttx/clock.h>
+#include <nuttx/device_hid.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/util.h>
+#include <nuttx/wqueue.h>
+
+#include <arch/irq.h>
+
+#include "up_arch.h"
+#include "chip.h"
+
+#include "common/cycle_counter.h"
+
+#define DEFAULT_MODIFIER        0
+
+#define VENDORID                0x18D1  /* need discussion */
+#define PRODUCTID               0x1235  /* need discussion */
+
+#define HID_REPORT_DESC_LEN     43
+
+#define MAX_REPORT_KEYS         6       /* 6-key rollover */
+#define KEYCODE_ERR_ROLLOVER    0x01    /* more keys pressed than reported */
+
+/* GPIO data register at the start of the GPIO block, one bit per line */
+#define KEYPAD_GPIO_DATA        (GPIO_BASE + 0x00)
+
+/* Rows on GPIO KEYPAD_ROW_BASE .. KEYPAD_ROW_BASE + KEYPAD_NUM_ROWS - 1 */
+#define KEYPAD_ROW_BASE         0
+#define KEYPAD_NUM_ROWS         4
+#define KEYPAD_ROW_MASK         (((1 << KEYPAD_NUM_ROWS) - 1) << \
+                                 KEYPAD_ROW_BASE)
+#define KEYPAD_NUM_COLS         4
+
+/*
+ * Scan period while a key is down, one system tick: the work queue cannot
+ * wait less. Four stable scans confirm a change, a 40 ms debounce.
+ */
+#define KEYPAD_SCAN_MS          10
+/* Time for the rows to follow a column change through the pull-ups */
+#define KEYPAD_SETTLE_US        10
+
+/* Bit of a key in the key bitmaps */
+#define KEY_BIT(col, row)       (1 << ((col) * KEYPAD_NUM_ROWS + (row)))
+
+/*
+ * Scan statistics are opt-in: add CONFIG_ARA_KEYPAD_STATS=y to the module
+ * config and cat STATS_DEVPATH from NSH. Writing anything to it clears the
+ * statistics. Histogram bucket n counts scans costing [2^n, 2^(n+1)) us.
+ *
+ * A scan takes tens of microseconds, far less than the 10 ms system tick, so
+ * its cost is timed with the cycle counter.
+ */
+#define STATS_DEVPATH           "/dev/keypadstat"
+#define STATS_HIST_BUCKETS      12
+/* Longest line: "H", 12 counters of 10 digits, "\n" */
+#define STATS_LINE_LEN          (1 + STATS_HIST_BUCKETS * 11 + 2)
+
+/* GPIO lines driving the columns */
+static const uint8_t keypad_cols[KEYPAD_NUM_COLS] = { 4, 5, 6, 7 };
+
+/* Keycodes, indexed by column then row */
+static const uint8_t keypad_keymap[KEYPAD_NUM_COLS][KEYPAD_NUM_ROWS] = {
+    { 0x1e, 0x21, 0x24, 0x55 },     /* 1 4 7 * */
+    { 0x1f, 0x22, 0x25, 0x27 },     /* 2 5 8 0 */
+    { 0x20, 0x23, 0x26, 0x32 },     /* 3 6 9 # */
+    { 0x04, 0x05, 0x06, 0x07 },     /* A B C D */
+};
+
+/**
+ * Keyboard HID report, boot protocol layout
+ */
+struct hid_kbd_data {
+    /** modifier key: bit[0-7]: Left/Right Control, Shift, Alt, GUI */
+    uint8_t modifier;
+
+    /** reserved, always 0 */
+    uint8_t reserved;
+
+    /** keycodes of the pressed keys, 0 ~ 101 key value, unused slots 0 */
+    uint8_t keycode[MAX_REPORT_KEYS];
+} __packed;
+
+/**
+ * Scan cost and rate
+ */
+struct keypad_stats {
+    /** Wake-up interrupts taken */
+    uint32_t wakeups;
+    /** Matrix scans */
+    uint32_t scans;
+    /** Scans discarded because of an ambiguous key pattern */
+    uint32_t ghosts;
+    /** Reports sent */
+    uint32_t reports;
+    /** Time spent scanning, and the longest scan, in microseconds */
+    uint32_t busy_us;
+    uint32_t max_us;
+    /** Time of the last clear, to derive the scan rate */
+    uint32_t start_us;
+    uint32_t hist[STATS_HIST_BUCKETS];
+};
+
+/**
+ * Keypad state, the key bitmaps have one bit per key from KEY_BIT()
+ */
+struct keypad_info {
+    /** Debounced keys */
+    uint32_t pressed;
+
+    /** Two bit vertical counter of each key, see keypad_debounce() */
+    uint32_t cnt0;
+    uint32_t cnt1;
+
+    /** Keys of the last report */
+    uint32_t reported;
+
+    /** Scanning, the row interrupts are masked */
+    bool scanning;
+
+    struct work_s scan_work;
+
+#ifdef CONFIG_ARA_KEYPAD_STATS
+    struct keypad_stats stats;
+#endif
+};
+
+static struct device *keypad_dev = NULL;
+static struct keypad_info keypad;
+
+#ifdef CONFIG_ARA_KEYPAD_STATS
+static uint32_t stats_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static inline uint32_t stats_scan_start(void)
+{
+    return cycle_counter_read();
+}
+
+static void stats_wakeup(void)
+{
+    keypad.stats.wakeups++;
+}
+
+static void stats_scan(uint32_t start, bool ghost)
+{
+    struct keypad_stats *stats = &keypad.stats;
+    uint32_t us = cycle_counter_to_us(cycle_counter_read() - start);
+    unsigned int bucket = 0;
+    uint32_t value = us;
+
+    while (value >>= 1) {
+        bucket++;
+    }
+
+    if (bucket >= STATS_HIST_BUCKETS) {
+        bucket = STATS_HIST_BUCKETS - 1;
+    }
+
+    stats->scans++;
+    stats->ghosts += ghost;
+    stats->busy_us += us;
+    stats->hist[bucket]++;
+    if (us > stats->max_us) {
+        stats->max_us = us;
+    }
+}
+
+static void stats_report(void)
+{
+    keypad.stats.reports++;
+}
+
+/**
+ * @brief Format one line of the statistics dump
+ *
+ * 'S' line: wakeups, scans, ghosts, reports, busy and max scan time, and
+ * the time elapsed since the last clear, all times in microseconds.
+ * 'H' line: histogram of the scan time.
+ *
+ * @param index Line index
+ * @param line Output buffer
+ * @param size Size of the output buffer
+ * @return number of characters written, 0 past the last line
+ */
+static int stats_format(unsigned int index, char *line, size_t size)
+{
+    struct keypad_stats stats;
+    irqstate_t flags;
+    unsigned int i;
+    int len;
+
+    flags = irqsave();
+    stats = keypad.stats;
+    irqrestore(flags);
+
+    switch (index) {
+    case 0:
+        return snprintf(line, size, "S %u %u %u %u %u %u %u\n",
+                        stats.wakeups, stats.scans, stats.ghosts,
+                        stats.reports, stats.busy_us, stats.max_us,
+                        stats_now() - stats.start_us);
+    case 1:
+        len = snprintf(line, size, "H");
+        for (i = 0; i < STATS_HIST_BUCKETS && len < (int)size - 1; i++) {
+            len += snprintf(line + len, size - len, " %u", stats.hist[i]);
+        }
+
+        if (len < (int)size - 1) {
+            len += snprintf(line + len, size - len, "\n");
+        }
+
+        return MIN(len, (int)size - 1);
+    default:
+        return 0;
+    }
+}
+
+static ssize_t stats_read(struct file *filep, char *buffer, size_t buflen)
+{
+    char line[STATS_LINE_LEN];
+    size_t nread = 0;
+    int len;
+
+    while (nread < buflen) {
+        len = stats_format(filep->f_pos, line, sizeof(line));
+        if (len <= 0 || nread + len > buflen) {
+            break;
+        }
+
+        memcpy(buffer + nread, line, len);
+        nread += len;
+        filep->f_pos++;
+    }
+
+    return nread;
+}
+
+static ssize_t stats_write(struct file *filep, const char *buffer,
+                           size_t buflen)
+{
+    irqstate_t flags;
+
+    flags = irqsave();
+    memset(&keypad.stats, 0, sizeof(keypad.stats));
+    keypad.stats.start_us = stats_now();
+    irqrestore(flags);
+
+    return buflen;
+}
+
+static const struct file_operations stats_fops = {
+    .read   = stats_read,
+    .write  = stats_write,
+};
+#else
+static inline uint32_t stats_scan_start(void)
+{
+    return 0;
+}
+
+static inline void stats_wakeup(void)
+{
+}
+
+static inline void stats_scan(uint32_t start, bool ghost)
+{
+}
+
+static inline void stats_report(void)
+{
+}
+#endif /* CONFIG_ARA_KEYPAD_STATS */
+
+/**
+ * Keyboard HID Device Descriptor
+ */
+struct hid_descriptor keypad_dev_desc = {
+    0x0A,
+    HID_REPORT_DESC_LEN,
+    0x0111, /* HID v1.11 compliant */
+    PRODUCTID,
+    VENDORID,
+    0x00, /* no country code */
+};
+
+// Input report - 8 bytes
+//
+// Byte |  D7    D6    D5    D4     D3        D2        D1      D0
+// -----+-------------------------------------------------------------------
+//  0   | RGUI  RAlt RShift RCtrl  LGUI      LAlt     LShift   LCtrl
+//  1   |                         Reserved
+//  2-7 |                   Keycode 1 - Keycode 6
+//
+// Output report - n/a
+//
+// Feature report - n/a
+//
+
+/**
+ * Report descriptor for HID KEYPAD
+ */
+uint8_t keypad_report_desc[HID_REPORT_DESC_LEN] = {
+    0x05, 0x01,     /* USAGE_PAGE (Generic Desktop) */
+    0x09, 0x06,     /* USAGE (Keyboard) */
+    0xa1, 0x01,     /* COLLECTION (Application) */
+    0x05, 0x07,     /*   USAGE_PAGE (Keyboard) */
+    0x19, 0xe0,     /*   USAGE_MINIMUM (Keyboard LeftControl) */
+    0x29, 0xe7,     /*   USAGE_MAXIMUM (Keyboard Right GUI) */
+    0x15, 0x00,     /*   LOGICAL_MINIMUM (0) */
+    0x25, 0x01,     /*   LOGICAL_MAXIMUM (1) */
+    0x75, 0x01,     /*   REPORT_SIZE (1) */
+    0x95, 0x08,     /*   REPORT_COUNT (8) */
+    0x81, 0x02,     /*   INPUT (Data,Var,Abs) */
+    0x95, 0x01,     /*   REPORT_COUNT (1) */
+    0x75, 0x08,     /*   REPORT_SIZE (8) */
+    0x81, 0x01,     /*   INPUT (Cnst,Ary,Abs) */
+    0x95, 0x06,     /*   REPORT_COUNT (6) */
+    0x75, 0x08,     /*   REPORT_SIZE (8) */
+    0x15, 0x00,     /*   LOGICAL_MINIMUM (0) */
+    0x25, 0x65,     /*   LOGICAL_MAXIMUM (101) */
+    0x19, 0x00,     /*   USAGE_MINIMUM (Reserved (no event)) */
+    0x29, 0x65,     /*   USAGE_MAXIMUM (Keyboard Application) */
+    0x81, 0x00,     /*   INPUT (Data,Ary,Abs) */
+    0xc0            /* END_COLLECTION */
+};
+
+/**
+ * report length of each HID Reports in HID Report Descriptor
+ */
+struct hid_size_info keypad_sizeinfo[] =
+{
+    /**
+     * Parsed by HID Descriptor tool, this application only support INPUT
+     * report, so the FEATURE and OUTPUT size is 0.
+     */
+    { .id = 0,
+      .reports = {
+          .size = { sizeof(struct hid_kbd_data), 0, 0 }
+       }
+    },
+};
+
+/**
+ * @brief Read all the rows at once
+ *
+ * @return bitmap of the rows pulled low, bit n for row n
+ */
+static inline uint32_t keypad_read_rows(void)
+{
+    uint32_t data = getreg32(KEYPAD_GPIO_DATA);
+
+    return (~data & KEYPAD_ROW_MASK) >> KEYPAD_ROW_BASE;
+}
+
+/**
+ * @brief Drive every column low, any key press then pulls its row low
+ */
+static void keypad_cols_idle(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < KEYPAD_NUM_COLS; i++) {
+        gpio_direction_out(keypad_cols[i], 0);
+    }
+}
+
+/**
+ * @brief Sample the whole matrix
+ *
+ * Inactive columns are left floating rather than driven high, so that two
+ * keys of one row cannot short a driven high column to the active one.
+ *
+ * @return bitmap of the keys seen down
+ */
+static uint32_t keypad_sample(void)
+{
+    uint32_t raw = 0;
+    unsigned int i;
+
+    for (i = 0; i < KEYPAD_NUM_COLS; i++) {
+        gpio_direction_in(keypad_cols[i]);
+    }
+
+    for (i = 0; i < KEYPAD_NUM_COLS; i++) {
+        gpio_direction_out(keypad_cols[i], 0);
+        up_udelay(KEYPAD_SETTLE_US);
+        raw |= keypad_read_rows() << (i * KEYPAD_NUM_ROWS);
+        gpio_direction_in(keypad_cols[i]);
+    }
+
+    return raw;
+}
+
+/**
+ * @brief Tell whether a sample can contain ghost keys
+ *
+ * Without diodes, three keys on the corners of a rectangle make the fourth
+ * corner read as pressed. Such a sample has two columns sharing two or more
+ * rows, and which of its keys are real cannot be told.
+ *
+ * @param raw Keys seen down
+ * @return true if the sample is ambiguous
+ */
+static bool keypad_ghosted(uint32_t raw)
+{
+    uint32_t rows[KEYPAD_NUM_COLS];
+    uint32_t common;
+    unsigned int i, j;
+
+    for (i = 0; i < KEYPAD_NUM_COLS; i++) {
+        rows[i] = (raw >> (i * KEYPAD_NUM_ROWS)) &
+                  ((1 << KEYPAD_NUM_ROWS) - 1);
+    }
+
+    for (i = 0; i < KEYPAD_NUM_COLS; i++) {
+        /* A single row can't form a rectangle */
+        if (!(rows[i] & (rows[i] - 1))) {
+            continue;
+        }
+
+        for (j = i + 1; j < KEYPAD_NUM_COLS; j++) {
+            common = rows[i] & rows[j];
+            if (common & (common - 1)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Debounce every key at once
+ *
+ * Each key has a two bit counter spread over cnt1:cnt0, reset whenever the
+ * key matches its debounced state. A key flips once it has differed for four
+ * consecutive scans.
+ *
+ * @param raw Keys seen down
+ * @return bitmap of the keys that changed state
+ */
+static uint32_t keypad_debounce(uint32_t raw)
+{
+    uint32_t delta = raw ^ keypad.pressed;
+    uint32_t toggle;
+
+    keypad.cnt1 = (keypad.cnt1 ^ keypad.cnt0) & delta;
+    keypad.cnt0 = ~keypad.cnt0 & delta;
+
+    toggle = delta & ~(keypad.cnt0 | keypad.cnt1);
+    keypad.pressed ^= toggle;
+
+    return toggle;
+}
+
+/**
+ * @brief Build a report from the debounced keys
+ *
+ * @param kbd Report to fill
+ */
+static void keypad_build_report(struct hid_kbd_data *kbd)
+{
+    uint32_t pressed = keypad.pressed;
+    unsigned int count = 0;
+    unsigned int key;
+
+    memset(kbd, 0, sizeof(*kbd));
+
+    for (key = 0; pressed; key++, pressed >>= 1) {
+        if (!(pressed & 1)) {
+            continue;
+        }
+
+        if (count == MAX_REPORT_KEYS) {
+            memset(kbd->keycode, KEYCODE_ERR_ROLLOVER, sizeof(kbd->keycode));
+            return;
+        }
+
+        kbd->keycode[count++] = keypad_keymap[key / KEYPAD_NUM_ROWS]
+                                             [key % KEYPAD_NUM_ROWS];
+    }
+}
+
+/**
+ * @brief Send the debounced keys if they differ from the last report
+ */
+static void keypad_send_report(void)
+{
+    struct device *dev = keypad_dev;
+    struct hid_info *info;
+    struct hid_kbd_data kbd;
+
+    if (keypad.pressed == keypad.reported) {
+        return;
+    }
+
+    if (!dev || !device_get_private(dev)) {
+        return;
+    }
+
+    info = device_get_private(dev);
+    if (!info->event_callback) {
+        return;
+    }
+
+    keypad_build_report(&kbd);
+
+    /* On failure the next scan retries, the state is sent, not the edge. */
+    if (!info->event_callback(dev, HID_INPUT_REPORT, (uint8_t *)&kbd,
+                              sizeof(kbd))) {
+        keypad.reported = keypad.pressed;
+        stats_report();
+    }
+}
+
+/**
+ * @brief Unmask the row interrupts
+ */
+static void keypad_rows_unmask(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < KEYPAD_NUM_ROWS; i++) {
+        gpio_irq_unmask(KEYPAD_ROW_BASE + i);
+    }
+}
+
+/**
+ * @brief Scan the matrix once and schedule the next scan
+ *
+ * Scanning stops once nothing is down, nothing is being debounced and the
+ * last report went through. A key pressed while the rows were masked still
+ * holds its row low when they are unmasked, so the rows are checked again
+ * after unmasking rather than waiting for an edge that already happened.
+ *
+ * @param data Unused
+ */
+static void keypad_scan_worker(void *data)
+{
+    uint32_t start = stats_scan_start();
+    irqstate_t flags;
+    uint32_t raw;
+    bool ghost;
+
+    raw = keypad_sample();
+    ghost = keypad_ghosted(raw);
+
+    /* Ambiguous samples are dropped, the keys keep their debounced state. */
+    if (!ghost) {
+        keypad_debounce(raw);
+    }
+
+    keypad_cols_idle();
+    stats_scan(start, ghost);
+
+    keypad_send_report();
+
+    if (raw || keypad.pressed || keypad.cnt0 || keypad.cnt1 ||
+        keypad.pressed != keypad.reported) {
+        work_queue(HPWORK, &keypad.scan_work, keypad_scan_worker, NULL,
+                   MSEC2TICK(KEYPAD_SCAN_MS));
+        return;
+    }
+
+    flags = irqsave();
+    keypad.scanning = false;
+    keypad_rows_unmask();
+    if (keypad_read_rows()) {
+        keypad.scanning = true;
+        work_queue(HPWORK, &keypad.scan_work, keypad_scan_worker, NULL, 0);
+    }
+    irqrestore(flags);
+}
+
+/**
+ * @brief Row interrupt: a key went down while the keypad was idle
+ *
+ * @param irq IRQ number, same as GPIO number.
+ * @param context Unused
+ * @return 0 on success, negative errno on error
+ */
+static int keypad_handle_row_irq(int irq, FAR void *context)
+{
+    unsigned int i;
+
+    if (!keypad_dev) {
+        return ERROR;
+    }
+
+    for (i = 0; i < KEYPAD_NUM_ROWS; i++) {
+        gpio_irq_mask(KEYPAD_ROW_BASE + i);
+    }
+
+    if (!keypad.scanning) {
+        keypad.scanning = true;
+        stats_wakeup();
+        work_queue(HPWORK, &keypad.scan_work, keypad_scan_worker, NULL, 0);
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Get HID Input report data
+ *
+ * @param dev Pointer to structure of device data
+ * @param report_id HID report id
+ * @param data Pointer of input buffer size
+ * @param len Max input buffer size
+ * @return 0 on success, negative for error
+ */
+static int keypad_get_input_report(struct device *dev, uint8_t report_id,
+                                   uint8_t *data, uint16_t len)
+{
+    if (!len || report_id) {
+        /* No multiple Report ID in this application. */
+        return -EIO;
+    }
+
+    if (len < sizeof(struct hid_kbd_data)) {
+        return -EINVAL;
+    }
+
+    keypad_build_report((struct hid_kbd_data *)data);
+
+    return 0;
+}
+
+/**
+ * @brief Release the keypad GPIOs
+ *
+ * @param rows Number of row GPIOs activated
+ * @param cols Number of column GPIOs activated
+ */
+static void keypad_gpios_deinit(unsigned int rows, unsigned int cols)
+{
+    unsigned int i;
+
+    for (i = 0; i < rows; i++) {
+        gpio_irq_mask(KEYPAD_ROW_BASE + i);
+    }
+
+    work_cancel(HPWORK, &keypad.scan_work);
+
+    for (i = 0; i < rows; i++) {
+        gpio_deactivate(KEYPAD_ROW_BASE + i);
+    }
+
+    for (i = 0; i < cols; i++) {
+        gpio_direction_in(keypad_cols[i]);
+        gpio_deactivate(keypad_cols[i]);
+    }
+
+    keypad.pressed = 0;
+    keypad.reported = 0;
+    keypad.cnt0 = 0;
+    keypad.cnt1 = 0;
+    keypad.scanning = false;
+}
+
+/**
+ * @brief Configure the keypad GPIOs
+ *
+ * @param dev Pointer to structure of device data
+ * @param dev_info The pointer for hid_info struct
+ *
+ * @return 0 on success, negative errno on error
+ */
+static int keypad_hw_initialize(struct device *dev, struct hid_info *dev_info)
+{
+    unsigned int rows, cols;
+    int ret = 0;
+
+    if (KEYPAD_NUM_ROWS * KEYPAD_NUM_COLS > sizeof(keypad.pressed) * 8 ||
+        KEYPAD_ROW_BASE + KEYPAD_NUM_ROWS > gpio_line_count()) {
+        return -EINVAL;
+    }
+
+    for (cols = 0; cols < KEYPAD_NUM_COLS; cols++) {
+        ret = gpio_activate(keypad_cols[cols]);
+        if (ret)
+            goto err_gpios_init;
+    }
+    keypad_cols_idle();
+
+    for (rows = 0; rows < KEYPAD_NUM_ROWS; rows++) {
+        ret = gpio_activate(KEYPAD_ROW_BASE + rows);
+        if (ret)
+            goto err_gpios_init;
+
+        gpio_direction_in(KEYPAD_ROW_BASE + rows);
+        gpio_irq_mask(KEYPAD_ROW_BASE + rows);
+        gpio_irq_settriggering(KEYPAD_ROW_BASE + rows, IRQ_TYPE_EDGE_FALLING);
+        gpio_irq_attach(KEYPAD_ROW_BASE + rows, keypad_handle_row_irq);
+    }
+
+    return 0;
+
+err_gpios_init:
+    keypad_gpios_deinit(rows, cols);
+    return ret;
+}
+
+/**
+ * @brief Release the keypad GPIOs
+ *
+ * @param dev Pointer to structure of device data
+ *
+ * @return 0 on success, negative errno on error
+ */
+static int keypad_hw_deinitialize(struct device *dev)
+{
+    keypad_gpios_deinit(KEYPAD_NUM_ROWS, KEYPAD_NUM_COLS);
+
+    return 0;
+}
+
+static int keypad_power_set(struct device *dev, bool on)
+{
+    irqstate_t flags;
+    unsigned int i;
+
+    if (on) {
+        flags = irqsave();
+        if (!keypad.scanning) {
+            keypad_rows_unmask();
+        }
+        irqrestore(flags);
+        return 0;
+    }
+
+    for (i = 0; i < KEYPAD_NUM_ROWS; i++) {
+        gpio_irq_mask(KEYPAD_ROW_BASE + i);
+    }
+
+    work_cancel(HPWORK, &keypad.scan_work);
+    keypad_cols_idle();
+    keypad.scanning = false;
+
+    return 0;
+}
+
+static int keypad_get_report(struct device *dev, uint8_t report_type,
+                             uint8_t report_id, uint8_t *data, uint16_t len)
+{
+    int ret = 0;
+
+    switch (report_type) {
+        case HID_INPUT_REPORT:
+            ret = keypad_get_input_report(dev, report_id, data, len);
+        break;
+        default:
+            ret = -EINVAL;
+        break;
+    }
+
+    return ret;
+}
+
+static struct hid_vendor_ops keypad_ops = {
+    .hw_initialize = keypad_hw_initialize,
+    .hw_deinitialize = keypad_hw_deinitialize,
+    .power_control = keypad_power_set,
+    .get_report = keypad_get_report,
+    .set_report = NULL,
+};
+
+int hid_device_init(struct device *dev, struct hid_info *dev_info)
+{
+    dev_info->hdesc = &keypad_dev_desc;
+    dev_info->rdesc = keypad_report_desc;
+    dev_info->sinfo = keypad_sizeinfo;
+    dev_info->num_ids = ARRAY_SIZE(keypad_sizeinfo);
+    dev_info->hid_dev_ops = &keypad_ops;
+    keypad_dev = dev;
+
+#ifdef CONFIG_ARA_KEYPAD_STATS
+    cycle_counter_init();
+    keypad.stats.start_us = stats_now();
+    register_driver(STATS_DEVPATH, &stats_fops, 0666, NULL);
+#endif
+
+    return 0;
+}
@@ -0,0 +1,7 @@
+config		= config
+manifest	= manifest.mnfs
+board-files	= board.c
+board-files	+= keypad.c
+
+vendor_id      = 0x18D1
+product_id     = 0x1235
@@ -0,0 +1,978 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <nuttx/config.h>
+
+#ifdef CONFIG_ARA_AUDIO_BENCH
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <syslog.h>
+
+#include <nuttx/util.h>
+
+#include "common/audio_asrc.h"
+#include "common/audio_desc_ring.h"
+#include "common/audio_dsp.h"
+#include "common/audio_jitter.h"
+#include "common/bench.h"
+#include "common/cycle_counter.h"
+
+#include "audio_bench.h"
+
+#define AUDIO_BENCH_RATE                48000
+#define AUDIO_BENCH_CHANNELS            2
+
+/* The I2S transmitter reads 1 ms at a time. */
+#define AUDIO_BENCH_PERIOD              48
+#define AUDIO_BENCH_PERIOD_US           1000
+
+/* 100 ms of buffering */
+#define AUDIO_BENCH_JITTER_CAPACITY     4800
+
+/* Length of each link trace, in periods */
+#define AUDIO_BENCH_JITTER_READS        10000
+
+/* Fastest transit time over the link */
+#define AUDIO_BENCH_TRANSIT_US          200
+
+#define AUDIO_BENCH_MAX_PACKET          480
+
+/* The sample kernels run on 10 ms of stereo, a few times */
+#define AUDIO_BENCH_DSP_FRAMES          480
+#define AUDIO_BENCH_DSP_SAMPLES         (2 * AUDIO_BENCH_DSP_FRAMES)
+#define AUDIO_BENCH_DSP_REPEAT          8
+
+/* UniPro receive buffers the zero-copy path may hold */
+#define AUDIO_BENCH_RX_BUFFERS          16
+
+/* The converter is measured on 100 ms of a 1 kHz tone at -1 dBFS */
+#define AUDIO_BENCH_TONE_HZ             1000
+#define AUDIO_BENCH_TONE_AMPLITUDE      29204
+#define AUDIO_BENCH_PI                  3.14159265358979
+
+/* Drift traces: 20 s, checked over the last 10 s */
+#define AUDIO_BENCH_DRIFT_READS         20000
+#define AUDIO_BENCH_DRIFT_SETTLE        10000
+#define AUDIO_BENCH_DRIFT_CAPACITY      1440
+
+/**
+ * @brief How audio packets arrive from the AP, and the budget
+ */
+struct audio_bench_link {
+    const char *name;
+    /** Frames per packet */
+    uint16_t packet_frames;
+    /** Packets sent back to back each time the AP wakes up */
+    uint8_t burst;
+    /** Sender clock offset from the I2S clock, in parts per million */
+    int16_t ppm;
+    /** Random extra transit time, up to this many microseconds */
+    uint16_t jitter_us;
+    /** The link stalls for stall_us every stall_period_ms */
+    uint16_t stall_period_ms;
+    uint16_t stall_us;
+    uint32_t max_underruns;
+    /** Budget of the average buffered audio */
+    uint32_t max_latency_us;
+};
+
+/* The first late burst or stall of a link is an underrun, the next are not. */
+static const struct audio_bench_link audio_bench_links[] = {
+    { "steady", 48, 1, 0, 100, 0, 0, 0, 1920 },
+    { "ap-10ms", 48, 10, 0, 100, 0, 0, 1, 6420 },
+    { "packets-10ms", 480, 1, 0, 500, 0, 0, 0, 6650 },
+    { "jitter-3ms", 48, 1, 0, 3000, 0, 0, 1, 3440 },
+    { "stall-15ms", 48, 1, 0, 100, 2000, 15000, 1, 13520 },
+    { "fast-300ppm", 48, 1, 300, 100, 0, 0, 0, 2250 },
+    { "slow-300ppm", 48, 1, -300, 100, 0, 0, 0, 2070 },
+};
+
+/**
+ * @brief Link trace replayed through the zero-copy path, and the budget
+ *
+ * The copying path, through the jitter buffer, runs alongside for the
+ * comparison.
+ */
+struct audio_bench_zero_copy {
+    const struct audio_bench_link *link;
+    /** The DMA starts once this many frames are queued */
+    uint32_t prime_frames;
+    uint32_t max_underruns;
+    uint32_t max_latency_us;
+};
+
+static const struct audio_bench_zero_copy audio_bench_zero_copies[] = {
+    { &audio_bench_links[0], 48, 0, 1000 },         /* steady */
+    { &audio_bench_links[1], 480, 0, 5500 },        /* ap-10ms */
+    { &audio_bench_links[2], 480, 0, 5500 },        /* packets-10ms */
+    { &audio_bench_links[3], 96, 1, 2750 },         /* jitter-3ms */
+};
+
+/**
+ * @brief Rate conversion, and the budget of its distortion
+ */
+struct audio_bench_rates {
+    uint32_t in_rate;
+    uint32_t out_rate;
+    /** THD+N budget, in dB relative to the tone */
+    int16_t max_thdn_db;
+};
+
+static const struct audio_bench_rates audio_bench_rates[] = {
+    { 44100, 48000, -80 },
+    { 48000, 44100, -82 },
+    { 48000, 48000, -95 },
+    { 32000, 48000, -81 },
+    { 16000, 48000, -78 },
+    { 48000, 32000, -90 },
+};
+
+/**
+ * @brief AP clock drift, corrected by the converter, and the budget
+ *
+ * Same rule for the budget.
+ */
+struct audio_bench_drift {
+    const char *name;
+    /** AP rate, converted to the I2S rate */
+    uint32_t in_rate;
+    /** Frames per packet */
+    uint16_t packet_frames;
+    /** Sender clock offset from the I2S clock, in parts per million */
+    int16_t ppm;
+    /** Budget of the buffer fill error once settled, in frames */
+    uint16_t max_deviation;
+    /** Budget of the correction error once settled, in ppm */
+    uint16_t max_ppm_error;
+};
+
+static const struct audio_bench_drift audio_bench_drifts[] = {
+    { "fast-300ppm", 48000, 48, 300, 2, 5 },
+    { "slow-300ppm", 48000, 48, -300, 2, 5 },
+    { "fast-1000ppm", 48000, 48, 1000, 2, 5 },
+    { "packets-10ms", 48000, 480, 300, 2, 5 },
+    { "44.1k-slow-300ppm", 44100, 441, -300, 2, 5 },
+};
+
+static int16_t audio_bench_ring[AUDIO_BENCH_JITTER_CAPACITY *
+                                AUDIO_BENCH_CHANNELS];
+static int16_t audio_bench_packet[AUDIO_BENCH_MAX_PACKET *
+                                  AUDIO_BENCH_CHANNELS];
+static int16_t audio_bench_period[AUDIO_BENCH_PERIOD * AUDIO_BENCH_CHANNELS];
+static struct audio_jitter audio_bench_jitter;
+static int16_t audio_bench_fifo[AUDIO_BENCH_DRIFT_CAPACITY *
+                                AUDIO_BENCH_CHANNELS];
+static struct audio_asrc audio_bench_asrc;
+/* Only the ownership of the receive buffers is modelled */
+static uint32_t audio_bench_rx_free;
+static struct audio_desc audio_bench_descs[AUDIO_BENCH_RX_BUFFERS];
+static struct audio_desc_ring audio_bench_desc_ring;
+
+enum audio_bench_kernel {
+    AUDIO_BENCH_S16_TO_S32,
+    AUDIO_BENCH_S32_TO_S16,
+    AUDIO_BENCH_S16_TO_S24,
+    AUDIO_BENCH_S24_TO_S16,
+    AUDIO_BENCH_S24_TO_S32,
+    AUDIO_BENCH_S32_TO_S24,
+    AUDIO_BENCH_MONO_TO_STEREO,
+    AUDIO_BENCH_STEREO_TO_MONO,
+    AUDIO_BENCH_MIX,
+    AUDIO_BENCH_GAIN,
+    AUDIO_BENCH_GAIN_RAMP,
+    AUDIO_BENCH_NUM_KERNELS,
+};
+
+static const char *audio_bench_kernel_names[] = {
+    [AUDIO_BENCH_S16_TO_S32] = "s16-to-s32",
+    [AUDIO_BENCH_S32_TO_S16] = "s32-to-s16",
+    [AUDIO_BENCH_S16_TO_S24] = "s16-to-s24",
+    [AUDIO_BENCH_S24_TO_S16] = "s24-to-s16",
+    [AUDIO_BENCH_S24_TO_S32] = "s24-to-s32",
+    [AUDIO_BENCH_S32_TO_S24] = "s32-to-s24",
+    [AUDIO_BENCH_MONO_TO_STEREO] = "mono-to-stereo",
+    [AUDIO_BENCH_STEREO_TO_MONO] = "stereo-to-mono",
+    [AUDIO_BENCH_MIX] = "mix",
+    [AUDIO_BENCH_GAIN] = "gain",
+    [AUDIO_BENCH_GAIN_RAMP] = "gain-ramp",
+};
+
+/* Kernel inputs, and the outputs of the kernel and of its reference */
+static int16_t audio_bench_s16[2][AUDIO_BENCH_DSP_SAMPLES];
+static int32_t audio_bench_s32[AUDIO_BENCH_DSP_SAMPLES];
+static uint8_t audio_bench_s24[3 * AUDIO_BENCH_DSP_SAMPLES];
+static uint8_t audio_bench_out[2][4 * AUDIO_BENCH_DSP_SAMPLES];
+
+static uint32_t audio_bench_seed;
+
+static uint32_t audio_bench_random(void)
+{
+    audio_bench_seed = audio_bench_seed * 1103515245 + 12345;
+    return audio_bench_seed >> 8;
+}
+
+/**
+ * @brief Arrival time of a packet
+ * @param link Link trace
+ * @param n Packet number
+ * @param prev Arrival time of the previous packet, packets stay in order
+ * @return arrival time, in microseconds
+ */
+static uint32_t audio_bench_arrival(const struct audio_bench_link *link,
+                                    uint32_t n, uint32_t prev)
+{
+    uint32_t packet_ns;
+    uint32_t stall;
+    uint32_t phase;
+    uint32_t sent;
+    uint32_t t;
+
+    packet_ns = link->packet_frames * (1000000000 / AUDIO_BENCH_RATE);
+    packet_ns -= (int32_t)(packet_ns / 1000) * link->ppm / 1000;
+
+    /* The AP sends a burst when its last packet is due. */
+    n = (n / link->burst + 1) * link->burst - 1;
+    sent = n * (packet_ns / 1000) + n * (packet_ns % 1000) / 1000;
+
+    t = sent + AUDIO_BENCH_TRANSIT_US +
+        audio_bench_random() % (link->jitter_us + 1);
+
+    if (link->stall_period_ms) {
+        stall = link->stall_period_ms * 1000;
+        phase = sent % stall;
+        if (phase < link->stall_us) {
+            t = MAX(t, sent - phase + link->stall_us +
+                       AUDIO_BENCH_TRANSIT_US);
+        }
+    }
+
+    return MAX(t, prev);
+}
+
+/**
+ * @brief Replay a link trace through the jitter buffer
+ * @param link Link trace
+ * @return 0 if within budget, -EINVAL otherwise
+ */
+static int audio_bench_jitter_link(const struct audio_bench_link *link)
+{
+    struct audio_jitter *jb = &audio_bench_jitter;
+    struct audio_jitter_stats stats;
+    uint32_t depth_sum = 0;
+    uint32_t arrival;
+    uint32_t latency;
+    uint32_t sample = 0;
+    uint32_t packet = 0;
+    uint32_t now;
+    uint32_t r;
+    uint32_t i;
+    bool regression;
+    int ret;
+
+    ret = audio_jitter_setup(jb, audio_bench_ring,
+                             AUDIO_BENCH_JITTER_CAPACITY,
+                             AUDIO_BENCH_CHANNELS, AUDIO_BENCH_RATE,
+                             AUDIO_BENCH_PERIOD);
+    if (ret) {
+        return ret;
+    }
+
+    audio_bench_seed = 1;
+    arrival = audio_bench_arrival(link, 0, 0);
+
+    for (r = 0; r < AUDIO_BENCH_JITTER_READS; r++) {
+        now = r * AUDIO_BENCH_PERIOD_US;
+
+        while ((int32_t)(arrival - now) <= 0) {
+            for (i = 0; i < link->packet_frames * AUDIO_BENCH_CHANNELS;
+                 i++) {
+                audio_bench_packet[i] = sample++ << 4;
+            }
+
+            audio_jitter_write(jb, audio_bench_packet, link->packet_frames,
+                               arrival);
+            arrival = audio_bench_arrival(link, ++packet, arrival);
+        }
+
+        depth_sum += jb->count;
+        audio_jitter_read(jb, audio_bench_period, now);
+    }
+
+    audio_jitter_get_stats(jb, &stats);
+
+    latency = depth_sum / AUDIO_BENCH_JITTER_READS * 1000 /
+              (AUDIO_BENCH_RATE / 1000);
+    regression = stats.underruns > link->max_underruns ||
+                 latency > link->max_latency_us;
+
+    lowsyslog("audio-bench: jitter %s: %u underruns (%u max), %u overruns, "
+              "%u concealed, %u merged, %u inserted, jitter %u us, "
+              "delay %u us, latency %u us (%u max): %s\n",
+              link->name, stats.underruns, link->max_underruns,
+              stats.overruns, stats.concealed, stats.merged, stats.inserted,
+              stats.jitter_us, stats.delay_us, latency, link->max_latency_us,
+              bench_verdict(false, regression));
+
+    return regression ? -EINVAL : 0;
+}
+
+static int32_t audio_bench_clamp(int64_t x, int32_t min, int32_t max)
+{
+    return x > max ? max : x < min ? min : x;
+}
+
+/* Per-sample references the kernels are checked against */
+static void audio_bench_ref(enum audio_bench_kernel kernel, uint8_t *out)
+{
+    const int16_t *s16 = audio_bench_s16[0];
+    const int16_t *mix = audio_bench_s16[1];
+    const uint8_t *s24 = audio_bench_s24;
+    int16_t *o16 = (int16_t *)out;
+    int32_t *o32 = (int32_t *)out;
+    struct audio_dsp_gain gain;
+    int32_t v;
+    uint32_t i;
+
+    for (i = 0; i < AUDIO_BENCH_DSP_SAMPLES; i++, s24 += 3) {
+        v = (int32_t)((s24[0] << 8) | (s24[1] << 16) |
+                      ((uint32_t)s24[2] << 24)) >> 8;
+
+        switch (kernel) {
+        case AUDIO_BENCH_S16_TO_S32:
+            o32[i] = s16[i] * 65536;
+            break;
+        case AUDIO_BENCH_S32_TO_S16:
+            o16[i] = audio_bench_clamp(((int64_t)audio_bench_s32[i] +
+                                        32768) >> 16, INT16_MIN, INT16_MAX);
+            break;
+        case AUDIO_BENCH_S16_TO_S24:
+            out[3 * i] = 0;
+            out[3 * i + 1] = s16[i] & 0xff;
+            out[3 * i + 2] = (uint16_t)s16[i] >> 8;
+            break;
+        case AUDIO_BENCH_S24_TO_S16:
+            o16[i] = audio_bench_clamp((v + 128) >> 8, INT16_MIN, INT16_MAX);
+            break;
+        case AUDIO_BENCH_S24_TO_S32:
+            o32[i] = v * 256;
+            break;
+        case AUDIO_BENCH_S32_TO_S24:
+            v = audio_bench_clamp(((int64_t)audio_bench_s32[i] + 128) >> 8,
+                                  -0x800000, 0x7fffff);
+            out[3 * i] = v;
+            out[3 * i + 1] = v >> 8;
+            out[3 * i + 2] = v >> 16;
+            break;
+        case AUDIO_BENCH_MONO_TO_STEREO:
+            if (i < AUDIO_BENCH_DSP_FRAMES) {
+                o16[2 * i] = s16[i];
+                o16[2 * i + 1] = s16[i];
+            }
+            break;
+        case AUDIO_BENCH_STEREO_TO_MONO:
+            if (i < AUDIO_BENCH_DSP_FRAMES) {
+                o16[i] = (s16[2 * i] + s16[2 * i + 1]) >> 1;
+            }
+            break;
+        case AUDIO_BENCH_MIX:
+            o16[i] = audio_bench_clamp(s16[i] + mix[i], INT16_MIN,
+                                       INT16_MAX);
+            break;
+        case AUDIO_BENCH_GAIN:
+            o16[i] = audio_bench_clamp((s16[i] * 0x1800 + 0x800) >> 12,
+                                       INT16_MIN, INT16_MAX);
+            break;
+        case AUDIO_BENCH_GAIN_RAMP:
+            /* Unity down to a quarter over the first half, same steps */
+            if (!i) {
+                audio_dsp_gain_init(&gain, AUDIO_DSP_GAIN_UNITY);
+                audio_dsp_gain_set(&gain, AUDIO_DSP_GAIN_UNITY / 4,
+                                   AUDIO_BENCH_DSP_FRAMES / 2);
+            }
+            v = i / 2 < AUDIO_BENCH_DSP_FRAMES / 2 ?
+                ((AUDIO_DSP_GAIN_UNITY << 15) +
+                 gain.step * (int32_t)(i / 2 + 1)) >> 15 :
+                AUDIO_DSP_GAIN_UNITY / 4;
+            o16[i] = audio_bench_clamp((s16[i] * v + 0x800) >> 12,
+                                       INT16_MIN, INT16_MAX);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static void audio_bench_kernel(enum audio_bench_kernel kernel, uint8_t *out)
+{
+    int16_t *o16 = (int16_t *)out;
+    struct audio_dsp_gain gain;
+
+    switch (kernel) {
+    case AUDIO_BENCH_S16_TO_S32:
+        audio_dsp_s16_to_s32((int32_t *)out, audio_bench_s16[0],
+                             AUDIO_BENCH_DSP_SAMPLES);
+        break;
+    case AUDIO_BENCH_S32_TO_S16:
+        audio_dsp_s32_to_s16(o16, audio_bench_s32, AUDIO_BENCH_DSP_SAMPLES);
+        break;
+    case AUDIO_BENCH_S16_TO_S24:
+        audio_dsp_s16_to_s24(out, audio_bench_s16[0], AUDIO_BENCH_DSP_SAMPLES);
+        break;
+    case AUDIO_BENCH_S24_TO_S16:
+        audio_dsp_s24_to_s16(o16, audio_bench_s24, AUDIO_BENCH_DSP_SAMPLES);
+        break;
+    case AUDIO_BENCH_S24_TO_S32:
+        audio_dsp_s24_to_s32((int32_t *)out, audio_bench_s24,
+                             AUDIO_BENCH_DSP_SAMPLES);
+        break;
+    case AUDIO_BENCH_S32_TO_S24:
+        audio_dsp_s32_to_s24(out, audio_bench_s32, AUDIO_BENCH_DSP_SAMPLES);
+        break;
+    case AUDIO_BENCH_MONO_TO_STEREO:
+        audio_dsp_mono_to_stereo(o16, audio_bench_s16[0],
+                                 AUDIO_BENCH_DSP_FRAMES);
+        break;
+    case AUDIO_BENCH_STEREO_TO_MONO:
+        audio_dsp_stereo_to_mono(o16, audio_bench_s16[0],
+                                 AUDIO_BENCH_DSP_FRAMES);
+        break;
+    case AUDIO_BENCH_MIX:
+        audio_dsp_mix(o16, audio_bench_s16[1], AUDIO_BENCH_DSP_SAMPLES);
+        break;
+    case AUDIO_BENCH_GAIN:
+        audio_dsp_gain_init(&gain, 0x1800);
+        audio_dsp_gain_apply(&gain, o16, AUDIO_BENCH_DSP_FRAMES, 2);
+        break;
+    case AUDIO_BENCH_GAIN_RAMP:
+        audio_dsp_gain_init(&gain, AUDIO_DSP_GAIN_UNITY);
+        audio_dsp_gain_set(&gain, AUDIO_DSP_GAIN_UNITY / 4,
+                           AUDIO_BENCH_DSP_FRAMES / 2);
+        audio_dsp_gain_apply(&gain, o16, AUDIO_BENCH_DSP_FRAMES, 2);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Time every sample kernel and check it against its reference
+ * @return number of kernels whose output differs from the reference
+ */
+static unsigned int audio_bench_dsp(void)
+{
+    uint32_t kernel_cycles, ref_cycles, start;
+    unsigned int failures = 0;
+    unsigned int kernel;
+    unsigned int i;
+    bool in_place;
+    bool match;
+
+    cycle_counter_init();
+
+    /* Full scale noise, with the extremes to hit the saturations */
+    audio_bench_seed = 1;
+    for (i = 0; i < AUDIO_BENCH_DSP_SAMPLES; i++) {
+        audio_bench_s16[0][i] = audio_bench_random();
+        audio_bench_s16[1][i] = audio_bench_random();
+        audio_bench_s32[i] = audio_bench_random() << 8 | (i & 0xff);
+    }
+    for (i = 0; i < sizeof(audio_bench_s24); i++) {
+        audio_bench_s24[i] = audio_bench_random();
+    }
+    audio_bench_s16[0][0] = INT16_MIN;
+    audio_bench_s16[0][1] = INT16_MAX;
+    audio_bench_s16[1][0] = INT16_MIN;
+    audio_bench_s16[1][1] = INT16_MAX;
+    audio_bench_s32[0] = INT32_MAX;
+    audio_bench_s32[1] = INT32_MIN;
+
+    for (kernel = 0; kernel < AUDIO_BENCH_NUM_KERNELS; kernel++) {
+        in_place = kernel >= AUDIO_BENCH_MIX;
+        kernel_cycles = 0;
+        ref_cycles = 0;
+
+        for (i = 0; i < AUDIO_BENCH_DSP_REPEAT; i++) {
+            memset(audio_bench_out, 0, sizeof(audio_bench_out));
+            if (in_place) {
+                memcpy(audio_bench_out[0], audio_bench_s16[0],
+                       sizeof(audio_bench_s16[0]));
+            }
+
+            start = cycle_counter_read();
+            audio_bench_kernel(kernel, audio_bench_out[0]);
+            kernel_cycles += cycle_counter_read() - start;
+
+            start = cycle_counter_read();
+            audio_bench_ref(kernel, audio_bench_out[1]);
+            ref_cycles += cycle_counter_read() - start;
+        }
+
+        match = !memcmp(audio_bench_out[0], audio_bench_out[1],
+                        sizeof(audio_bench_out[0]));
+        if (!match) {
+            failures++;
+        }
+
+        /* In hundredths of a cycle */
+        kernel_cycles = kernel_cycles * 100 /
+                        (AUDIO_BENCH_DSP_REPEAT * AUDIO_BENCH_DSP_SAMPLES);
+        ref_cycles = ref_cycles * 100 /
+                     (AUDIO_BENCH_DSP_REPEAT * AUDIO_BENCH_DSP_SAMPLES);
+
+        lowsyslog("audio-dsp: %s: %u.%02u cycles per sample, "
+                  "per-sample reference %u.%02u: %s\n",
+                  audio_bench_kernel_names[kernel], kernel_cycles / 100,
+                  kernel_cycles % 100, ref_cycles / 100, ref_cycles % 100,
+                  bench_match(match));
+    }
+
+    return failures;
+}
+
+/* Stands for unipro_rxbuf_free() */
+static void audio_bench_rx_release(void *buf, void *arg)
+{
+    audio_bench_rx_free |= 1 << (unsigned int)(uintptr_t)arg;
+}
+
+/**
+ * @brief Replay a link trace through the copying and the zero-copy paths
+ *
+ * Each packet takes a receive buffer from a small pool. The copying
+ * path writes it to the jitter buffer, which the I2S side reads into its
+ * period buffer. The zero-copy path queues the buffer itself, the DMA
+ * model walks the descriptors one period at a time and releases each one
+ * to the pool when done with it.
+ *
+ * @param zc Link trace and budget
+ * @return 0 if within budget, -EINVAL otherwise
+ */
+static int audio_bench_zero_copy(const struct audio_bench_zero_copy *zc)
+{
+    const struct audio_bench_link *link = zc->link;
+    struct audio_desc_ring *ring = &audio_bench_desc_ring;
+    struct audio_jitter *jb = &audio_bench_jitter;
+    const struct audio_desc *desc = NULL;
+    struct audio_desc_stats stats;
+    uint32_t copy_cycles = 0, zc_cycles = 0;
+    uint32_t copy_depth = 0, zc_depth = 0;
+    uint32_t copy_latency, zc_latency;
+    uint32_t dropped = 0;
+    uint32_t offset = 0;
+    uint32_t packet = 0;
+    uint32_t arrival, now, start, frames, need, r, i;
+    bool started = false;
+    bool regression;
+    int ret;
+
+    ret = audio_jitter_setup(jb, audio_bench_ring,
+                             AUDIO_BENCH_JITTER_CAPACITY,
+                             AUDIO_BENCH_CHANNELS, AUDIO_BENCH_RATE,
+                             AUDIO_BENCH_PERIOD);
+    if (ret) {
+        return ret;
+    }
+
+    ret = audio_desc_ring_setup(ring, audio_bench_descs,
+                                ARRAY_SIZE(audio_bench_descs));
+    if (ret) {
+        return ret;
+    }
+
+    audio_bench_rx_free = (1 << AUDIO_BENCH_RX_BUFFERS) - 1;
+    audio_bench_seed = 1;
+    arrival = audio_bench_arrival(link, 0, 0);
+
+    for (r = 0; r < AUDIO_BENCH_JITTER_READS; r++) {
+        now = r * AUDIO_BENCH_PERIOD_US;
+
+        while ((int32_t)(arrival - now) <= 0) {
+            if (!audio_bench_rx_free) {
+                dropped++;
+            } else {
+                i = __builtin_ctz(audio_bench_rx_free);
+                audio_bench_rx_free &= ~(1 << i);
+
+                start = cycle_counter_read();
+                audio_jitter_write(jb, audio_bench_packet,
+                                   link->packet_frames, arrival);
+                copy_cycles += cycle_counter_read() - start;
+
+                start = cycle_counter_read();
+                if (audio_desc_ring_push(ring, NULL, audio_bench_packet,
+                                         link->packet_frames,
+                                         audio_bench_rx_release,
+                                         (void *)(uintptr_t)i)) {
+                    audio_bench_rx_release(NULL, (void *)(uintptr_t)i);
+                }
+                zc_cycles += cycle_counter_read() - start;
+            }
+
+            arrival = audio_bench_arrival(link, ++packet, arrival);
+        }
+
+        copy_depth += jb->count;
+        start = cycle_counter_read();
+        audio_jitter_read(jb, audio_bench_period, now);
+        copy_cycles += cycle_counter_read() - start;
+
+        started = started || ring->frames >= zc->prime_frames;
+        if (!started) {
+            continue;
+        }
+
+        zc_depth += ring->frames + (desc ? desc->frames - offset : 0);
+
+        /* The DMA plays silence for the rest of the period if it runs dry */
+        start = cycle_counter_read();
+        for (need = AUDIO_BENCH_PERIOD; need; need -= frames) {
+            if (!desc) {
+                desc = audio_desc_ring_next(ring);
+                offset = 0;
+                if (!desc) {
+                    break;
+                }
+            }
+
+            frames = MIN(need, desc->frames - offset);
+            offset += frames;
+            if (offset == desc->frames) {
+                audio_desc_ring_complete(ring);
+                desc = NULL;
+            }
+        }
+        zc_cycles += cycle_counter_read() - start;
+    }
+
+    audio_desc_ring_get_stats(ring, &stats);
+
+    /* Hand the buffers back, as when the stream stops */
+    audio_desc_ring_flush(ring);
+
+    copy_latency = copy_depth / AUDIO_BENCH_JITTER_READS * 1000 /
+                   (AUDIO_BENCH_RATE / 1000);
+    zc_latency = zc_depth / AUDIO_BENCH_JITTER_READS * 1000 /
+                 (AUDIO_BENCH_RATE / 1000);
+
+    regression = stats.underruns > zc->max_underruns ||
+                 zc_latency > zc->max_latency_us;
+
+    /* In hundredths of a cycle */
+    copy_cycles = copy_cycles * 100ULL /
+                  (AUDIO_BENCH_JITTER_READS * AUDIO_BENCH_PERIOD);
+    zc_cycles = zc_cycles * 100ULL /
+                (AUDIO_BENCH_JITTER_READS * AUDIO_BENCH_PERIOD);
+
+    lowsyslog("audio-zc: %s: copy %u.%02u cycles per frame, latency %u us; "
+              "zero-copy %u.%02u cycles per frame, latency %u us (%u max), "
+              "%u underruns (%u max), %u dropped, %u buffers held: %s\n",
+              link->name, copy_cycles / 100, copy_cycles % 100,
+              copy_latency, zc_cycles / 100, zc_cycles % 100, zc_latency,
+              zc->max_latency_us, stats.underruns, zc->max_underruns,
+              dropped + stats.overruns, stats.peak,
+              bench_verdict(false, regression));
+
+    return regression ? -EINVAL : 0;
+}
+
+/* sin and cos of a small angle, by their Taylor series */
+static void audio_bench_sincos(double x, double *sn, double *cs)
+{
+    double x2 = x * x;
+
+    *sn = x * (1 - x2 / 6 * (1 - x2 / 20 * (1 - x2 / 42 * (1 - x2 / 72))));
+    *cs = 1 - x2 / 2 * (1 - x2 / 12 * (1 - x2 / 30 * (1 - x2 / 56)));
+}
+
+/* 10 * log10(x), in tenths of dB, from ln(x) = 2 * atanh((x - 1) / (x + 1)) */
+static int32_t audio_bench_db(double x)
+{
+    double z, z2;
+    int32_t e = 0;
+
+    if (x < 1e-12) {
+        x = 1e-12;
+    }
+    for (; x >= 2; x /= 2) {
+        e++;
+    }
+    for (; x < 1; x *= 2) {
+        e--;
+    }
+
+    z = (x - 1) / (x + 1);
+    z2 = z * z;
+    x = e * 0.693147181 +
+        2 * z * (1 + z2 * (1. / 3 + z2 * (1. / 5 + z2 * (1. / 7 + z2 / 9))));
+
+    return x * 100 / 2.302585093 + (x < 0 ? -0.5 : 0.5);
+}
+
+/**
+ * @brief Convert a tone and measure the distortion and the cost
+ *
+ * The output is fitted with a sine and a cosine of the tone frequency over
+ * a whole number of periods, what the fit leaves is distortion and noise.
+ *
+ * @param rates Conversion
+ * @return 0 if within budget, -EINVAL otherwise
+ */
+static int audio_bench_asrc_rates(const struct audio_bench_rates *rates)
+{
+    struct audio_asrc *asrc = &audio_bench_asrc;
+    double in_sin, in_cos, out_sin, out_cos;
+    double sn = 0, cs = 1, osn = 0, ocs = 1;
+    double fit_sin = 0, fit_cos = 0, power = 0;
+    double t;
+    uint32_t skip = rates->out_rate / 10;
+    uint32_t measured = rates->out_rate / 10;
+    uint32_t cycles = 0;
+    uint32_t n = 0;
+    uint32_t frames, done, used, start, i;
+    int32_t db;
+    int16_t y;
+    int ret;
+
+    ret = audio_asrc_setup(asrc, rates->in_rate, rates->out_rate,
+                           AUDIO_BENCH_CHANNELS);
+    if (ret) {
+        return ret;
+    }
+
+    audio_bench_sincos(2 * AUDIO_BENCH_PI * AUDIO_BENCH_TONE_HZ /
+                       rates->in_rate, &in_sin, &in_cos);
+    audio_bench_sincos(2 * AUDIO_BENCH_PI * AUDIO_BENCH_TONE_HZ /
+                       rates->out_rate, &out_sin, &out_cos);
+
+    while (n < skip + measured) {
+        for (i = 0; i < AUDIO_BENCH_PERIOD; i++) {
+            y = AUDIO_BENCH_TONE_AMPLITUDE * sn + (sn < 0 ? -0.5 : 0.5);
+            audio_bench_packet[2 * i] = y;
+            audio_bench_packet[2 * i + 1] = y;
+
+            t = sn * in_cos + cs * in_sin;
+            cs = cs * in_cos - sn * in_sin;
+            sn = t;
+        }
+
+        for (used = 0; used < AUDIO_BENCH_PERIOD; used += frames) {
+            frames = AUDIO_BENCH_PERIOD - used;
+
+            start = cycle_counter_read();
+            done = audio_asrc_process(asrc, audio_bench_packet +
+                                      used * AUDIO_BENCH_CHANNELS, &frames,
+                                      audio_bench_period, AUDIO_BENCH_PERIOD);
+            cycles += cycle_counter_read() - start;
+
+            for (i = 0; i < done; i++, n++) {
+                if (n < skip || n >= skip + measured) {
+                    continue;
+                }
+
+                y = audio_bench_period[i * AUDIO_BENCH_CHANNELS];
+                fit_sin += y * osn;
+                fit_cos += y * ocs;
+                power += (double)y * y;
+
+                t = osn * out_cos + ocs * out_sin;
+                ocs = ocs * out_cos - osn * out_sin;
+                osn = t;
+            }
+        }
+    }
+
+    /* Residual power over the tone power */
+    db = audio_bench_db(measured * power /
+                        (2 * (fit_sin * fit_sin + fit_cos * fit_cos)) - 1);
+    db = MIN(db, 0);
+
+    /* In hundredths of a cycle, per stereo frame */
+    cycles = cycles * 100 / n;
+
+    lowsyslog("audio-asrc: %u to %u Hz: THD+N -%u.%u dB (-%u max), "
+              "%u.%02u cycles per frame: %s\n",
+              rates->in_rate, rates->out_rate, -db / 10, -db % 10,
+              -rates->max_thdn_db, cycles / 100, cycles % 100,
+              bench_verdict(false, db > rates->max_thdn_db * 10));
+
+    return db > rates->max_thdn_db * 10 ? -EINVAL : 0;
+}
+
+/**
+ * @brief Follow the AP clock drift with the converter
+ *
+ * The AP fills a FIFO at its own rate, the I2S side empties it through the
+ * converter one period at a time and steers the ratio on the FIFO fill.
+ *
+ * @param drift Drift trace
+ * @return 0 if within budget, -EINVAL otherwise
+ */
+static int audio_bench_asrc_drift(const struct audio_bench_drift *drift)
+{
+    struct audio_asrc *asrc = &audio_bench_asrc;
+    uint32_t target = drift->packet_frames + AUDIO_BENCH_PERIOD;
+    uint32_t fill = target;
+    uint32_t deviation = 0;
+    uint32_t underruns = 0;
+    uint32_t overruns = 0;
+    uint64_t written = 0;
+    uint64_t due;
+    uint32_t frames, done, r;
+    int32_t ppm_error;
+    int32_t error;
+    bool regression;
+    int ret;
+
+    ret = audio_asrc_setup(asrc, drift->in_rate, AUDIO_BENCH_RATE,
+                           AUDIO_BENCH_CHANNELS);
+    if (ret) {
+        return ret;
+    }
+
+    memset(audio_bench_fifo, 0, sizeof(audio_bench_fifo));
+
+    for (r = 0; r < AUDIO_BENCH_DRIFT_READS; r++) {
+        /* Frames the AP has produced by the end of the period */
+        due = (uint64_t)(r + 1) * drift->in_rate *
+              (1000000 + drift->ppm) / 1000000000;
+        for (; written + drift->packet_frames <= due;
+             written += drift->packet_frames) {
+            if (fill + drift->packet_frames > AUDIO_BENCH_DRIFT_CAPACITY) {
+                overruns++;
+                continue;
+            }
+
+            memcpy(&audio_bench_fifo[fill * AUDIO_BENCH_CHANNELS],
+                   audio_bench_packet, drift->packet_frames *
+                   AUDIO_BENCH_CHANNELS * sizeof(int16_t));
+            fill += drift->packet_frames;
+        }
+
+        frames = fill;
+        done = audio_asrc_process(asrc, audio_bench_fifo, &frames,
+                                  audio_bench_period, AUDIO_BENCH_PERIOD);
+        if (done < AUDIO_BENCH_PERIOD) {
+            underruns++;
+        }
+
+        fill -= frames;
+        memmove(audio_bench_fifo,
+                &audio_bench_fifo[frames * AUDIO_BENCH_CHANNELS],
+                fill * AUDIO_BENCH_CHANNELS * sizeof(int16_t));
+
+        /*
+         * Like the jitter buffer playout, count what the AP has produced
+         * since its last packet: the fill alone moves a packet at a time.
+         */
+        error = fill + (uint32_t)(due - written) - target;
+        audio_asrc_steer(asrc, error);
+
+        if (r >= AUDIO_BENCH_DRIFT_SETTLE) {
+            deviation = MAX(deviation, (uint32_t)(error < 0 ? -error : error));
+        }
+    }
+
+    ppm_error = audio_asrc_get_correction(asrc) / 1000 - drift->ppm;
+    ppm_error = ppm_error < 0 ? -ppm_error : ppm_error;
+    regression = underruns || overruns || deviation > drift->max_deviation ||
+                 ppm_error > drift->max_ppm_error;
+
+    lowsyslog("audio-asrc: drift %s: correction %d ppm, off by %u ppm "
+              "(%u max), %u underruns, %u overruns, deviation %u frames "
+              "(%u max): %s\n",
+              drift->name, audio_asrc_get_correction(asrc) / 1000,
+              ppm_error, drift->max_ppm_error, underruns, overruns,
+              deviation, drift->max_deviation,
+              bench_verdict(false, regression));
+
+    return regression ? -EINVAL : 0;
+}
+
+/**
+ * @brief Measure the converter at each rate pair, and against drift
+ * @return number of traces out of budget
+ */
+static unsigned int audio_bench_converter(void)
+{
+    unsigned int failures = 0;
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_SIZE(audio_bench_rates); i++) {
+        if (audio_bench_asrc_rates(&audio_bench_rates[i])) {
+            failures++;
+        }
+    }
+
+    for (i = 0; i < ARRAY_SIZE(audio_bench_drifts); i++) {
+        if (audio_bench_asrc_drift(&audio_bench_drifts[i])) {
+            failures++;
+        }
+    }
+
+    bench_summary("audio-bench", "converter traces",
+                  ARRAY_SIZE(audio_bench_rates) +
+                  ARRAY_SIZE(audio_bench_drifts), failures);
+
+    return failures;
+}
+
+int audio_bench(void)
+{
+    unsigned int zc_failures = 0;
+    unsigned int failures = 0;
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_SIZE(audio_bench_links); i++) {
+        if (audio_bench_jitter_link(&audio_bench_links[i])) {
+            failures++;
+        }
+    }
+
+    bench_summary("audio-bench", "link traces",
+                  ARRAY_SIZE(audio_bench_links), failures);
+
+    for (i = 0; i < ARRAY_SIZE(audio_bench_zero_copies); i++) {
+        if (audio_bench_zero_copy(&audio_bench_zero_copies[i])) {
+            zc_failures++;
+        }
+    }
+
+    bench_summary("audio-bench", "zero-copy traces",
+                  ARRAY_SIZE(audio_bench_zero_copies), zc_failures);
+
+    failures += zc_failures;
+    failures += audio_bench_dsp();
+    failures += audio_bench_converter();
+
+    return failures ? -EINVAL : 0;
+}
+
+#endif /* CONFIG_ARA_AUDIO_BENCH */
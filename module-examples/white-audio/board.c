@@ -37,9 +37,19 @@
 #include <nuttx/device_codec.h>
 #include <nuttx/ara/audio_board.h>
 
+#include "audio_bench.h"
+
 extern struct device_driver audio_board_driver;
 extern struct device_driver rt5647_codec;
 
+/*
+ * One DAI carries both playback and capture. The bridge has a single I2S
+ * port whose transmitter and receiver share the bit and frame clocks, so
+ * both directions always run at the same rate and format. The AP activates
+ * them independently (ACTIVATE_TX / ACTIVATE_RX) on the same data CPort,
+ * which is bidirectional. A second DAI would need a second I2S port: both
+ * DAIs would try to open I2S 0 and the second one would fail.
+ */
 static struct audio_board_dai white_audio_dais_bundle_0[] = {
     {
         .data_cport = 4, /* Must match Audio DATA CPort in manifest */
@@ -105,4 +115,8 @@ void ara_module_init(void)
 
     device_register_driver(&audio_board_driver);
     device_register_driver(&rt5647_codec);
+
+#ifdef CONFIG_ARA_AUDIO_BENCH
+    audio_bench();
+#endif
 }
@@ -1,6 +1,15 @@
 config		= config
 manifest	= manifest.mnfs
 board-files	= board.c
+board-files	+= audio_bench.c
+
+# Data path library: only the bench calls it so far, build it with the bench
+ifneq ($(shell grep -sx CONFIG_ARA_AUDIO_BENCH=y $(MODULE_PATH)/$(config)),)
+board-files	+= common/audio_asrc.c
+board-files	+= common/audio_desc_ring.c
+board-files	+= common/audio_dsp.c
+board-files	+= common/audio_jitter.c
+endif
 
 vendor_id	= 0x00000001
 product_id	= 0x00000002
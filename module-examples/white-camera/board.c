@@ -27,24 +27,34 @@
  */
 
 #include <errno.h>
+#include <semaphore.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
+#include <nuttx/clock.h>
 #include <nuttx/device.h>
 #include <nuttx/device_camera.h>
+#include <nuttx/device_resource.h>
 #include <nuttx/device_table.h>
+#include <nuttx/fs/fs.h>
 #include <nuttx/gpio.h>
 #include <nuttx/i2c.h>
 #include <nuttx/kmalloc.h>
 #include <nuttx/util.h>
+#include <nuttx/wqueue.h>
 
 #include <arch/tsb/csi.h>
 #include "camera_capability.h"
+#include "common/i2c_trace.h"
+#include "common/timer_wheel.h"
+#include "ov5645_model.h"
+
 /* OV5645 I2C port and address */
-#define OV5645_I2C_PORT                 0
+/* Slave address after reset, moved through REG_SCCB_ID if it must differ */
 #define OV5645_I2C_ADDR                 0x3c
 
 /* OV5645 registers */
@@ -54,13 +64,146 @@
 
 #define REG_STREAM_ONOFF                0x4202
 
+#define REG_AEC_EXPOSURE                0x3500 /* 0x3500 - 0x3502 */
+#define REG_AEC_MANUAL                  0x3503
+#define AEC_MANUAL_AEC                  0x01
+#define AEC_MANUAL_AGC                  0x02
+#define REG_AEC_GAIN                    0x350a /* 0x350a - 0x350b */
+
+#define REG_GROUP_ACCESS                0x3212
+#define GROUP_ACCESS_START              0x00
+#define GROUP_ACCESS_END                0x10
+#define GROUP_ACCESS_LAUNCH             0xa0
+
+#define REG_SCCB_ID                     0x3100
+
+#define REG_SYSTEM_RESET00              0x3000
+#define SYSTEM_RESET00_MCU              0x20
+
+/* AF microcontroller command interface */
+#define REG_AF_CMD_MAIN                 0x3022
+#define REG_AF_CMD_ACK                  0x3023
+#define REG_AF_CMD_PARA0                0x3024
+#define REG_AF_CMD_PARA4                0x3028
+#define REG_AF_FW_STATUS                0x3029
+#define AF_CMD_TRIGGER                  0x03
+#define AF_CMD_CONTINUOUS               0x04
+#define AF_CMD_RELEASE                  0x08
+#define AF_STATUS_FOCUSING              0x00
+#define AF_STATUS_FOCUSED               0x10
+#define AF_STATUS_IDLE                  0x70
+#define AF_STATUS_FIRMWARE              0x7f
+
+#define REG_PLL_CTRL1                   0x3035
+#define PLL_CTRL1_SYSDIV_SHIFT          4
+#define PLL_CTRL1_MIPI_DIV1             0x01
+#define REG_PLL_CTRL2                   0x3036
+#define REG_TIMING_X_START_HIGH         0x3800
+#define REG_TIMING_X_START_LOW          0x3801
+#define REG_TIMING_Y_START_HIGH         0x3802
+#define REG_TIMING_Y_START_LOW          0x3803
+#define REG_TIMING_X_END_HIGH           0x3804
+#define REG_TIMING_X_END_LOW            0x3805
+#define REG_TIMING_Y_END_HIGH           0x3806
+#define REG_TIMING_Y_END_LOW            0x3807
+#define REG_TIMING_HTS_HIGH             0x380c
+#define REG_TIMING_HTS_LOW              0x380d
+#define REG_TIMING_VTS_HIGH             0x380e
+#define REG_TIMING_VTS_LOW              0x380f
+#define REG_TIMING_X_OFFSET_HIGH        0x3810
+#define REG_TIMING_X_OFFSET_LOW         0x3811
+#define REG_TIMING_Y_OFFSET_HIGH        0x3812
+#define REG_TIMING_Y_OFFSET_LOW         0x3813
+#define REG_TIMING_TC_REG20             0x3820
+#define TIMING_TC_BINNING               0x01
+#define REG_ISP_CONTROL01               0x5001
+#define ISP_CONTROL01_SCALE_ENABLE      0x20
+#define REG_AEC_B50_STEP_HIGH           0x3a08
+#define REG_AEC_B50_STEP_LOW            0x3a09
+#define REG_AEC_B60_STEP_HIGH           0x3a0a
+#define REG_AEC_B60_STEP_LOW            0x3a0b
+#define REG_AEC_CTRL0D                  0x3a0d /* bands per frame at 60Hz */
+#define REG_AEC_CTRL0E                  0x3a0e /* bands per frame at 50Hz */
+#define REG_MIPI_PCLK_PERIOD            0x4837
+
+#define REG_PRE_ISP_TEST                0x503d
+#define PRE_ISP_TEST_ENABLE             0x80
+#define PRE_ISP_TEST_BAR_GRADUAL        0x04
+#define PRE_ISP_TEST_COLOR_BAR          0x00
+#define PRE_ISP_TEST_RANDOM             0x01
+#define PRE_ISP_TEST_BLACK              0x03
+
+#define REG_TIMING_TC_REG21             0x3821
+#define TIMING_TC_JPEG_ENABLE           0x20
+/* TIMING_TC_BINNING is bit 0 of both REG20 (vertical) and REG21 (horizontal) */
+
+#define REG_JPEG_QSCALE                 0x4407
+#define JPEG_QSCALE_MIN                 0x01
+#define JPEG_QSCALE_MAX                 0x3f
+
+/* The JPEG stream is sent with the first MIPI user defined 8-bit data type. */
+#define OV5645_MIPI_DT_JPEG             0x30
+
 #define OV5645_REG_END                  0xffff
 
-/* OV5645 GPIOs */
+/* AF firmware load address, and largest auto-increment write burst */
+#define OV5645_AF_FW_ADDR               0x8000
+#define OV5645_I2C_BURST_SIZE           256
+
+/* AF status polling period and focus timeout */
+#define OV5645_AF_POLL_MS               10
+#define OV5645_AF_TIMEOUT_US            1500000
+
+/*
+ * Time the sensor stays powered once released, so that a new configuration
+ * soon after skips the power up sequence.
+ */
+#define OV5645_STANDBY_MS               2000
+
+/* Exposure bracketing: longest list, group used and limits */
+#define OV5645_BRACKET_MAX              8
+#define OV5645_BRACKET_GROUP            0
+#define OV5645_EV_COMPENSATION_MAX      9       /* 1/3 EV steps */
+#define OV5645_AEC_GAIN_MAX             0x3ff
+#define OV5645_AEC_EXPOSURE_MARGIN      4       /* lines short of VTS */
+
+/* Path of the character device reporting AF state and statistics */
+#define OV5645_AF_DEVPATH               "/dev/ov5645af%u"
+#define OV5645_AF_DEVPATH_LEN           16
+
+/* OV5645 GPIOs, the second sensor is only fitted on dual camera boards */
 #define OV5645_GPIO_RESET               7
 #define OV5645_GPIO_PWDN                8
+#define OV5645_1_GPIO_RESET             9
+#define OV5645_1_GPIO_PWDN              10
+
+/*
+ * OV5645 clock tree: the 24MHz XVCLK is divided by 3 ahead of the PLL, and
+ * each of the 2 MIPI lanes runs at the PLL output (8MHz * multiplier).
+ */
+#define OV5645_PLL_REF_HZ               8000000
+#define OV5645_PLL_MULT_MIN             10      /* 80Mbps, D-PHY minimum */
+#define OV5645_PLL_MULT_MAX             125     /* 1Gbps per lane */
+#define OV5645_PLL_SYSDIV_MAX           15
+#define OV5645_MIPI_LANES               2
+#define OV5645_MIPI_BITS_PER_PIXEL      16
+#define OV5645_MIN_FPS                  5
 
-/* Define white module supported number of streams */
+/*
+ * Active pixel array, as output by the QSXGA mode. The readout window extends
+ * it by the ISP margins: 16 columns and 4 lines on each side.
+ */
+#define OV5645_ACTIVE_WIDTH             2592
+#define OV5645_ACTIVE_HEIGHT            1944
+#define OV5645_ISP_MARGIN_X             16
+#define OV5645_ISP_MARGIN_Y             4
+
+/*
+ * Define white module supported number of streams. Per-frame results are not
+ * sent in-band as CSI-2 embedded data: the bridge has no frame start event
+ * from the CDSI receiver to align them with, and the camera data CPort is fed
+ * by the CDSI block, not by software. They belong on the control path.
+ */
 #define WHITE_MODULE_MAX_STREAMS        1
 
 /**
@@ -71,17 +214,126 @@ enum ov5645_state {
     OV5645_STATE_CLOSED,
 };
 
+/**
+ * @brief Sensor supplies state
+ */
+enum ov5645_power {
+    OV5645_POWER_OFF,
+    OV5645_POWER_ON,
+    /** Powered but unused, until the standby timer expires */
+    OV5645_POWER_STANDBY,
+    /** Shutdown asserted, reset to assert on the next timer expiry */
+    OV5645_POWER_DOWN,
+};
+
+/**
+ * @brief Autofocus state, owned by the AF worker once the firmware loads
+ */
+struct ov5645_af {
+    struct work_s work;
+    /** Held by the worker while it talks to the AF microcontroller */
+    sem_t lock;
+    /** Set to make a running worker bail out */
+    volatile bool abort;
+    /** The firmware has been written and the microcontroller started */
+    bool loaded;
+    /** The microcontroller reported it is idle, commands can be sent */
+    bool ready;
+    /** Commands received before the firmware was ready */
+    volatile bool trigger_pending;
+    volatile bool mode_pending;
+    uint8_t mode;
+    /** CONTROL_AF_STATE reported to the AP */
+    volatile uint8_t state;
+    uint32_t trigger_time;
+    uint32_t load_time;
+
+    /* Statistics */
+    uint32_t load_us;
+    uint32_t focus_count;
+    uint32_t focus_failures;
+    uint32_t focus_last_us;
+    uint32_t focus_min_us;
+    uint32_t focus_max_us;
+    uint32_t focus_total_us;
+};
+
+/**
+ * @brief Burst capture of a fixed number of frames
+ */
+struct ov5645_burst {
+    struct work_s work;
+    /** Held by the worker while it programs or stops the sensor */
+    sem_t lock;
+    volatile bool active;
+    /** The last frame has been captured and the stream stopped */
+    volatile bool done;
+    uint16_t num_frames;
+    /** Frame being exposed, counted from the stream start */
+    uint16_t frame;
+    /** Stream start time and frame duration, the worker deadlines base */
+    int64_t start_ns;
+    uint32_t frame_ns;
+    /** Bracketing list in 1/3 EV steps, one entry per frame */
+    int32_t compensation[OV5645_BRACKET_MAX];
+    unsigned int num_compensation;
+    /** AEC state at the start of the burst, the bracketing base */
+    bool manual;
+    uint8_t aec_manual;
+    uint32_t exposure;
+    uint16_t gain;
+};
+
+/**
+ * @brief Sensor wiring not expressible as device resources
+ */
+struct ov5645_board_data {
+    int i2c_port;
+    int csi_id;
+};
+
 /**
  * @brief private camera device information
  */
 struct sensor_info {
     struct device *dev;
+    const struct ov5645_board_data *board;
     struct i2c_dev_s *cam_i2c;
+    uint16_t i2c_addr;
+    unsigned int gpio_reset;
+    unsigned int gpio_pwdn;
+    char af_devpath[OV5645_AF_DEVPATH_LEN];
     enum ov5645_state state;
+    /** Power state and its standby timer, protected by power_lock */
+    enum ov5645_power power;
+    struct wheel_timer power_timer;
+    sem_t power_lock;
     struct cdsi_dev *cdsidev;
+    const struct ov5645_mode_info *mode;
+    const struct ov5645_clock_info *clock;
+    unsigned int vts_min;
+    /** Frame rate range requested by the AP */
+    int32_t min_fps;
+    int32_t target_fps;
+    int32_t crop[4];
+    struct ov5645_af af;
+    /** Current frame length and line time */
+    unsigned int vts;
+    uint32_t line_ns;
+    struct ov5645_burst burst;
     uint8_t req_id;
 };
 
+/*
+ * AF microcontroller firmware. It is distributed by the sensor vendor and not
+ * part of this tree: link a file defining both symbols to enable autofocus.
+ */
+extern const uint8_t ov5645_af_firmware[] __attribute__((weak));
+extern const size_t ov5645_af_firmware_size __attribute__((weak));
+
+/* Held while a sensor may answer the shared OV5645_I2C_ADDR after a reset */
+static sem_t ov5645_sccb_lock = SEM_INITIALIZER(1);
+
 /**
  * @brief Struct to store register and value for sensor read/write
  */
@@ -496,7 +748,9 @@ static const struct reg_val_tbl ov5645_setting_30fps_720p_1280_720[] = {
     {0x4005, 0x18}, // BLC update by gain change
     {0x4837, 0x16}, // MIPI global timing
     {0x3503, 0x00}, // AGC/AEC on
- };
+
+    {OV5645_REG_END, 0x00}, /* END MARKER */
+};
 #else
 /**
  * @brief ov5645 sensor registers for 30fps 720p
@@ -796,6 +1050,149 @@ static const struct reg_val_tbl ov5645_setting_30fps_SXGA_1280_960[] = {
     {OV5645_REG_END, 0x00}, /* END MARKER */
 };
 
+/**
+ * @brief ov5645 sensor registers for JPEG output, applied on top of a mode
+ *
+ * The ISP YUV output is fed to the JPEG encoder in mode 3: lines have a fixed
+ * width and the frame ends as soon as the compressed data does, so the number
+ * of lines, and the frame size, varies from frame to frame.
+ */
+static const struct reg_val_tbl ov5645_setting_jpeg[] = {
+    {0x3002, 0x00}, /* release the JPEG and JFIFO resets */
+    {0x3006, 0xff}, /* enable the JPEG clocks */
+    {0x4300, 0x30}, /* YUV 422, YUYV into the encoder */
+    {0x501f, 0x00}, /* select ISP YUV 422 */
+    {0x4713, 0x03}, /* JPEG mode 3 */
+    {0x4407, 0x04}, /* quantization scale */
+    {0x460b, 0x35}, /* VFIFO */
+    {0x460c, 0x22}, /* VFIFO, PCLK divider set manually */
+
+    {OV5645_REG_END, 0x00}, /* END MARKER */
+};
+
+/**
+ * @brief Clock tree and frame timing programmed by a mode register table
+ *
+ * The pixel clock of a table is hts * vts * fps. Other frame rates are derived
+ * from it by scaling the PLL multiplier and system divider, see
+ * ov5645_calc_timing().
+ */
+struct ov5645_clock_info {
+    /** Line length in pixel clocks */
+    unsigned int hts;
+    /** Minimum frame length in lines */
+    unsigned int vts;
+    /** Frame rate */
+    unsigned int fps;
+    /** System clock divider, 0x3035[7:4] */
+    uint8_t sysdiv;
+    /** PLL multiplier, 0x3036 */
+    uint8_t mult;
+    /** MIPI pixel clock period, 0x4837 */
+    uint8_t mipi_period;
+};
+
+static const struct ov5645_clock_info ov5645_clock_SXGA_1280_960 = {
+    .hts = 1896, .vts = 984, .fps = 30,
+    .sysdiv = 2, .mult = 0x70, .mipi_period = 0x10,
+};
+
+static const struct ov5645_clock_info ov5645_clock_1080p_1920_1080 = {
+    .hts = 2500, .vts = 1120, .fps = 30,
+    .sysdiv = 2, .mult = 0x70, .mipi_period = 0x10,
+};
+
+static const struct ov5645_clock_info ov5645_clock_QSXGA_2592_1944 = {
+    .hts = 2844, .vts = 1968, .fps = 15,
+    .sysdiv = 2, .mult = 0x54, .mipi_period = 0x10,
+};
+
+static const struct ov5645_clock_info ov5645_clock_720p_1280_720 = {
+    .hts = 1892, .vts = 740, .fps = 30,
+    .sysdiv = 2, .mult = 0x54, .mipi_period = 0x16,
+};
+
+static const struct ov5645_clock_info ov5645_clock_XGA_1024_768 = {
+    .hts = 1896, .vts = 984, .fps = 30,
+    .sysdiv = 1, .mult = 0x70, .mipi_period = 0x16,
+};
+
+static const struct ov5645_clock_info ov5645_clock_VGA_640_480 = {
+    .hts = 1896, .vts = 1080, .fps = 30,
+    .sysdiv = 1, .mult = 0x46, .mipi_period = 0x16,
+};
+
+/**
+ * @brief Registers derived from a requested frame rate
+ */
+struct ov5645_frame_timing {
+    unsigned int fps;
+    uint16_t hts;
+    uint8_t sysdiv;
+    uint8_t mult;
+    uint8_t mipi_period;
+    uint16_t vts;
+    uint32_t line_ns;
+    uint16_t b50_step;
+    uint16_t b60_step;
+    uint8_t b50_max;
+    uint8_t b60_max;
+};
+
+/**
+ * @brief Pixel array readout used when the crop region is reprogrammed
+ *
+ * Binned readout halves the pixels read and is used as long as the crop
+ * region is at least twice the output size; the full resolution readout
+ * covers deeper zoom factors. Analog settings and clocks are those of the SXGA
+ * and QSXGA register tables respectively.
+ */
+struct ov5645_readout {
+    unsigned int bin;
+    /** Blanking lines added to the window height to get the minimum VTS */
+    unsigned int vblank;
+    const struct reg_val_tbl *regs;
+    const struct ov5645_clock_info *clock;
+};
+
+static const struct reg_val_tbl ov5645_setting_readout_binned[] = {
+    {0x3618, 0x00},
+    {0x3600, 0x09},
+    {0x3601, 0x43},
+    {0x3708, 0x66},
+    {0x370c, 0xc3},
+    {0x3814, 0x31}, /* X INC */
+    {0x3815, 0x31}, /* Y INC */
+
+    {OV5645_REG_END, 0x00}, /* END MARKER */
+};
+
+static const struct reg_val_tbl ov5645_setting_readout_full[] = {
+    {0x3618, 0x04},
+    {0x3600, 0x08},
+    {0x3601, 0x33},
+    {0x3708, 0x63},
+    {0x370c, 0xc0},
+    {0x3814, 0x11}, /* X INC */
+    {0x3815, 0x11}, /* Y INC */
+
+    {OV5645_REG_END, 0x00}, /* END MARKER */
+};
+
+static const struct ov5645_readout ov5645_readout_binned = {
+    .bin    = 2,
+    .vblank = 12,
+    .regs   = ov5645_setting_readout_binned,
+    .clock  = &ov5645_clock_SXGA_1280_960,
+};
+
+static const struct ov5645_readout ov5645_readout_full = {
+    .bin    = 1,
+    .vblank = 16,
+    .regs   = ov5645_setting_readout_full,
+    .clock  = &ov5645_clock_QSXGA_2592_1944,
+};
+
 /**
  * @brief ov5645 sensor mode
  */
@@ -807,6 +1204,7 @@ struct ov5645_mode_info {
     unsigned int frame_max_size;
 
     const struct reg_val_tbl *regs;
+    const struct ov5645_clock_info *clock;
 };
 
 /*
@@ -822,6 +1220,7 @@ static const struct ov5645_mode_info ov5645_mode_settings[] = {
         .format         = CAMERA_UYVY422_PACKED,
         .frame_max_size = 1280 * 960 * 2,
         .regs           = ov5645_setting_30fps_SXGA_1280_960,
+        .clock          = &ov5645_clock_SXGA_1280_960,
     },
     /* 1080p - 1920*1080 */
     {
@@ -831,6 +1230,7 @@ static const struct ov5645_mode_info ov5645_mode_settings[] = {
         .format         = CAMERA_UYVY422_PACKED,
         .frame_max_size = 1920 * 1080 * 2,
         .regs           = ov5645_setting_30fps_1080p_1920_1080,
+        .clock          = &ov5645_clock_1080p_1920_1080,
     },
     /* QSXGA - 2592*1944 */
     {
@@ -840,6 +1240,7 @@ static const struct ov5645_mode_info ov5645_mode_settings[] = {
         .format         = CAMERA_UYVY422_PACKED,
         .frame_max_size = 2592 * 1944 * 2,
         .regs           = ov5645_setting_15fps_QSXGA_2592_1944,
+        .clock          = &ov5645_clock_QSXGA_2592_1944,
     },
     /* 720p - 1280*720 */
     {
@@ -849,6 +1250,7 @@ static const struct ov5645_mode_info ov5645_mode_settings[] = {
         .format         = CAMERA_UYVY422_PACKED,
         .frame_max_size = 1280 * 720 * 2,
         .regs           = ov5645_setting_30fps_720p_1280_720,
+        .clock          = &ov5645_clock_720p_1280_720,
     },
     /* XGA - 1024*768 */
     {
@@ -858,6 +1260,7 @@ static const struct ov5645_mode_info ov5645_mode_settings[] = {
         .format         = CAMERA_UYVY422_PACKED,
         .frame_max_size = 1024 * 768 * 2,
         .regs           = ov5645_setting_30fps_XGA_1024_768,
+        .clock          = &ov5645_clock_XGA_1024_768,
     },
     /* VGA - 640*480 */
     {
@@ -867,60 +1270,116 @@ static const struct ov5645_mode_info ov5645_mode_settings[] = {
         .format         = CAMERA_UYVY422_PACKED,
         .frame_max_size = 640 * 480 * 2,
         .regs           = ov5645_setting_30fps_VGA_640_480,
+        .clock          = &ov5645_clock_VGA_640_480,
+    },
+    /* QSXGA JPEG - 2592*1944 */
+    {
+        .width          = 2592,
+        .height         = 1944,
+        .dtype          = OV5645_MIPI_DT_JPEG,
+        .format         = CAMERA_FORMAT_JPEG,
+        .frame_max_size = JPEG_MAX_FRAME_SIZE(2592, 1944),
+        .regs           = ov5645_setting_15fps_QSXGA_2592_1944,
+        .clock          = &ov5645_clock_QSXGA_2592_1944,
+    },
+    /* 1080p JPEG - 1920*1080 */
+    {
+        .width          = 1920,
+        .height         = 1080,
+        .dtype          = OV5645_MIPI_DT_JPEG,
+        .format         = CAMERA_FORMAT_JPEG,
+        .frame_max_size = JPEG_MAX_FRAME_SIZE(1920, 1080),
+        .regs           = ov5645_setting_30fps_1080p_1920_1080,
+        .clock          = &ov5645_clock_1080p_1920_1080,
+    },
+    /* SXGA JPEG - 1280*960 */
+    {
+        .width          = 1280,
+        .height         = 960,
+        .dtype          = OV5645_MIPI_DT_JPEG,
+        .format         = CAMERA_FORMAT_JPEG,
+        .frame_max_size = JPEG_MAX_FRAME_SIZE(1280, 960),
+        .regs           = ov5645_setting_30fps_SXGA_1280_960,
+        .clock          = &ov5645_clock_SXGA_1280_960,
     },
 };
 
 /**
- * @brief i2c read for camera sensor (It reads a single byte)
- * @param dev Pointer to structure of i2c device data
- * @param addr Address of i2c to read
- * @return the byte read on success or a negative error code on failure
+ * @brief i2c read for camera sensor (It reads a register range)
+ *
+ * The register address is sent once and the sensor auto-increments it, so the
+ * whole range is read in a single combined transaction.
+ *
+ * @param info Sensor data instance
+ * @param addr Address of the first register
+ * @param buf Buffer to store the register values
+ * @param len Number of registers to read
+ * @return zero for success or non-zero on any faillure
  */
-static int ov5645_read(struct i2c_dev_s *dev, uint16_t addr)
+static int ov5645_read_burst(struct sensor_info *info, uint16_t addr,
+                             uint8_t *buf, size_t len)
 {
     uint8_t cmd[2];
-    uint8_t buf;
     int ret;
     struct i2c_msg_s msg[] = {
         {
-            .addr = OV5645_I2C_ADDR,
+            .addr = info->i2c_addr,
             .flags = 0,
             .buffer = cmd,
             .length = 2,
         }, {
-            .addr = OV5645_I2C_ADDR,
+            .addr = info->i2c_addr,
             .flags = I2C_M_READ,
-            .buffer = &buf,
-            .length = 1,
+            .buffer = buf,
+            .length = len,
         }
     };
 
     cmd[0] = (addr >> 8) & 0xff;
     cmd[1] = addr & 0xff;
 
-    ret = I2C_TRANSFER(dev, msg, 2);
+    ret = i2c_trace_transfer(info->cam_i2c, msg, 2);
     if (ret != OK) {
-        printf("ov5645: i2c read failed\n", ret);
+        printf("ov5645: i2c read failed\n");
         return -EIO;
     }
 
+    return 0;
+}
+
+/**
+ * @brief i2c read for camera sensor (It reads a single byte)
+ * @param info Sensor data instance
+ * @param addr Address of i2c to read
+ * @return the byte read on success or a negative error code on failure
+ */
+static int ov5645_read(struct sensor_info *info, uint16_t addr)
+{
+    uint8_t buf;
+    int ret;
+
+    ret = ov5645_read_burst(info, addr, &buf, 1);
+    if (ret) {
+        return ret;
+    }
+
     return buf;
 }
 
 /**
  * @brief i2c write for camera sensor (It writes a single byte)
- * @param dev Pointer to structure of i2c device data
+ * @param info Sensor data instance
  * @param addr Address of i2c to write
  * @param data Data to write
  * @return zero for success or non-zero on any faillure
  */
-static int ov5645_write(struct i2c_dev_s *dev, uint16_t addr, uint8_t data)
+static int ov5645_write(struct sensor_info *info, uint16_t addr, uint8_t data)
 {
     uint8_t cmd[3];
     int ret;
     struct i2c_msg_s msg[] = {
         {
-            .addr = OV5645_I2C_ADDR,
+            .addr = info->i2c_addr,
             .flags = 0,
             .buffer = cmd,
             .length = 3,
@@ -931,7 +1390,7 @@ static int ov5645_write(struct i2c_dev_s *dev, uint16_t addr, uint8_t data)
     cmd[1] = addr & 0xFF;
     cmd[2] = data;
 
-    ret = I2C_TRANSFER(dev, msg, 1);
+    ret = i2c_trace_transfer(info->cam_i2c, msg, 1);
     if (ret != OK) {
         return -EIO;
     }
@@ -939,19 +1398,66 @@ static int ov5645_write(struct i2c_dev_s *dev, uint16_t addr, uint8_t data)
     return 0;
 }
 
+/**
+ * @brief i2c write for camera sensor (It writes a register range)
+ *
+ * The data is sent in auto-increment bursts of up to OV5645_I2C_BURST_SIZE
+ * bytes, one transaction each.
+ *
+ * @param info Sensor data instance
+ * @param addr Address of the first register
+ * @param data Data to write
+ * @param len Number of bytes to write
+ * @return zero for success or non-zero on any faillure
+ */
+static int ov5645_write_burst(struct sensor_info *info, uint16_t addr,
+                              const uint8_t *data, size_t len)
+{
+    uint8_t cmd[2 + OV5645_I2C_BURST_SIZE];
+    size_t chunk;
+    int ret;
+    struct i2c_msg_s msg[] = {
+        {
+            .addr = info->i2c_addr,
+            .flags = 0,
+            .buffer = cmd,
+        },
+    };
+
+    while (len) {
+        chunk = len < OV5645_I2C_BURST_SIZE ? len : OV5645_I2C_BURST_SIZE;
+
+        cmd[0] = (addr >> 8) & 0xff;
+        cmd[1] = addr & 0xff;
+        memcpy(&cmd[2], data, chunk);
+        msg[0].length = chunk + 2;
+
+        ret = i2c_trace_transfer(info->cam_i2c, msg, 1);
+        if (ret != OK) {
+            return -EIO;
+        }
+
+        addr += chunk;
+        data += chunk;
+        len -= chunk;
+    }
+
+    return 0;
+}
+
 /**
  * @brief i2c write for camera sensor (It writes array)
- * @param dev Pointer to structure of i2c device data
+ * @param info Sensor data instance
  * @param vals Address and values of i2c to write
  * @return zero for success or non-zero on any faillure
  */
-static int ov5645_write_array(struct i2c_dev_s *dev,
+static int ov5645_write_array(struct sensor_info *info,
                               const struct reg_val_tbl *vals)
 {
     int ret;
 
     for ( ; vals->reg_num < OV5645_REG_END; vals++) {
-        ret = ov5645_write(dev, vals->reg_num, vals->value);
+        ret = ov5645_write(info, vals->reg_num, vals->value);
         if (ret < 0) {
            return ret;
         }
@@ -960,102 +1466,1394 @@ static int ov5645_write_array(struct i2c_dev_s *dev,
     return 0;
 }
 
+/**
+ * @brief i2c read-modify-write for camera sensor
+ * @param info Sensor data instance
+ * @param addr Address of the register
+ * @param mask Bits to update
+ * @param value New value of the bits in mask
+ * @return zero for success or non-zero on any faillure
+ */
+static int ov5645_update_bits(struct sensor_info *info, uint16_t addr,
+                              uint8_t mask, uint8_t value)
+{
+    int ret;
+
+    ret = ov5645_read(info, addr);
+    if (ret < 0) {
+        return ret;
+    }
+
+    return ov5645_write(info, addr, (ret & ~mask) | (value & mask));
+}
+
 static int ov5645_set_stream(struct sensor_info *info, bool on)
 {
-    return ov5645_write(info->cam_i2c, REG_STREAM_ONOFF, on ? 0x00 : 0x0f);
+    return ov5645_write(info, REG_STREAM_ONOFF, on ? 0x00 : 0x0f);
 }
 
 /**
- * @brief Power up the sensor
+ * @brief Program the sensor test pattern generator
+ *
+ * The pattern replaces the pixel array output ahead of the ISP, so the frames
+ * still go through the whole CSI and UniPro path at the configured rate.
+ *
  * @param info Sensor data instance
+ * @param mode SENSOR_TEST_PATTERN_MODE value requested by the AP
+ * @return zero for success or non-zero on any faillure
  */
-static void ov5645_power_on(struct sensor_info *info)
+static int ov5645_set_test_pattern(struct sensor_info *info, int32_t mode)
 {
-    gpio_direction_out(OV5645_GPIO_PWDN, 0); /* shutdown -> L */
-    gpio_direction_out(OV5645_GPIO_RESET, 0); /* reset -> L */
-    usleep(5000);
+    uint8_t value;
 
-    gpio_direction_out(OV5645_GPIO_PWDN, 1); /* shutdown -> H */
-    usleep(1000);
+    switch (mode) {
+    case SENSOR_TEST_PATTERN_MODE_OFF:
+        value = 0;
+        break;
+    case SENSOR_TEST_PATTERN_MODE_SOLID_COLOR:
+        value = PRE_ISP_TEST_ENABLE | PRE_ISP_TEST_BLACK;
+        break;
+    case SENSOR_TEST_PATTERN_MODE_COLOR_BARS:
+        value = PRE_ISP_TEST_ENABLE | PRE_ISP_TEST_COLOR_BAR;
+        break;
+    case SENSOR_TEST_PATTERN_MODE_COLOR_BARS_FADE_TO_GRAY:
+        value = PRE_ISP_TEST_ENABLE | PRE_ISP_TEST_BAR_GRADUAL |
+                PRE_ISP_TEST_COLOR_BAR;
+        break;
+    case SENSOR_TEST_PATTERN_MODE_PN9:
+        value = PRE_ISP_TEST_ENABLE | PRE_ISP_TEST_RANDOM;
+        break;
+    default:
+        return -EINVAL;
+    }
 
-    gpio_direction_out(OV5645_GPIO_RESET, 1); /* reset -> H */
-    usleep(1000);
+    return ov5645_write(info, REG_PRE_ISP_TEST, value);
 }
 
 /**
- * @brief Power down the sensor
+ * @brief Set the JPEG encoder quality
+ *
+ * The encoder quantization scale goes from 1 (finest) to 63 (coarsest) and is
+ * mapped linearly onto the JPEG_QUALITY range.
+ *
  * @param info Sensor data instance
+ * @param quality JPEG_QUALITY value requested by the AP, 1 to 100
+ * @return zero for success or non-zero on any faillure
  */
-static void ov5645_power_off(struct sensor_info *info)
+static int ov5645_set_jpeg_quality(struct sensor_info *info, uint8_t quality)
 {
-    gpio_direction_out(OV5645_GPIO_PWDN, 0); /* shutdown -> L */
-    usleep(1000);
+    uint8_t qscale;
 
-    gpio_direction_out(OV5645_GPIO_RESET, 0); /* reset -> L */
-    usleep(1000);
+    if (quality < 1 || quality > 100) {
+        return -EINVAL;
+    }
+
+    qscale = JPEG_QSCALE_MIN +
+             (100 - quality) * (JPEG_QSCALE_MAX - JPEG_QSCALE_MIN) / 99;
+
+    return ov5645_write(info, REG_JPEG_QSCALE, qscale);
 }
 
 /**
- * @brief ov5645 sensor configuration function
- * @param info Sensor data instance
- * @param mode Mode to be configured
- * @return zero for success or non-zero on any faillure
+ * @brief Derive the clock tree and frame length for a frame rate
+ *
+ * The system divider is the smallest one that still lets the MIPI lanes carry
+ * a line within a line time, and the PLL multiplier the smallest one that
+ * reaches the frame rate with the mode minimum frame length. The frame length
+ * is then stretched to the exact frame rate, and the banding filter steps
+ * follow the resulting line time.
+ *
+ * @param clk Clock tree of the readout in use
+ * @param width Output width
+ * @param vts_min Minimum frame length in lines
+ * @param fps Requested frame rate, clamped to what the readout supports
+ * @param timing Derived register values
  */
-static int ov5645_configure(struct sensor_info *info,
-                            const struct ov5645_mode_info *mode)
+static void ov5645_calc_timing(const struct ov5645_clock_info *clk,
+                               unsigned int width, unsigned int vts_min,
+                               unsigned int fps,
+                               struct ov5645_frame_timing *timing)
 {
-    int ret;
-
-    /* Perform a software reset. */
-    ov5645_write(info->cam_i2c, 0x3103, 0x11); /* Select PLL input clock */
-    ov5645_write(info->cam_i2c, 0x3008, 0x82); /* Software reset */
-    usleep(5000);
+    unsigned int max_fps;
+    uint32_t pclk_unit;
+    uint32_t sysdiv;
+    uint32_t mult;
+    uint32_t pclk;
+    uint32_t line_pclk;
+
+    /* Pixel clock for a multiplier to divider ratio of 1 */
+    pclk_unit = (uint64_t)clk->hts * clk->vts * clk->fps * clk->sysdiv /
+                clk->mult;
+
+    sysdiv = ((uint64_t)width * pclk_unit * OV5645_MIPI_BITS_PER_PIXEL +
+              (uint64_t)clk->hts * OV5645_PLL_REF_HZ * OV5645_MIPI_LANES - 1) /
+             ((uint64_t)clk->hts * OV5645_PLL_REF_HZ * OV5645_MIPI_LANES);
+    if (sysdiv < 1) {
+        sysdiv = 1;
+    } else if (sysdiv > OV5645_PLL_SYSDIV_MAX) {
+        sysdiv = OV5645_PLL_SYSDIV_MAX;
+    }
 
-    /* Apply the initial configuration. */
-    ret = ov5645_write_array(info->cam_i2c, ov5645_init_setting);
-    if (ret < 0) {
-        return -EIO;
+    max_fps = (uint64_t)pclk_unit * OV5645_PLL_MULT_MAX /
+              ((uint64_t)sysdiv * clk->hts * vts_min);
+    if (fps > max_fps) {
+        fps = max_fps;
+    } else if (fps < OV5645_MIN_FPS) {
+        fps = OV5645_MIN_FPS;
     }
 
-    /* Set the mode. */
-    ret = ov5645_write_array(info->cam_i2c, mode->regs);
-    if (ret) {
-        printf("ov5645: failed to set mode\n", __func__);
-        return -EIO;
+    mult = ((uint64_t)clk->hts * vts_min * fps * sysdiv + pclk_unit - 1) /
+           pclk_unit;
+    if (mult < OV5645_PLL_MULT_MIN) {
+        mult = OV5645_PLL_MULT_MIN;
     }
 
-    return 0;
+    pclk = (uint64_t)pclk_unit * mult / sysdiv;
+    line_pclk = clk->hts * fps;
+
+    timing->fps = fps;
+    timing->hts = clk->hts;
+    timing->sysdiv = sysdiv;
+    timing->mult = mult;
+    timing->vts = pclk / line_pclk < 0xffff ? pclk / line_pclk : 0xffff;
+    timing->line_ns = (uint64_t)clk->hts * 1000000000 / pclk;
+    timing->b50_step = pclk / (clk->hts * 100);
+    timing->b60_step = pclk / (clk->hts * 120);
+    timing->b50_max = timing->vts / timing->b50_step;
+    timing->b60_max = timing->vts / timing->b60_step;
+    timing->mipi_period = clk->mipi_period * clk->mult / mult < 0xff ?
+                          clk->mipi_period * clk->mult / mult : 0xff;
 }
 
 /**
- * @brief Get capabilities of camera module
- * @param dev Pointer to structure of device data
- * @param capabilities Pointer that will be stored Camera Module capabilities.
- * @return 0 on success, negative errno on error
+ * @brief Write the registers derived by ov5645_calc_timing()
+ * @param info Sensor data instance
+ * @param timing Frame timing
+ * @return zero for success or non-zero on any faillure
  */
-static int camera_op_capabilities(struct device *dev, uint32_t *size,
-                                  uint8_t *capabilities)
+static int ov5645_write_timing(struct sensor_info *info,
+                               const struct ov5645_frame_timing *timing)
 {
-    int ret;
-    ret = get_capabilities(size, capabilities);
-    if (ret) {
-        printf("ov5645: failed to get capabilities\n", __func__);
-        return -EIO;
-    }
+    const struct reg_val_tbl regs[] = {
+        {REG_PLL_CTRL1, (timing->sysdiv << PLL_CTRL1_SYSDIV_SHIFT) |
+                        PLL_CTRL1_MIPI_DIV1},
+        {REG_PLL_CTRL2, timing->mult},
+        {REG_TIMING_HTS_HIGH, timing->hts >> 8},
+        {REG_TIMING_HTS_LOW, timing->hts & 0xff},
+        {REG_TIMING_VTS_HIGH, timing->vts >> 8},
+        {REG_TIMING_VTS_LOW, timing->vts & 0xff},
+        {REG_AEC_B50_STEP_HIGH, timing->b50_step >> 8},
+        {REG_AEC_B50_STEP_LOW, timing->b50_step & 0xff},
+        {REG_AEC_B60_STEP_HIGH, timing->b60_step >> 8},
+        {REG_AEC_B60_STEP_LOW, timing->b60_step & 0xff},
+        {REG_AEC_CTRL0E, timing->b50_max},
+        {REG_AEC_CTRL0D, timing->b60_max},
+        {REG_MIPI_PCLK_PERIOD, timing->mipi_period},
+
+        {OV5645_REG_END, 0x00}, /* END MARKER */
+    };
 
-    return 0;
+    return ov5645_write_array(info, regs);
 }
 
 /**
- * @brief Get required data size of camera module information
- * @param dev Pointer to structure of device data
- * @param capabilities Pointer that will be stored Camera Module capabilities.
- * @return 0 on success, negative errno on error
+ * @brief Reprogram the clock tree and frame length of the current readout
+ *
+ * The sensor runs at fps, or at the fastest rate of the readout if that is
+ * lower but still within the requested range.
+ *
+ * @param info Sensor data instance
+ * @param min_fps Lowest acceptable frame rate
+ * @param fps Requested frame rate
+ * @return zero for success, -EINVAL if the readout cannot reach min_fps, or
+ * non-zero on any other faillure
  */
-static int camera_op_get_required_size(struct device *dev, uint8_t operation,
-                                       uint16_t *size)
+static int ov5645_set_frame_rate(struct sensor_info *info,
+                                 unsigned int min_fps, unsigned int fps)
 {
-    switch (operation) {
+    struct ov5645_frame_timing timing;
+
+    ov5645_calc_timing(info->clock, info->mode->width, info->vts_min, fps,
+                       &timing);
+    if (timing.fps < min_fps) {
+        return -EINVAL;
+    }
+
+    info->vts = timing.vts;
+    info->line_ns = timing.line_ns;
+
+    return ov5645_write_timing(info, &timing);
+}
+
+/**
+ * @brief Current time in microseconds
+ */
+static uint32_t ov5645_now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief Download the AF firmware and start the AF microcontroller
+ *
+ * The firmware is written in auto-increment bursts, a few hundred transactions
+ * less than register by register writes. The AF worker then polls the
+ * firmware status until the microcontroller reports it is idle.
+ *
+ * @param info Sensor data instance
+ * @return zero for success or non-zero on any faillure
+ */
+static int ov5645_af_load(struct sensor_info *info)
+{
+    static const struct reg_val_tbl af_start[] = {
+        {REG_AF_CMD_MAIN, 0x00},
+        {REG_AF_CMD_ACK, 0x00},
+        {REG_AF_CMD_PARA0, 0x00},
+        {0x3025, 0x00},
+        {0x3026, 0x00},
+        {0x3027, 0x00},
+        {REG_AF_CMD_PARA4, 0x00},
+        {REG_AF_FW_STATUS, AF_STATUS_FIRMWARE},
+        {REG_SYSTEM_RESET00, 0x00}, /* release the MCU */
+
+        {OV5645_REG_END, 0x00}, /* END MARKER */
+    };
+    int ret;
+
+    if (!ov5645_af_firmware || !&ov5645_af_firmware_size) {
+        return -ENOENT;
+    }
+
+    /* Hold the MCU in reset while its RAM is written. */
+    ret = ov5645_write(info, REG_SYSTEM_RESET00, SYSTEM_RESET00_MCU);
+    if (ret) {
+        return ret;
+    }
+
+    ret = ov5645_write_burst(info, OV5645_AF_FW_ADDR,
+                             ov5645_af_firmware, ov5645_af_firmware_size);
+    if (ret) {
+        return ret;
+    }
+
+    return ov5645_write_array(info, af_start);
+}
+
+/**
+ * @brief Send a command to the AF microcontroller
+ *
+ * The firmware clears the acknowledge register once the command is taken.
+ *
+ * @param info Sensor data instance
+ * @param cmd AF_CMD_* command
+ * @return zero for success or non-zero on any faillure
+ */
+static int ov5645_af_command(struct sensor_info *info, uint8_t cmd)
+{
+    int ret;
+
+    ret = ov5645_write(info, REG_AF_CMD_ACK, 0x01);
+    if (ret) {
+        return ret;
+    }
+
+    return ov5645_write(info, REG_AF_CMD_MAIN, cmd);
+}
+
+/**
+ * @brief Record the outcome of a triggered focus sweep
+ * @param info Sensor data instance
+ * @param focused true if the lens locked on focus
+ */
+static void ov5645_af_done(struct sensor_info *info, bool focused)
+{
+    struct ov5645_af *af = &info->af;
+    uint32_t elapsed = ov5645_now_us() - af->trigger_time;
+
+    if (!focused) {
+        af->focus_failures++;
+        af->state = CONTROL_AF_STATE_NOT_FOCUSED_LOCKED;
+        return;
+    }
+
+    if (!af->focus_count || elapsed < af->focus_min_us) {
+        af->focus_min_us = elapsed;
+    }
+    if (elapsed > af->focus_max_us) {
+        af->focus_max_us = elapsed;
+    }
+
+    af->focus_count++;
+    af->focus_last_us = elapsed;
+    af->focus_total_us += elapsed;
+    af->state = CONTROL_AF_STATE_FOCUSED_LOCKED;
+}
+
+/**
+ * @brief AF worker
+ *
+ * Loads the firmware on its first run and waits for it to start, then
+ * forwards the pending mode and trigger requests and polls the focus sweep
+ * until it completes. It requeues itself every OV5645_AF_POLL_MS rather than
+ * sleeping, to leave the work queue to other users in the meantime.
+ *
+ * It runs on the low priority work queue: the firmware download holds the
+ * worker for the whole burst, and would otherwise delay the standby timer,
+ * the statistics and the capture bursts that run on the high priority one.
+ *
+ * @param arg Sensor data instance
+ */
+static void ov5645_af_worker(void *arg)
+{
+    struct sensor_info *info = arg;
+    struct ov5645_af *af = &info->af;
+    uint8_t af_regs[REG_AF_FW_STATUS - REG_AF_CMD_ACK + 1];
+    int ret;
+
+    sem_wait(&af->lock);
+
+    if (af->abort) {
+        goto done;
+    }
+
+    if (!af->loaded) {
+        af->load_time = ov5645_now_us();
+
+        ret = ov5645_af_load(info);
+        if (ret) {
+            if (ret != -ENOENT) {
+                printf("ov5645: AF firmware load failed (%d)\n", ret);
+            }
+            goto fail;
+        }
+
+        af->loaded = true;
+        goto requeue;
+    }
+
+    if (!af->ready) {
+        ret = ov5645_read(info, REG_AF_FW_STATUS);
+        if (ret == AF_STATUS_IDLE) {
+            af->ready = true;
+            af->load_us = ov5645_now_us() - af->load_time;
+        } else if (ret < 0 ||
+                   ov5645_now_us() - af->load_time > OV5645_AF_TIMEOUT_US) {
+            printf("ov5645: AF firmware did not start\n");
+            af->loaded = false;
+            goto fail;
+        } else {
+            goto requeue;
+        }
+    }
+
+    if (af->mode_pending) {
+        af->mode_pending = false;
+
+        switch (af->mode) {
+        case CONTROL_AF_MODE_CONTINUOUS_VIDEO:
+        case CONTROL_AF_MODE_CONTINUOUS_PICTURE:
+            ov5645_af_command(info, AF_CMD_CONTINUOUS);
+            af->state = CONTROL_AF_STATE_PASSIVE_SCAN;
+            break;
+        default:
+            ov5645_af_command(info, AF_CMD_RELEASE);
+            af->state = CONTROL_AF_STATE_INACTIVE;
+            break;
+        }
+    }
+
+    if (af->trigger_pending) {
+        af->trigger_pending = false;
+
+        ret = ov5645_af_command(info, AF_CMD_TRIGGER);
+        if (ret) {
+            af->state = CONTROL_AF_STATE_NOT_FOCUSED_LOCKED;
+            goto done;
+        }
+
+        af->state = CONTROL_AF_STATE_ACTIVE_SCAN;
+    }
+
+    if (af->state != CONTROL_AF_STATE_ACTIVE_SCAN) {
+        goto done;
+    }
+
+    /* Fetch the acknowledge and status registers in one transaction. */
+    ret = ov5645_read_burst(info, REG_AF_CMD_ACK, af_regs,
+                            sizeof(af_regs));
+    if (!ret && !af_regs[0] &&
+        af_regs[REG_AF_FW_STATUS - REG_AF_CMD_ACK] == AF_STATUS_FOCUSED) {
+        ov5645_af_done(info, true);
+        goto done;
+    }
+
+    if (ret < 0 || ov5645_now_us() - af->trigger_time > OV5645_AF_TIMEOUT_US) {
+        ov5645_af_done(info, false);
+        goto done;
+    }
+
+requeue:
+    work_queue(LPWORK, &af->work, ov5645_af_worker, info,
+               MSEC2TICK(OV5645_AF_POLL_MS));
+    goto done;
+
+fail:
+    /* Without firmware, a triggered sweep can only fail. */
+    if (af->trigger_pending) {
+        af->trigger_pending = false;
+        ov5645_af_done(info, false);
+    }
+
+done:
+    sem_post(&af->lock);
+}
+
+/**
+ * @brief Start the AF worker after the sensor has been configured
+ *
+ * The firmware download runs in the background so that the first frames are
+ * not delayed by it.
+ *
+ * @param info Sensor data instance
+ */
+static void ov5645_af_start(struct sensor_info *info)
+{
+    info->af.state = CONTROL_AF_STATE_INACTIVE;
+    work_queue(LPWORK, &info->af.work, ov5645_af_worker, info, 0);
+}
+
+/**
+ * @brief Stop the AF worker before the sensor is reset or powered off
+ * @param info Sensor data instance
+ */
+static void ov5645_af_stop(struct sensor_info *info)
+{
+    struct ov5645_af *af = &info->af;
+
+    af->abort = true;
+    work_cancel(LPWORK, &af->work);
+
+    /* Wait for a running worker to bail out. */
+    sem_wait(&af->lock);
+    work_cancel(LPWORK, &af->work);
+    af->loaded = false;
+    af->ready = false;
+    af->trigger_pending = false;
+    af->mode_pending = false;
+    af->mode = CONTROL_AF_MODE_OFF;
+    af->state = CONTROL_AF_STATE_INACTIVE;
+    af->abort = false;
+    sem_post(&af->lock);
+}
+
+/**
+ * @brief Forward the AF controls of a capture request to the AF worker
+ * @param info Sensor data instance
+ * @param capt_info Capture parameters
+ */
+static void ov5645_af_apply_settings(struct sensor_info *info,
+                                     struct capture_info *capt_info)
+{
+    struct ov5645_af *af = &info->af;
+    bool has_mode, has_trigger;
+    bool kick = false;
+    uint8_t mode, trigger;
+
+    has_mode = find_metadata(capt_info->settings, capt_info->settings_size,
+                             CONTROL_AF_MODE, &mode,
+                             sizeof(mode)) == sizeof(mode);
+    has_trigger = find_metadata(capt_info->settings,
+                                capt_info->settings_size, CONTROL_AF_TRIGGER,
+                                &trigger, sizeof(trigger)) == sizeof(trigger);
+
+    /* The worker reads and updates the requests under the lock. */
+    sem_wait(&af->lock);
+
+    if (has_mode && mode != af->mode) {
+        af->mode = mode;
+        af->mode_pending = true;
+        kick = true;
+    }
+
+    if (has_trigger) {
+        switch (trigger) {
+        case CONTROL_AF_TRIGGER_START:
+            af->trigger_time = ov5645_now_us();
+            af->trigger_pending = true;
+            af->state = CONTROL_AF_STATE_ACTIVE_SCAN;
+            kick = true;
+            break;
+        case CONTROL_AF_TRIGGER_CANCEL:
+            af->trigger_pending = false;
+            af->mode_pending = true;
+            kick = true;
+            break;
+        default:
+            break;
+        }
+    }
+
+    /*
+     * Only queue the worker when it is idle, a queued one picks the new
+     * requests up when it runs.
+     */
+    if (kick && work_available(&af->work)) {
+        work_queue(LPWORK, &af->work, ov5645_af_worker, info, 0);
+    }
+
+    sem_post(&af->lock);
+}
+
+static const char *const ov5645_af_state_names[] = {
+    [CONTROL_AF_STATE_INACTIVE]             = "inactive",
+    [CONTROL_AF_STATE_PASSIVE_SCAN]         = "passive-scan",
+    [CONTROL_AF_STATE_PASSIVE_FOCUSED]      = "passive-focused",
+    [CONTROL_AF_STATE_ACTIVE_SCAN]          = "active-scan",
+    [CONTROL_AF_STATE_FOCUSED_LOCKED]       = "focused-locked",
+    [CONTROL_AF_STATE_NOT_FOCUSED_LOCKED]   = "not-focused-locked",
+    [CONTROL_AF_STATE_PASSIVE_UNFOCUSED]    = "passive-unfocused",
+};
+
+static ssize_t ov5645_af_read(struct file *filep, char *buffer, size_t buflen)
+{
+    struct sensor_info *info = filep->f_inode->i_private;
+    struct ov5645_af *af = &info->af;
+    char report[256];
+    size_t len;
+
+    len = snprintf(report, sizeof(report),
+                   "state %s\n"
+                   "firmware %s, loaded in %u us\n"
+                   "focus %u locked, %u failed\n"
+                   "time to focus last %u us, min %u us, max %u us, "
+                   "avg %u us\n",
+                   ov5645_af_state_names[af->state],
+                   af->ready ? "ready" : "not loaded", af->load_us,
+                   af->focus_count, af->focus_failures, af->focus_last_us,
+                   af->focus_min_us, af->focus_max_us,
+                   af->focus_count ? af->focus_total_us / af->focus_count : 0);
+
+    if (filep->f_pos >= len) {
+        return 0;
+    }
+
+    len -= filep->f_pos;
+    if (len > buflen) {
+        len = buflen;
+    }
+
+    memcpy(buffer, report + filep->f_pos, len);
+    filep->f_pos += len;
+
+    return len;
+}
+
+static const struct file_operations ov5645_af_fops = {
+    .read   = ov5645_af_read,
+};
+
+/**
+ * @brief Scale an exposure by an exposure compensation
+ * @param value Exposure or gain to scale
+ * @param compensation Offset in CONTROL_AE_COMPENSATION_STEP (1/3 EV) units
+ * @return the scaled value
+ */
+static uint32_t ov5645_ev_scale(uint32_t value, int32_t compensation)
+{
+    /* 2^(n/3) in Q8 for n = 0..2 */
+    static const uint16_t ev_thirds[] = { 256, 323, 406 };
+    int32_t shift = compensation >= 0 ? compensation / 3 :
+                    -((2 - compensation) / 3);
+    uint64_t scaled = (uint64_t)value * ev_thirds[compensation - shift * 3];
+
+    scaled = shift >= 0 ? scaled << shift : scaled >> -shift;
+
+    return scaled >> 8;
+}
+
+/**
+ * @brief Program the exposure and gain of one bracketing step
+ *
+ * The registers are written in a group hold and launched together, so the
+ * step takes effect at once from the next frame the sensor starts.
+ *
+ * @param info Sensor data instance
+ * @param compensation Offset from the burst base, in 1/3 EV steps
+ * @return zero for success or non-zero on any faillure
+ */
+static int ov5645_burst_expose(struct sensor_info *info, int32_t compensation)
+{
+    struct ov5645_burst *burst = &info->burst;
+    uint32_t max_exposure = (info->vts - OV5645_AEC_EXPOSURE_MARGIN) << 4;
+    uint32_t exposure = ov5645_ev_scale(burst->exposure, compensation);
+    uint32_t gain = burst->gain;
+    uint8_t exposure_regs[3];
+    uint8_t gain_regs[2];
+    int ret;
+
+    /* Make up with gain for the exposure the frame length cannot fit. */
+    if (exposure > max_exposure) {
+        gain = gain * exposure / max_exposure;
+        exposure = max_exposure;
+    }
+
+    exposure = exposure < 16 ? 16 : exposure;
+    gain = gain > OV5645_AEC_GAIN_MAX ? OV5645_AEC_GAIN_MAX : gain;
+
+    exposure_regs[0] = (exposure >> 16) & 0x0f;
+    exposure_regs[1] = (exposure >> 8) & 0xff;
+    exposure_regs[2] = exposure & 0xff;
+    gain_regs[0] = (gain >> 8) & 0x03;
+    gain_regs[1] = gain & 0xff;
+
+    ret = ov5645_write(info, REG_GROUP_ACCESS,
+                       GROUP_ACCESS_START | OV5645_BRACKET_GROUP);
+    if (!ret) {
+        ret = ov5645_write_burst(info, REG_AEC_EXPOSURE, exposure_regs,
+                                 sizeof(exposure_regs));
+    }
+    if (!ret) {
+        ret = ov5645_write_burst(info, REG_AEC_GAIN, gain_regs,
+                                 sizeof(gain_regs));
+    }
+    if (!ret) {
+        ret = ov5645_write(info, REG_GROUP_ACCESS,
+                           GROUP_ACCESS_END | OV5645_BRACKET_GROUP);
+    }
+    if (!ret) {
+        ret = ov5645_write(info, REG_GROUP_ACCESS,
+                           GROUP_ACCESS_LAUNCH | OV5645_BRACKET_GROUP);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Bracketing step of a burst frame
+ *
+ * Frames past the end of the list reuse its last entry.
+ *
+ * @param burst Burst state
+ * @param frame Frame index in the burst
+ * @return offset from the burst base, in 1/3 EV steps
+ */
+static int32_t ov5645_burst_step(struct ov5645_burst *burst,
+                                 unsigned int frame)
+{
+    if (frame >= burst->num_compensation) {
+        frame = burst->num_compensation - 1;
+    }
+
+    return burst->compensation[frame];
+}
+
+/**
+ * @brief Give the exposure control back to the sensor AEC
+ * @param info Sensor data instance
+ */
+static void ov5645_burst_restore(struct sensor_info *info)
+{
+    struct ov5645_burst *burst = &info->burst;
+
+    if (burst->manual) {
+        ov5645_write(info, REG_AEC_MANUAL, burst->aec_manual);
+        burst->manual = false;
+    }
+}
+
+static void ov5645_burst_worker(void *arg);
+
+/**
+ * @brief Queue the burst worker in the middle of the frame being exposed
+ *
+ * The deadline is computed from the stream start, so the rounding of each
+ * delay to the system tick does not add up over the burst. The worker runs at
+ * most one tick after the deadline, which keeps it inside the frame as long as
+ * half a frame lasts longer than a tick.
+ *
+ * @param info Sensor data instance
+ */
+static void ov5645_burst_schedule(struct sensor_info *info)
+{
+    struct ov5645_burst *burst = &info->burst;
+    struct timespec ts;
+    uint32_t delay = 0;
+    int64_t deadline;
+    int64_t now;
+
+    deadline = burst->start_ns + (int64_t)burst->frame * burst->frame_ns +
+               burst->frame_ns / 2;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    now = (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+
+    /* The deadline is at most a frame away, the difference fits 32 bits. */
+    if (deadline > now) {
+        delay = ((uint32_t)(deadline - now) + NSEC_PER_TICK - 1) /
+                NSEC_PER_TICK;
+    }
+
+    work_queue(HPWORK, &burst->work, ov5645_burst_worker, info, delay);
+}
+
+/**
+ * @brief Burst frame counter
+ *
+ * Runs in the middle of every frame: programs the bracketing step of the next
+ * frame, or stops the stream during the last one so that it ends with it.
+ *
+ * @param arg Sensor data instance
+ */
+static void ov5645_burst_worker(void *arg)
+{
+    struct sensor_info *info = arg;
+    struct ov5645_burst *burst = &info->burst;
+
+    sem_wait(&burst->lock);
+
+    if (!burst->active) {
+        goto done;
+    }
+
+    if (burst->frame + 1 < burst->num_frames) {
+        burst->frame++;
+        if (burst->num_compensation) {
+            ov5645_burst_expose(info, ov5645_burst_step(burst, burst->frame));
+        }
+
+        ov5645_burst_schedule(info);
+        goto done;
+    }
+
+    /* The sensor stops streaming at the end of the frame in progress. */
+    ov5645_set_stream(info, false);
+    ov5645_burst_restore(info);
+    csi_rx_stop(info->cdsidev);
+
+    burst->active = false;
+    burst->done = true;
+
+done:
+    sem_post(&burst->lock);
+}
+
+/**
+ * @brief Prepare a burst from a capture request
+ *
+ * With a CONTROL_AE_EXPOSURE_COMPENSATION list in the request, the exposure
+ * and gain are taken over from the AEC and the first step is programmed.
+ *
+ * @param info Sensor data instance
+ * @param capt_info Capture parameters
+ * @return zero for success or non-zero on any faillure
+ */
+static int ov5645_burst_prepare(struct sensor_info *info,
+                                struct capture_info *capt_info)
+{
+    struct ov5645_burst *burst = &info->burst;
+    uint8_t aec[REG_AEC_GAIN - REG_AEC_EXPOSURE + 2];
+    unsigned int i;
+    int ret;
+
+    burst->done = false;
+    burst->frame = 0;
+    burst->num_frames = capt_info->num_frames;
+    burst->num_compensation = 0;
+
+    if (!burst->num_frames) {
+        return 0;
+    }
+
+    ret = find_metadata(capt_info->settings, capt_info->settings_size,
+                        CONTROL_AE_EXPOSURE_COMPENSATION,
+                        (uint8_t *)burst->compensation,
+                        sizeof(burst->compensation));
+    if (ret < (int)sizeof(burst->compensation[0])) {
+        return 0;
+    }
+
+    burst->num_compensation = ret / sizeof(burst->compensation[0]);
+    for (i = 0; i < burst->num_compensation; i++) {
+        if (burst->compensation[i] > OV5645_EV_COMPENSATION_MAX ||
+            burst->compensation[i] < -OV5645_EV_COMPENSATION_MAX) {
+            return -EINVAL;
+        }
+    }
+
+    /* Freeze the AEC and use its current values as the bracketing base. */
+    ret = ov5645_read_burst(info, REG_AEC_EXPOSURE, aec, sizeof(aec));
+    if (ret) {
+        return ret;
+    }
+
+    burst->aec_manual = aec[REG_AEC_MANUAL - REG_AEC_EXPOSURE];
+    burst->exposure = (aec[0] & 0x0f) << 16 | aec[1] << 8 | aec[2];
+    burst->gain = (aec[REG_AEC_GAIN - REG_AEC_EXPOSURE] & 0x03) << 8 |
+                  aec[REG_AEC_GAIN - REG_AEC_EXPOSURE + 1];
+
+    ret = ov5645_write(info, REG_AEC_MANUAL,
+                       burst->aec_manual | AEC_MANUAL_AEC | AEC_MANUAL_AGC);
+    if (ret) {
+        return ret;
+    }
+
+    burst->manual = true;
+
+    ret = ov5645_burst_expose(info, ov5645_burst_step(burst, 0));
+    if (ret) {
+        ov5645_burst_restore(info);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Start counting the burst frames once the stream is on
+ * @param info Sensor data instance
+ */
+static void ov5645_burst_start(struct sensor_info *info)
+{
+    struct ov5645_burst *burst = &info->burst;
+    struct timespec ts;
+
+    if (!burst->num_frames) {
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    burst->start_ns = (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    burst->frame_ns = info->vts * info->line_ns;
+
+    /* Tick in the middle of each frame, away from the frame boundaries. */
+    burst->active = true;
+    ov5645_burst_schedule(info);
+}
+
+/**
+ * @brief Cancel a burst in progress
+ * @param info Sensor data instance
+ */
+static void ov5645_burst_stop(struct sensor_info *info)
+{
+    struct ov5645_burst *burst = &info->burst;
+
+    burst->active = false;
+    work_cancel(HPWORK, &burst->work);
+
+    /* Wait for a running worker, which may have requeued itself. */
+    sem_wait(&burst->lock);
+    work_cancel(HPWORK, &burst->work);
+    ov5645_burst_restore(info);
+    sem_post(&burst->lock);
+}
+
+/**
+ * @brief Fit a crop region to the output of the current mode
+ *
+ * The region is shrunk around its center to the output aspect ratio, and
+ * grown back if needed so that every output pixel maps to at least one sensor
+ * pixel, as the sensor can downscale but not upscale.
+ *
+ * @param mode Sensor mode
+ * @param region SCALER_CROP_REGION (left, top, width, height) in active array
+ *               coordinates
+ * @param crop Resulting window, in the same format
+ */
+static void ov5645_fit_crop(const struct ov5645_mode_info *mode,
+                            const int32_t *region, int32_t *crop)
+{
+    int32_t center_x = region[0] + region[2] / 2;
+    int32_t center_y = region[1] + region[3] / 2;
+    int32_t width = region[2];
+    int32_t height = region[3];
+
+    if ((int64_t)width * mode->height > (int64_t)height * mode->width) {
+        width = height * mode->width / mode->height;
+    } else {
+        height = width * mode->height / mode->width;
+    }
+
+    if (width < mode->width || height < mode->height) {
+        width = mode->width;
+        height = mode->height;
+    }
+
+    if (width > OV5645_ACTIVE_WIDTH) {
+        width = OV5645_ACTIVE_WIDTH;
+        height = width * mode->height / mode->width;
+    }
+
+    if (height > OV5645_ACTIVE_HEIGHT) {
+        height = OV5645_ACTIVE_HEIGHT;
+        width = height * mode->width / mode->height;
+    }
+
+    /* Keep the window a multiple of the Bayer pattern once binned. */
+    width &= ~3;
+    height &= ~3;
+
+    crop[0] = center_x - width / 2;
+    if (crop[0] < 0) {
+        crop[0] = 0;
+    } else if (crop[0] > OV5645_ACTIVE_WIDTH - width) {
+        crop[0] = OV5645_ACTIVE_WIDTH - width;
+    }
+
+    crop[1] = center_y - height / 2;
+    if (crop[1] < 0) {
+        crop[1] = 0;
+    } else if (crop[1] > OV5645_ACTIVE_HEIGHT - height) {
+        crop[1] = OV5645_ACTIVE_HEIGHT - height;
+    }
+
+    crop[0] &= ~1;
+    crop[1] &= ~1;
+    crop[2] = width;
+    crop[3] = height;
+}
+
+/**
+ * @brief Write the readout window and ISP margins
+ * @param info Sensor data instance
+ * @param crop Window in active array coordinates
+ * @param bin Binning factor of the readout
+ * @return zero for success or non-zero on any faillure
+ */
+static int ov5645_write_window(struct sensor_info *info, const int32_t *crop,
+                               unsigned int bin)
+{
+    unsigned int x_end = crop[0] + crop[2] + 2 * OV5645_ISP_MARGIN_X - 1;
+    unsigned int y_end = crop[1] + crop[3] + 2 * OV5645_ISP_MARGIN_Y - 1;
+    const struct reg_val_tbl regs[] = {
+        {REG_TIMING_X_START_HIGH, crop[0] >> 8},
+        {REG_TIMING_X_START_LOW, crop[0] & 0xff},
+        {REG_TIMING_Y_START_HIGH, crop[1] >> 8},
+        {REG_TIMING_Y_START_LOW, crop[1] & 0xff},
+        {REG_TIMING_X_END_HIGH, x_end >> 8},
+        {REG_TIMING_X_END_LOW, x_end & 0xff},
+        {REG_TIMING_Y_END_HIGH, y_end >> 8},
+        {REG_TIMING_Y_END_LOW, y_end & 0xff},
+        {REG_TIMING_X_OFFSET_HIGH, 0x00},
+        {REG_TIMING_X_OFFSET_LOW, OV5645_ISP_MARGIN_X / bin},
+        {REG_TIMING_Y_OFFSET_HIGH, 0x00},
+        {REG_TIMING_Y_OFFSET_LOW, OV5645_ISP_MARGIN_Y / bin},
+
+        {OV5645_REG_END, 0x00}, /* END MARKER */
+    };
+
+    return ov5645_write_array(info, regs);
+}
+
+/**
+ * @brief Program the sensor window for a crop region
+ *
+ * The sensor reads only the cropped window, binned when it holds at least two
+ * pixels per output pixel in each direction, and the ISP scales the result to
+ * the output size. The clock tree is then recomputed for the new readout.
+ *
+ * @param info Sensor data instance
+ * @param region SCALER_CROP_REGION requested by the AP
+ * @return zero for success or non-zero on any faillure
+ */
+static int ov5645_set_crop(struct sensor_info *info, const int32_t *region)
+{
+    const struct ov5645_mode_info *mode = info->mode;
+    const struct ov5645_readout *readout;
+    int32_t crop[4];
+    bool scale;
+    int ret;
+
+    ov5645_fit_crop(mode, region, crop);
+
+    if (crop[2] >= 2 * mode->width && crop[3] >= 2 * mode->height) {
+        readout = &ov5645_readout_binned;
+    } else {
+        readout = &ov5645_readout_full;
+    }
+
+    scale = crop[2] / readout->bin != mode->width ||
+            crop[3] / readout->bin != mode->height;
+
+    ret = ov5645_write_array(info, readout->regs);
+    if (ret) {
+        return -EIO;
+    }
+
+    ret = ov5645_write_window(info, crop, readout->bin);
+    if (ret) {
+        return -EIO;
+    }
+
+    ret = ov5645_update_bits(info, REG_TIMING_TC_REG20,
+                             TIMING_TC_BINNING,
+                             readout->bin > 1 ? TIMING_TC_BINNING : 0);
+    if (ret) {
+        return ret;
+    }
+
+    ret = ov5645_update_bits(info, REG_TIMING_TC_REG21,
+                             TIMING_TC_BINNING,
+                             readout->bin > 1 ? TIMING_TC_BINNING : 0);
+    if (ret) {
+        return ret;
+    }
+
+    ret = ov5645_update_bits(info, REG_ISP_CONTROL01,
+                             ISP_CONTROL01_SCALE_ENABLE,
+                             scale ? ISP_CONTROL01_SCALE_ENABLE : 0);
+    if (ret) {
+        return ret;
+    }
+
+    info->clock = readout->clock;
+    info->vts_min = (crop[3] + 2 * OV5645_ISP_MARGIN_Y) / readout->bin +
+                    readout->vblank;
+
+    return ov5645_set_frame_rate(info, info->min_fps, info->target_fps);
+}
+
+/**
+ * @brief Move the sensor from the reset address to its own address
+ *
+ * Must be called with ov5645_sccb_lock held. A sensor using the reset address
+ * is left as is.
+ *
+ * @param info Sensor data instance
+ * @return zero for success or non-zero on any faillure
+ */
+static int ov5645_set_sccb_id(struct sensor_info *info)
+{
+    uint8_t cmd[3];
+    int ret;
+    struct i2c_msg_s msg[] = {
+        {
+            .addr = OV5645_I2C_ADDR,
+            .flags = 0,
+            .buffer = cmd,
+            .length = 3,
+        },
+    };
+
+    if (info->i2c_addr == OV5645_I2C_ADDR) {
+        return 0;
+    }
+
+    cmd[0] = (REG_SCCB_ID >> 8) & 0xff;
+    cmd[1] = REG_SCCB_ID & 0xff;
+    cmd[2] = info->i2c_addr << 1;
+
+    ret = i2c_trace_transfer(info->cam_i2c, msg, 1);
+    if (ret != OK) {
+        printf("ov5645: failed to move to address 0x%02x\n", info->i2c_addr);
+        return -EIO;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Power up the sensor
+ *
+ * A sensor still in standby is taken back as is.
+ *
+ * @param info Sensor data instance
+ */
+static void ov5645_power_on(struct sensor_info *info)
+{
+    sem_wait(&info->power_lock);
+
+    timer_wheel_cancel(&info->power_timer);
+    if (info->power == OV5645_POWER_ON ||
+        info->power == OV5645_POWER_STANDBY) {
+        info->power = OV5645_POWER_ON;
+        sem_post(&info->power_lock);
+        return;
+    }
+
+    gpio_direction_out(info->gpio_pwdn, 0); /* shutdown -> L */
+    gpio_direction_out(info->gpio_reset, 0); /* reset -> L */
+    usleep(5000);
+
+    gpio_direction_out(info->gpio_pwdn, 1); /* shutdown -> H */
+    usleep(1000);
+
+    /*
+     * Every sensor answers OV5645_I2C_ADDR out of reset. Sensors sharing a bus
+     * leave reset one at a time and move to their own address right away.
+     */
+    sem_wait(&ov5645_sccb_lock);
+
+    gpio_direction_out(info->gpio_reset, 1); /* reset -> H */
+    usleep(1000);
+
+    ov5645_model_power(true);
+
+    ov5645_set_sccb_id(info);
+    sem_post(&ov5645_sccb_lock);
+
+    info->power = OV5645_POWER_ON;
+    sem_post(&info->power_lock);
+}
+
+/**
+ * @brief Power down the sensor
+ * @param info Sensor data instance
+ */
+static void ov5645_power_off(struct sensor_info *info)
+{
+    sem_wait(&info->power_lock);
+
+    timer_wheel_cancel(&info->power_timer);
+    if (info->power == OV5645_POWER_OFF) {
+        sem_post(&info->power_lock);
+        return;
+    }
+
+    ov5645_model_power(false);
+
+    gpio_direction_out(info->gpio_pwdn, 0); /* shutdown -> L */
+    usleep(1000);
+
+    gpio_direction_out(info->gpio_reset, 0); /* reset -> L */
+    usleep(1000);
+
+    info->power = OV5645_POWER_OFF;
+    sem_post(&info->power_lock);
+}
+
+/**
+ * @brief Release the sensor
+ *
+ * The sensor is powered down if it is not powered up again within
+ * OV5645_STANDBY_MS.
+ *
+ * @param info Sensor data instance
+ */
+static void ov5645_standby(struct sensor_info *info)
+{
+    sem_wait(&info->power_lock);
+
+    if (info->power == OV5645_POWER_ON) {
+        info->power = OV5645_POWER_STANDBY;
+        timer_wheel_arm(&info->power_timer, OV5645_STANDBY_MS);
+    }
+
+    sem_post(&info->power_lock);
+}
+
+/**
+ * @brief Standby timer expiry, powers the sensor down
+ *
+ * Runs on the timer wheel, so the delay between shutdown and reset is a
+ * second expiry rather than a sleep. The callback must not block, so if the
+ * lock is taken it tries again on the next tick: the state is checked once
+ * the lock is held, and a holder that powered the sensor back on makes the
+ * retry a no-op.
+ *
+ * @param data Sensor data instance
+ */
+static void ov5645_power_timeout(void *data)
+{
+    struct sensor_info *info = data;
+
+    if (sem_trywait(&info->power_lock) != OK) {
+        timer_wheel_arm(&info->power_timer, 1);
+        return;
+    }
+
+    switch (info->power) {
+    case OV5645_POWER_STANDBY:
+        ov5645_model_power(false);
+        gpio_direction_out(info->gpio_pwdn, 0); /* shutdown -> L */
+        info->power = OV5645_POWER_DOWN;
+        timer_wheel_arm(&info->power_timer, 1);
+        break;
+
+    case OV5645_POWER_DOWN:
+        gpio_direction_out(info->gpio_reset, 0); /* reset -> L */
+        info->power = OV5645_POWER_OFF;
+        break;
+
+    default:
+        break;
+    }
+
+    sem_post(&info->power_lock);
+}
+
+/**
+ * @brief ov5645 sensor configuration function
+ * @param info Sensor data instance
+ * @param mode Mode to be configured
+ * @return zero for success or non-zero on any faillure
+ */
+static int ov5645_configure(struct sensor_info *info,
+                            const struct ov5645_mode_info *mode)
+{
+    int ret;
+
+    /*
+     * Perform a software reset. The datasheet does not say whether it spares
+     * REG_SCCB_ID, so assume the sensor is back at the reset address and move
+     * it again before another sensor can answer there.
+     */
+    ov5645_write(info, 0x3103, 0x11); /* Select PLL input clock */
+    sem_wait(&ov5645_sccb_lock);
+    ov5645_write(info, 0x3008, 0x82); /* Software reset */
+    usleep(5000);
+    ret = ov5645_set_sccb_id(info);
+    sem_post(&ov5645_sccb_lock);
+    if (ret) {
+        return ret;
+    }
+
+    /* Apply the initial configuration. */
+    ret = ov5645_write_array(info, ov5645_init_setting);
+    if (ret < 0) {
+        return -EIO;
+    }
+
+    /* Set the mode. */
+    ret = ov5645_write_array(info, mode->regs);
+    if (ret) {
+        printf("ov5645: failed to set mode\n", __func__);
+        return -EIO;
+    }
+
+    if (mode->format == CAMERA_FORMAT_JPEG) {
+        ret = ov5645_write_array(info, ov5645_setting_jpeg);
+        if (ret) {
+            return -EIO;
+        }
+
+        ret = ov5645_update_bits(info, REG_TIMING_TC_REG21,
+                                 TIMING_TC_JPEG_ENABLE, TIMING_TC_JPEG_ENABLE);
+        if (ret) {
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Apply the per-capture settings sent by the AP
+ * @param info Sensor data instance
+ * @param capt_info Capture parameters
+ * @return zero for success or non-zero on any faillure
+ */
+static int ov5645_apply_settings(struct sensor_info *info,
+                                 struct capture_info *capt_info)
+{
+    int32_t test_pattern;
+    int32_t fps_range[2];
+    int32_t crop_region[4];
+    uint8_t quality;
+    int ret;
+
+    ret = find_metadata(capt_info->settings, capt_info->settings_size,
+                        SENSOR_TEST_PATTERN_MODE, (uint8_t *)&test_pattern,
+                        sizeof(test_pattern));
+    if (ret == sizeof(test_pattern)) {
+        ret = ov5645_set_test_pattern(info, test_pattern);
+        if (ret) {
+            return ret;
+        }
+    }
+
+    ret = find_metadata(capt_info->settings, capt_info->settings_size,
+                        SCALER_CROP_REGION, (uint8_t *)crop_region,
+                        sizeof(crop_region));
+    if (ret == sizeof(crop_region) && info->mode &&
+        memcmp(crop_region, info->crop, sizeof(crop_region))) {
+        if (crop_region[2] <= 0 || crop_region[3] <= 0) {
+            return -EINVAL;
+        }
+
+        ret = ov5645_set_crop(info, crop_region);
+        if (ret) {
+            return ret;
+        }
+
+        memcpy(info->crop, crop_region, sizeof(info->crop));
+    }
+
+    /*
+     * Run at the upper bound of the requested range, or as close to it as
+     * the readout goes, the sensor AEC lowers the frame rate by itself when
+     * it needs longer exposures. A range the readout cannot reach at all is
+     * rejected rather than clamped, the AP gets the error.
+     */
+    ret = find_metadata(capt_info->settings, capt_info->settings_size,
+                        CONTROL_AE_TARGET_FPS_RANGE, (uint8_t *)fps_range,
+                        sizeof(fps_range));
+    if (ret == sizeof(fps_range) && info->mode &&
+        (fps_range[0] != info->min_fps ||
+         fps_range[1] != info->target_fps)) {
+        if (fps_range[0] <= 0 || fps_range[0] > fps_range[1]) {
+            return -EINVAL;
+        }
+
+        ret = ov5645_set_frame_rate(info, fps_range[0], fps_range[1]);
+        if (ret) {
+            return ret == -EINVAL ? ret : -EIO;
+        }
+
+        info->min_fps = fps_range[0];
+        info->target_fps = fps_range[1];
+    }
+
+    if (info->mode) {
+        ov5645_af_apply_settings(info, capt_info);
+    }
+
+    if (info->mode && info->mode->format == CAMERA_FORMAT_JPEG) {
+        ret = find_metadata(capt_info->settings, capt_info->settings_size,
+                            JPEG_QUALITY, &quality, sizeof(quality));
+        if (ret == sizeof(quality)) {
+            ret = ov5645_set_jpeg_quality(info, quality);
+            if (ret) {
+                return ret;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Get capabilities of camera module
+ * @param dev Pointer to structure of device data
+ * @param capabilities Pointer that will be stored Camera Module capabilities.
+ * @return 0 on success, negative errno on error
+ */
+static int camera_op_capabilities(struct device *dev, uint32_t *size,
+                                  uint8_t *capabilities)
+{
+    int ret;
+    ret = get_capabilities(size, capabilities);
+    if (ret) {
+        printf("ov5645: failed to get capabilities\n", __func__);
+        return -EIO;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Get required data size of camera module information
+ * @param dev Pointer to structure of device data
+ * @param capabilities Pointer that will be stored Camera Module capabilities.
+ * @return 0 on success, negative errno on error
+ */
+static int camera_op_get_required_size(struct device *dev, uint8_t operation,
+                                       uint16_t *size)
+{
+    switch (operation) {
     case SIZE_CAPABILITIES:
         *size = SIZE_CAPABILITIES_VALUE;
         break;
@@ -1091,11 +2889,14 @@ static int camera_op_set_streams_cfg(struct device *dev, uint8_t *num_streams,
 
     /*
      * When unconfiguring the module we can uninit CSI-RX right away as the
-     * sensor is already stopped, and then power the sensor off.
+     * sensor is already stopped, and then put the sensor in standby.
      */
     if (*num_streams == 0) {
         csi_rx_uninit(info->cdsidev);
-        ov5645_power_off(info);
+        ov5645_burst_stop(info);
+        ov5645_af_stop(info);
+        ov5645_standby(info);
+        info->mode = NULL;
         return 0;
     }
 
@@ -1145,6 +2946,7 @@ static int camera_op_set_streams_cfg(struct device *dev, uint8_t *num_streams,
         return 0;
 
     /* Power the sensor up and configure it. */
+    ov5645_af_stop(info);
     ov5645_power_on(info);
 
     ret = ov5645_configure(info, cfg);
@@ -1153,6 +2955,17 @@ static int camera_op_set_streams_cfg(struct device *dev, uint8_t *num_streams,
         return ret;
     }
 
+    info->mode = cfg;
+    info->clock = cfg->clock;
+    info->vts_min = cfg->clock->vts;
+    info->min_fps = OV5645_MIN_FPS;
+    info->target_fps = cfg->clock->fps;
+    info->vts = cfg->clock->vts;
+    info->line_ns = 1000000000 / (cfg->clock->vts * cfg->clock->fps);
+    memset(info->crop, 0, sizeof(info->crop));
+
+    ov5645_af_start(info);
+
     /* Initialize the CSI receiver. */
     csi_rx_init(info->cdsidev, NULL);
 
@@ -1170,23 +2983,42 @@ static int camera_op_capture(struct device *dev, struct capture_info *capt_info)
     struct sensor_info *info = device_get_private(dev);
     int ret;
 
+    ret = ov5645_apply_settings(info, capt_info);
+    if (ret) {
+        return ret;
+    }
+
+    ret = ov5645_burst_prepare(info, capt_info);
+    if (ret) {
+        return ret;
+    }
+
     /*
      * Start the CSI receiver first as it requires the D-PHY lines to be in the
      * LP-11 state to synchronize to the transmitter.
      */
     ret = csi_rx_start(info->cdsidev);
     if (ret) {
-        return ret;
+        goto err_restore;
     }
 
     /* Now start the video stream. */
     ret = ov5645_set_stream(info, true);
     if (ret) {
-        return -EIO;
+        csi_rx_stop(info->cdsidev);
+        ret = -EIO;
+        goto err_restore;
     }
 
     info->req_id = capt_info->request_id;
 
+    ov5645_burst_start(info);
+
+    return 0;
+
+err_restore:
+    /* Give the exposure back to the AEC if the burst had taken it over. */
+    ov5645_burst_restore(info);
     return ret;
 }
 
@@ -1201,6 +3033,15 @@ static int camera_op_flush(struct device *dev, uint32_t *request_id)
     struct sensor_info *info = device_get_private(dev);
     int ret;
 
+    ov5645_burst_stop(info);
+
+    /* A completed burst has already stopped the sensor and the receiver. */
+    if (info->burst.done) {
+        info->burst.done = false;
+        *request_id = info->req_id;
+        return 0;
+    }
+
     /*
      * Stop the sensor first as the CSI receiver requires the D-PHY lines to be
      * in the LP-11 state to stop.
@@ -1229,14 +3070,14 @@ static int camera_sensor_detect(struct sensor_info *info)
     /* Power up the sensor and verify the ID register. */
     ov5645_power_on(info);
 
-    ret = ov5645_read(info->cam_i2c, OV5645_ID_HIGH);
+    ret = ov5645_read(info, OV5645_ID_HIGH);
     if (ret < 0) {
         goto done;
     }
 
     id = ret << 8;
 
-    ret = ov5645_read(info->cam_i2c, OV5645_ID_LOW);
+    ret = ov5645_read(info, OV5645_ID_LOW);
     if (ret < 0) {
         goto done;
     }
@@ -1249,7 +3090,11 @@ static int camera_sensor_detect(struct sensor_info *info)
     }
 
 done:
-    ov5645_power_off(info);
+    if (ret < 0) {
+        ov5645_power_off(info);
+    } else {
+        ov5645_standby(info);
+    }
     return ret;
 }
 
@@ -1267,15 +3112,15 @@ static int camera_dev_open(struct device *dev)
         return -EBUSY;
     }
 
-    ret = gpio_activate(OV5645_GPIO_PWDN);
+    ret = gpio_activate(info->gpio_pwdn);
     if (ret)
         goto error_gpio1;
-    ret = gpio_activate(OV5645_GPIO_RESET);
+    ret = gpio_activate(info->gpio_reset);
     if (ret)
         goto error_gpio2;
 
     /* Initialize I2C access. */
-    info->cam_i2c = up_i2cinitialize(OV5645_I2C_PORT);
+    info->cam_i2c = up_i2cinitialize(info->board->i2c_port);
     if (!info->cam_i2c) {
         ret = -EIO;
         goto error_i2c;
@@ -1288,23 +3133,28 @@ static int camera_dev_open(struct device *dev)
     }
 
     /* Open the CSI receiver. */
-    info->cdsidev = csi_rx_open(0);
+    info->cdsidev = csi_rx_open(info->board->csi_id);
     if (info->cdsidev == NULL) {
         ret = -EINVAL;
         goto error_csi;
     }
 
+    if (!ov5645_af_firmware || !&ov5645_af_firmware_size) {
+        printf("ov5645: no AF firmware linked, autofocus disabled\n");
+    }
+
     info->state = OV5645_STATE_OPEN;
 
     return 0;
 
 error_csi:
+    ov5645_power_off(info);
 error_sensor:
     up_i2cuninitialize(info->cam_i2c);
 error_i2c:
-    gpio_deactivate(OV5645_GPIO_RESET);
+    gpio_deactivate(info->gpio_reset);
 error_gpio2:
-    gpio_deactivate(OV5645_GPIO_PWDN);
+    gpio_deactivate(info->gpio_pwdn);
 error_gpio1:
     printf("Camera initialization failed\n");
     return ret;
@@ -1319,7 +3169,9 @@ static void camera_dev_close(struct device *dev)
     struct sensor_info *info = device_get_private(dev);
 
     /* Stop the stream, power the sensor down, and stop the CSI receiver. */
+    ov5645_burst_stop(info);
     ov5645_set_stream(info, false);
+    ov5645_af_stop(info);
     ov5645_power_off(info);
     usleep(10);
     csi_rx_stop(info->cdsidev);
@@ -1328,8 +3180,8 @@ static void camera_dev_close(struct device *dev)
     csi_rx_close(info->cdsidev);
     up_i2cuninitialize(info->cam_i2c);
 
-    gpio_deactivate(OV5645_GPIO_PWDN);
-    gpio_deactivate(OV5645_GPIO_RESET);
+    gpio_deactivate(info->gpio_pwdn);
+    gpio_deactivate(info->gpio_reset);
 
     info->state = OV5645_STATE_CLOSED;
 }
@@ -1341,8 +3193,25 @@ static void camera_dev_close(struct device *dev)
  */
 static int camera_dev_probe(struct device *dev)
 {
+    struct device_resource *i2c_addr;
+    struct device_resource *gpio_reset;
+    struct device_resource *gpio_pwdn;
     struct sensor_info *info;
 
+    if (!dev->init_data) {
+        return -EINVAL;
+    }
+
+    i2c_addr = device_resource_get_by_name(dev, DEVICE_RESOURCE_TYPE_I2C_ADDR,
+                                           "ov5645_i2c_addr");
+    gpio_reset = device_resource_get_by_name(dev, DEVICE_RESOURCE_TYPE_GPIO,
+                                             "ov5645_gpio_reset");
+    gpio_pwdn = device_resource_get_by_name(dev, DEVICE_RESOURCE_TYPE_GPIO,
+                                            "ov5645_gpio_pwdn");
+    if (!i2c_addr || !gpio_reset || !gpio_pwdn) {
+        return -EINVAL;
+    }
+
     info = zalloc(sizeof(*info));
     if (!info) {
         return -ENOMEM;
@@ -1350,8 +3219,29 @@ static int camera_dev_probe(struct device *dev)
 
     info->state = OV5645_STATE_CLOSED;
     info->dev = dev;
+    info->board = dev->init_data;
+    info->i2c_addr = i2c_addr->start;
+    info->gpio_reset = gpio_reset->start;
+    info->gpio_pwdn = gpio_pwdn->start;
+    snprintf(info->af_devpath, sizeof(info->af_devpath), OV5645_AF_DEVPATH,
+             dev->id);
+    sem_init(&info->af.lock, 0, 1);
+    sem_init(&info->burst.lock, 0, 1);
+    sem_init(&info->power_lock, 0, 1);
+    timer_wheel_setup(&info->power_timer, ov5645_power_timeout, info);
     device_set_private(dev, info);
 
+    /*
+     * Hold the sensor in reset until it is opened, so that a sensor not yet
+     * opened cannot answer the reset address while another one powers up.
+     */
+    if (!gpio_activate(info->gpio_reset)) {
+        gpio_direction_out(info->gpio_reset, 0); /* reset -> L */
+        gpio_deactivate(info->gpio_reset);
+    }
+
+    register_driver(info->af_devpath, &ov5645_af_fops, 0444, info);
+
     return 0;
 }
 
@@ -1363,6 +3253,10 @@ static void camera_dev_remove(struct device *dev)
 {
     struct sensor_info *info = device_get_private(dev);
 
+    unregister_driver(info->af_devpath);
+    sem_destroy(&info->af.lock);
+    sem_destroy(&info->burst.lock);
+    sem_destroy(&info->power_lock);
     device_set_private(dev, NULL);
     free(info);
 }
@@ -1390,13 +3284,94 @@ static struct device_driver camera_driver = {
     .ops                = &camera_driver_ops,
 };
 
+/*
+ * Add CONFIG_ARA_OV5645_DUAL=y to the module config for boards carrying a
+ * second sensor on the same I2C bus, wired to the second CSI receiver. Both
+ * sensors are then moved away from the reset address at power up. A sensor
+ * may only stay at the reset address when it is alone on its bus.
+ */
+#ifdef CONFIG_ARA_OV5645_DUAL
+#define OV5645_0_I2C_ADDR               0x3b
+#define OV5645_1_I2C_ADDR               0x3a
+#else
+#define OV5645_0_I2C_ADDR               OV5645_I2C_ADDR
+#endif
+
+static struct device_resource camera_0_resources[] = {
+    {
+        .name  = "ov5645_i2c_addr",
+        .type  = DEVICE_RESOURCE_TYPE_I2C_ADDR,
+        .start = OV5645_0_I2C_ADDR,
+        .count = 1,
+    },
+    {
+        .name  = "ov5645_gpio_reset",
+        .type  = DEVICE_RESOURCE_TYPE_GPIO,
+        .start = OV5645_GPIO_RESET,
+        .count = 1,
+    },
+    {
+        .name  = "ov5645_gpio_pwdn",
+        .type  = DEVICE_RESOURCE_TYPE_GPIO,
+        .start = OV5645_GPIO_PWDN,
+        .count = 1,
+    },
+};
+
+static const struct ov5645_board_data camera_0_board_data = {
+    .i2c_port = 0,
+    .csi_id = 0,
+};
+
+#ifdef CONFIG_ARA_OV5645_DUAL
+static struct device_resource camera_1_resources[] = {
+    {
+        .name  = "ov5645_i2c_addr",
+        .type  = DEVICE_RESOURCE_TYPE_I2C_ADDR,
+        .start = OV5645_1_I2C_ADDR,
+        .count = 1,
+    },
+    {
+        .name  = "ov5645_gpio_reset",
+        .type  = DEVICE_RESOURCE_TYPE_GPIO,
+        .start = OV5645_1_GPIO_RESET,
+        .count = 1,
+    },
+    {
+        .name  = "ov5645_gpio_pwdn",
+        .type  = DEVICE_RESOURCE_TYPE_GPIO,
+        .start = OV5645_1_GPIO_PWDN,
+        .count = 1,
+    },
+};
+
+static const struct ov5645_board_data camera_1_board_data = {
+    .i2c_port = 0,
+    .csi_id = 1,
+};
+#endif
+
 static struct device camera_devices[] = {
     {
         .type           = DEVICE_TYPE_CAMERA_HW,
         .name           = "camera",
         .desc           = "Ara White Camera Module",
         .id             = 0,
+        .resources      = camera_0_resources,
+        .resource_count = ARRAY_SIZE(camera_0_resources),
+        .init_data      = (void *)&camera_0_board_data,
     },
+#ifdef CONFIG_ARA_OV5645_DUAL
+    {
+        .type           = DEVICE_TYPE_CAMERA_HW,
+        .name           = "camera",
+        .desc           = "Ara White Camera Module, second sensor",
+        .id             = 1,
+        .resources      = camera_1_resources,
+        .resource_count = ARRAY_SIZE(camera_1_resources),
+        .init_data      = (void *)&camera_1_board_data,
+    },
+#endif
 };
 
 static struct device_table camera_device_table = {
@@ -1410,6 +3385,13 @@ void ara_module_early_init(void)
 
 void ara_module_init(void)
 {
+    i2c_trace_init();
+    timer_wheel_init();
+
     device_table_register(&camera_device_table);
     device_register_driver(&camera_driver);
+
+#ifdef CONFIG_ARA_OV5645_MODEL
+    ov5645_model_bench();
+#endif
 }
@@ -2,6 +2,9 @@ config		= config
 manifest	= manifest.mnfs
 board-files	= board.c
 board-files	+= camera_capability.c
+board-files	+= ov5645_model.c
+board-files	+= common/i2c_trace.c
+board-files	+= common/timer_wheel.c
 
 vendor_id	= 0x00000001
 product_id	= 0x00000001
@@ -0,0 +1,552 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <nuttx/config.h>
+
+#ifdef CONFIG_ARA_OV5645_MODEL
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <syslog.h>
+
+#include <nuttx/device.h>
+#include <nuttx/device_camera.h>
+#include <nuttx/i2c.h>
+#include <nuttx/util.h>
+
+#include "common/bench.h"
+
+#include "camera_capability.h"
+#include "ov5645_model.h"
+
+/* Slave address and ID answered by the model */
+#define OV5645_MODEL_I2C_ADDR           0x3c
+#define OV5645_MODEL_ID_HIGH            0x56
+#define OV5645_MODEL_ID_LOW             0x45
+
+/* Registers with a side effect */
+#define OV5645_MODEL_REG_ID_HIGH        0x300a
+#define OV5645_MODEL_REG_ID_LOW         0x300b
+#define OV5645_MODEL_REG_SYS_CTRL0      0x3008
+#define OV5645_MODEL_REG_GROUP_ACCESS   0x3212
+#define OV5645_MODEL_REG_SCCB_ID        0x3100
+
+#define OV5645_MODEL_SOFT_RESET         0x80
+
+/* Group hold control, upper nibble of 0x3212 */
+#define OV5645_MODEL_GROUP_START        0x00
+#define OV5645_MODEL_GROUP_END          0x10
+#define OV5645_MODEL_GROUP_LAUNCH       0xa0
+#define OV5645_MODEL_GROUP_QUICK_LAUNCH 0xe0
+
+#define OV5645_MODEL_NUM_GROUPS         4
+#define OV5645_MODEL_GROUP_SIZE         32
+
+/* Datasheet power up sequence: PWDN to RESETB, then RESETB to first SCCB. */
+#define OV5645_MODEL_PWDN_TO_RESET_US   1000
+#define OV5645_MODEL_RESET_TO_SCCB_US   20000
+#define OV5645_MODEL_SOFT_RESET_US      5000
+
+/* Size of the register file, must be a power of two */
+#define OV5645_MODEL_NUM_REGS           512
+
+struct ov5645_model_reg {
+    uint16_t addr;
+    uint8_t value;
+    uint8_t valid;
+};
+
+struct ov5645_model_group {
+    unsigned int count;
+    struct ov5645_model_reg regs[OV5645_MODEL_GROUP_SIZE];
+};
+
+/**
+ * @brief Model state
+ */
+struct ov5645_model_info {
+    struct i2c_dev_s i2c;
+    bool powered;
+    /** Slave address, moved by writing OV5645_MODEL_REG_SCCB_ID */
+    uint16_t i2c_addr;
+    /** Group currently being recorded, -1 if none */
+    int group;
+    uint32_t byte_time_ns;
+    /** Sub-microsecond remainder of the bus time */
+    uint32_t bus_ns;
+    struct ov5645_model_stats stats;
+    struct ov5645_model_reg regs[OV5645_MODEL_NUM_REGS];
+    struct ov5645_model_group groups[OV5645_MODEL_NUM_GROUPS];
+};
+
+static struct ov5645_model_info ov5645_model = {
+    .group = -1,
+    .byte_time_ns = OV5645_MODEL_BYTE_TIME_NS,
+};
+
+/* Dummy handle returned by the CSI stand-in */
+static uint32_t ov5645_model_cdsi;
+
+static struct ov5645_model_reg *ov5645_model_lookup(uint16_t addr,
+                                                    bool create)
+{
+    unsigned int i = (addr * 31) & (OV5645_MODEL_NUM_REGS - 1);
+    unsigned int n;
+
+    for (n = 0; n < OV5645_MODEL_NUM_REGS; n++) {
+        struct ov5645_model_reg *reg = &ov5645_model.regs[i];
+
+        if (reg->valid && reg->addr == addr) {
+            return reg;
+        }
+
+        if (!reg->valid) {
+            if (!create) {
+                return NULL;
+            }
+
+            reg->valid = 1;
+            reg->addr = addr;
+            return reg;
+        }
+
+        i = (i + 1) & (OV5645_MODEL_NUM_REGS - 1);
+    }
+
+    lowsyslog("ov5645-model: register file full\n");
+    return NULL;
+}
+
+static void ov5645_model_store(uint16_t addr, uint8_t value)
+{
+    struct ov5645_model_reg *reg = ov5645_model_lookup(addr, true);
+
+    if (reg) {
+        reg->value = value;
+    }
+}
+
+static void ov5645_model_clear(void)
+{
+    memset(ov5645_model.regs, 0, sizeof(ov5645_model.regs));
+    memset(ov5645_model.groups, 0, sizeof(ov5645_model.groups));
+    ov5645_model.group = -1;
+
+    ov5645_model_store(OV5645_MODEL_REG_ID_HIGH, OV5645_MODEL_ID_HIGH);
+    ov5645_model_store(OV5645_MODEL_REG_ID_LOW, OV5645_MODEL_ID_LOW);
+}
+
+static void ov5645_model_charge_bytes(unsigned int count)
+{
+    ov5645_model.stats.bytes += count;
+    ov5645_model.bus_ns += count * ov5645_model.byte_time_ns;
+    ov5645_model.stats.bus_us += ov5645_model.bus_ns / 1000;
+    ov5645_model.bus_ns %= 1000;
+}
+
+static void ov5645_model_group_access(uint8_t value)
+{
+    unsigned int id = value & 0x0f;
+    struct ov5645_model_group *group;
+    unsigned int i;
+
+    if (id >= OV5645_MODEL_NUM_GROUPS) {
+        return;
+    }
+
+    group = &ov5645_model.groups[id];
+
+    switch (value & 0xf0) {
+    case OV5645_MODEL_GROUP_START:
+        group->count = 0;
+        ov5645_model.group = id;
+        break;
+    case OV5645_MODEL_GROUP_END:
+        ov5645_model.group = -1;
+        break;
+    case OV5645_MODEL_GROUP_LAUNCH:
+    case OV5645_MODEL_GROUP_QUICK_LAUNCH:
+        for (i = 0; i < group->count; i++) {
+            ov5645_model_store(group->regs[i].addr, group->regs[i].value);
+        }
+        group->count = 0;
+        break;
+    default:
+        break;
+    }
+}
+
+static void ov5645_model_write(uint16_t addr, uint8_t value)
+{
+    struct ov5645_model_group *group;
+
+    if (addr == OV5645_MODEL_REG_GROUP_ACCESS) {
+        ov5645_model_group_access(value);
+        return;
+    }
+
+    if (addr == OV5645_MODEL_REG_SCCB_ID) {
+        ov5645_model.i2c_addr = value >> 1;
+    }
+
+    /* Writes are held back while a group is being recorded. */
+    if (ov5645_model.group >= 0) {
+        group = &ov5645_model.groups[ov5645_model.group];
+        if (group->count < OV5645_MODEL_GROUP_SIZE) {
+            group->regs[group->count].addr = addr;
+            group->regs[group->count].value = value;
+            group->count++;
+        }
+        return;
+    }
+
+    if (addr == OV5645_MODEL_REG_SYS_CTRL0 &&
+        (value & OV5645_MODEL_SOFT_RESET)) {
+        ov5645_model_clear();
+        ov5645_model.stats.delay_us += OV5645_MODEL_SOFT_RESET_US;
+        value &= ~OV5645_MODEL_SOFT_RESET;
+    }
+
+    ov5645_model_store(addr, value);
+}
+
+uint8_t ov5645_model_peek(uint16_t addr)
+{
+    struct ov5645_model_reg *reg = ov5645_model_lookup(addr, false);
+
+    return reg ? reg->value : 0;
+}
+
+/*
+ * Each message starts with a register address and the address auto-increments
+ * for every data byte, in both directions, as on the real sensor.
+ */
+static int ov5645_model_transfer(struct i2c_dev_s *dev, struct i2c_msg_s *msgs,
+                                 int count)
+{
+    uint16_t addr = 0;
+    int i, j;
+
+    ov5645_model.stats.transactions++;
+
+    for (i = 0; i < count; i++) {
+        struct i2c_msg_s *msg = &msgs[i];
+
+        /* The slave address byte goes on the wire even when NACKed. */
+        if (!ov5645_model.powered || msg->addr != ov5645_model.i2c_addr) {
+            ov5645_model_charge_bytes(1);
+            return -EIO;
+        }
+
+        ov5645_model_charge_bytes(msg->length + 1);
+
+        if (msg->flags & I2C_M_READ) {
+            for (j = 0; j < msg->length; j++) {
+                msg->buffer[j] = ov5645_model_peek(addr++);
+            }
+            ov5645_model.stats.reads++;
+            continue;
+        }
+
+        if (msg->length < 2) {
+            return -EIO;
+        }
+
+        addr = (msg->buffer[0] << 8) | msg->buffer[1];
+        for (j = 2; j < msg->length; j++) {
+            ov5645_model_write(addr++, msg->buffer[j]);
+        }
+
+        if (msg->length > 2) {
+            ov5645_model.stats.writes++;
+        }
+    }
+
+    return OK;
+}
+
+static const struct i2c_ops_s ov5645_model_i2c_ops = {
+    .transfer = ov5645_model_transfer,
+};
+
+struct i2c_dev_s *ov5645_model_i2cinitialize(int port)
+{
+    ov5645_model.i2c.ops = &ov5645_model_i2c_ops;
+    return &ov5645_model.i2c;
+}
+
+int ov5645_model_i2cuninitialize(struct i2c_dev_s *dev)
+{
+    return 0;
+}
+
+void ov5645_model_power(bool on)
+{
+    if (on && !ov5645_model.powered) {
+        ov5645_model_clear();
+        ov5645_model.i2c_addr = OV5645_MODEL_I2C_ADDR;
+        ov5645_model.stats.delay_us += OV5645_MODEL_PWDN_TO_RESET_US +
+                                       OV5645_MODEL_RESET_TO_SCCB_US;
+    }
+
+    ov5645_model.powered = on;
+}
+
+void ov5645_model_set_byte_time(uint32_t ns)
+{
+    ov5645_model.byte_time_ns = ns;
+}
+
+void ov5645_model_get_stats(struct ov5645_model_stats *stats)
+{
+    *stats = ov5645_model.stats;
+}
+
+void ov5645_model_reset_stats(void)
+{
+    memset(&ov5645_model.stats, 0, sizeof(ov5645_model.stats));
+    ov5645_model.bus_ns = 0;
+}
+
+struct cdsi_dev *ov5645_model_csi_rx_open(int id)
+{
+    return (struct cdsi_dev *)&ov5645_model_cdsi;
+}
+
+void ov5645_model_csi_rx_close(struct cdsi_dev *dev)
+{
+}
+
+int ov5645_model_csi_rx_init(struct cdsi_dev *dev, const void *cfg)
+{
+    return 0;
+}
+
+int ov5645_model_csi_rx_uninit(struct cdsi_dev *dev)
+{
+    return 0;
+}
+
+int ov5645_model_csi_rx_start(struct cdsi_dev *dev)
+{
+    return 0;
+}
+
+int ov5645_model_csi_rx_stop(struct cdsi_dev *dev)
+{
+    return 0;
+}
+
+/**
+ * @brief Budget for one open/configure/capture/flush/close cycle
+ */
+struct ov5645_model_budget {
+    uint16_t width;
+    uint16_t height;
+    uint16_t format;
+    uint32_t max_transactions;
+    uint32_t max_bus_us;
+};
+
+static const struct ov5645_model_budget ov5645_model_budgets[] = {
+    { 1280,  960, CAMERA_UYVY422_PACKED, 327, 29407 },
+    { 1920, 1080, CAMERA_UYVY422_PACKED, 337, 30307 },
+    { 2592, 1944, CAMERA_UYVY422_PACKED, 344, 30937 },
+    { 1280,  720, CAMERA_UYVY422_PACKED, 327, 29407 },
+    { 1024,  768, CAMERA_UYVY422_PACKED, 334, 30037 },
+    {  640,  480, CAMERA_UYVY422_PACKED, 334, 30037 },
+    { 2592, 1944, CAMERA_FORMAT_JPEG,    354, 31860 },
+    { 1920, 1080, CAMERA_FORMAT_JPEG,    347, 31230 },
+    { 1280,  960, CAMERA_FORMAT_JPEG,    337, 30330 },
+};
+
+static int ov5645_model_bench_mode(const struct ov5645_model_budget *budget,
+                                   uint32_t request_id)
+{
+    struct streams_cfg_req req;
+    struct streams_cfg_ans ans;
+    struct capture_info capt;
+    struct device *dev;
+    uint8_t num_streams;
+    uint8_t res_flags = 0;
+    uint32_t flushed_id;
+    int ret;
+
+    dev = device_open(DEVICE_TYPE_CAMERA_HW, 0);
+    if (!dev) {
+        return -ENODEV;
+    }
+
+    memset(&req, 0, sizeof(req));
+    req.width = budget->width;
+    req.height = budget->height;
+    req.format = budget->format;
+
+    num_streams = 1;
+    ret = device_camera_set_streams_cfg(dev, &num_streams, 0, &req,
+                                        &res_flags, &ans);
+    if (ret || (res_flags & CAMERA_CONF_STREAMS_ADJUSTED)) {
+        ret = ret ? ret : -EINVAL;
+        goto done;
+    }
+
+    memset(&capt, 0, sizeof(capt));
+    capt.request_id = request_id;
+    ret = device_camera_capture(dev, &capt);
+    if (ret) {
+        goto done;
+    }
+
+    ret = device_camera_flush(dev, &flushed_id);
+    if (!ret && flushed_id != request_id) {
+        ret = -EINVAL;
+    }
+
+    num_streams = 0;
+    device_camera_set_streams_cfg(dev, &num_streams, 0, NULL, &res_flags,
+                                  NULL);
+
+done:
+    device_close(dev);
+    return ret;
+}
+
+/* The entry read back with find_metadata() must be the one packed */
+static bool ov5645_model_check_entry(const uint8_t *buffer, uint32_t size,
+                                     Camera_Metadata_type_t keyid,
+                                     const void *expected, int len)
+{
+    uint8_t value[8];
+
+    return find_metadata(buffer, size, keyid, value, sizeof(value)) == len &&
+           !memcmp(value, expected, len);
+}
+
+/**
+ * @brief Round trip the module metadata through find_metadata()
+ *
+ * The settings of the AP are parsed with the layout the module builds its
+ * capabilities and capture results with, check both ends agree.
+ *
+ * @return 0 if every entry reads back, -EINVAL otherwise
+ */
+static int ov5645_model_bench_metadata(void)
+{
+    static uint8_t buffer[SIZE_CAPABILITIES_VALUE];
+    const struct capture_results results = {
+        .frame_count = 1234,
+        .exposure_time = 33000000,
+        .frame_duration = 33333333,
+        .sensitivity = 400,
+        .ae_state = CONTROL_AE_STATE_CONVERGED,
+        .af_state = CONTROL_AF_STATE_FOCUSED_LOCKED,
+        .awb_state = CONTROL_AWB_STATE_CONVERGED,
+    };
+    const int32_t sensitivity_range[] = { 100, 1600 };
+    const float max_zoom = 4.0f;
+    uint32_t size;
+    bool caps_ok, results_ok;
+
+    caps_ok = !get_capabilities(&size, buffer) &&
+              size <= SIZE_CAPABILITIES_VALUE &&
+              ov5645_model_check_entry(buffer, size,
+                                       SCALER_AVAILABLE_MAX_DIGITAL_ZOOM,
+                                       &max_zoom, sizeof(max_zoom)) &&
+              ov5645_model_check_entry(buffer, size,
+                                       SENSOR_INFO_SENSITIVITY_RANGE,
+                                       sensitivity_range,
+                                       sizeof(sensitivity_range));
+
+    results_ok = !get_capture_results_metadata(&size, buffer, &results) &&
+                 size <= SIZE_CAPTURE_RESULTS_METADATA_VALUE &&
+                 ov5645_model_check_entry(buffer, size, REQUEST_FRAME_COUNT,
+                                          &results.frame_count,
+                                          sizeof(results.frame_count)) &&
+                 ov5645_model_check_entry(buffer, size, SENSOR_EXPOSURE_TIME,
+                                          &results.exposure_time,
+                                          sizeof(results.exposure_time)) &&
+                 ov5645_model_check_entry(buffer, size, SENSOR_SENSITIVITY,
+                                          &results.sensitivity,
+                                          sizeof(results.sensitivity)) &&
+                 ov5645_model_check_entry(buffer, size, CONTROL_AF_STATE,
+                                          &results.af_state,
+                                          sizeof(results.af_state));
+
+    lowsyslog("ov5645-bench: metadata round trip: capabilities %s, "
+              "capture results %s\n", bench_match(caps_ok),
+              bench_match(results_ok));
+
+    return caps_ok && results_ok ? 0 : -EINVAL;
+}
+
+int ov5645_model_bench(void)
+{
+    const struct ov5645_model_budget *budget;
+    struct ov5645_model_stats stats;
+    unsigned int failures = 0;
+    unsigned int i;
+    bool regression;
+    int ret;
+
+    for (i = 0; i < ARRAY_SIZE(ov5645_model_budgets); i++) {
+        budget = &ov5645_model_budgets[i];
+
+        ov5645_model_reset_stats();
+        ret = ov5645_model_bench_mode(budget, i + 1);
+        ov5645_model_get_stats(&stats);
+
+        regression = stats.transactions > budget->max_transactions ||
+                     stats.bus_us > budget->max_bus_us;
+        if (ret || regression) {
+            failures++;
+        }
+
+        lowsyslog("ov5645-bench: %ux%u: %u transactions (%u max), "
+                  "%u bytes, bus %u us (%u max), delays %u us, "
+                  "latency %u us: %s\n",
+                  budget->width, budget->height, stats.transactions,
+                  budget->max_transactions, stats.bytes, stats.bus_us,
+                  budget->max_bus_us, stats.delay_us,
+                  stats.bus_us + stats.delay_us,
+                  bench_verdict(ret, regression));
+    }
+
+    if (ov5645_model_bench_metadata()) {
+        failures++;
+    }
+
+    /* The modes, and the metadata round trip */
+    bench_summary("ov5645-bench", "checks",
+                  ARRAY_SIZE(ov5645_model_budgets) + 1, failures);
+
+    return failures ? -EINVAL : 0;
+}
+
+#endif /* CONFIG_ARA_OV5645_MODEL */
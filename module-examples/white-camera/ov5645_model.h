@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2016 Google, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FDK_OV5645_MODEL_H
+#define FDK_OV5645_MODEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <nuttx/config.h>
+#include <nuttx/i2c.h>
+
+/*
+ * Behavioral model of the OV5645, used to measure the driver without a
+ * sensor. Add CONFIG_ARA_OV5645_MODEL=y to the module config to replace the
+ * sensor I2C bus and the CSI receiver with the model and run the benchmark
+ * at boot.
+ */
+
+/* Default bus cost per byte: 9 bits at 400 kHz */
+#define OV5645_MODEL_BYTE_TIME_NS       22500
+
+/**
+ * @brief Bus and timing statistics accumulated by the model
+ */
+struct ov5645_model_stats {
+    /** Number of I2C transactions, including NACKed ones */
+    uint32_t transactions;
+    /** Number of messages writing register data */
+    uint32_t writes;
+    /** Number of read messages */
+    uint32_t reads;
+    /** Bytes on the wire, including slave address bytes */
+    uint32_t bytes;
+    /** Simulated bus time in microseconds */
+    uint32_t bus_us;
+    /** Simulated datasheet delays (reset, power up) in microseconds */
+    uint32_t delay_us;
+};
+
+#ifdef CONFIG_ARA_OV5645_MODEL
+
+struct cdsi_dev;
+
+struct i2c_dev_s *ov5645_model_i2cinitialize(int port);
+int ov5645_model_i2cuninitialize(struct i2c_dev_s *dev);
+
+/**
+ * @brief Notify the model that the sensor supplies have been switched
+ * @param on true when the sensor leaves power down and reset
+ */
+void ov5645_model_power(bool on);
+
+/**
+ * @brief Set the simulated bus cost of one byte
+ * @param ns Time in nanoseconds
+ */
+void ov5645_model_set_byte_time(uint32_t ns);
+
+void ov5645_model_get_stats(struct ov5645_model_stats *stats);
+void ov5645_model_reset_stats(void);
+
+/**
+ * @brief Read a register from the model register file
+ * @param reg Register address
+ * @return register value
+ */
+uint8_t ov5645_model_peek(uint16_t reg);
+
+/* CSI receiver stand-in, no frames are produced */
+struct cdsi_dev *ov5645_model_csi_rx_open(int id);
+void ov5645_model_csi_rx_close(struct cdsi_dev *dev);
+int ov5645_model_csi_rx_init(struct cdsi_dev *dev, const void *cfg);
+int ov5645_model_csi_rx_uninit(struct cdsi_dev *dev);
+int ov5645_model_csi_rx_start(struct cdsi_dev *dev);
+int ov5645_model_csi_rx_stop(struct cdsi_dev *dev);
+
+/**
+ * @brief Run every mode of the camera driver against the model
+ * @return 0 if all modes are within budget, -EINVAL otherwise
+ */
+int ov5645_model_bench(void);
+
+/* Route the driver's bus and CSI accesses to the model. */
+#define up_i2cinitialize(port)          ov5645_model_i2cinitialize(port)
+#define up_i2cuninitialize(dev)         ov5645_model_i2cuninitialize(dev)
+#define csi_rx_open(id)                 ov5645_model_csi_rx_open(id)
+#define csi_rx_close(dev)               ov5645_model_csi_rx_close(dev)
+#define csi_rx_init(dev, cfg)           ov5645_model_csi_rx_init(dev, cfg)
+#define csi_rx_uninit(dev)              ov5645_model_csi_rx_uninit(dev)
+#define csi_rx_start(dev)               ov5645_model_csi_rx_start(dev)
+#define csi_rx_stop(dev)                ov5645_model_csi_rx_stop(dev)
+
+#else
+
+static inline void ov5645_model_power(bool on)
+{
+}
+
+#endif /* CONFIG_ARA_OV5645_MODEL */
+
+#endif /* FDK_OV5645_MODEL_H */
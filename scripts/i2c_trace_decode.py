@@ -0,0 +1,147 @@
+#!/usr/bin/env python
+# Copyright (c) 2016 Google, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+# 1. Redistributions of source code must retain the above copyright notice,
+# this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright notice,
+# this list of conditions and the following disclaimer in the documentation
+# and/or other materials provided with the distribution.
+# 3. Neither the name of the copyright holder nor the names of its
+# contributors may be used to endorse or promote products derived from this
+# software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+# THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+# OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+# WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+# ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+# Decode the output of 'cat /dev/i2ctrace' into a timeline.
+#
+# Usage: i2c_trace_decode.py [--json] [dump.txt]
+#
+# Without --json, prints one line per transaction with times relative to the
+# first one, followed by a per-device summary. With --json, prints a Chrome
+# trace event file that can be loaded in chrome://tracing.
+
+import json
+import sys
+
+WRAP = 1 << 32
+
+
+def parse(lines):
+    transactions = []
+    devices = []
+    for line in lines:
+        fields = line.split()
+        if not fields:
+            continue
+        if fields[0] == 'T' and len(fields) == 7:
+            transactions.append({
+                'ts': int(fields[1]),
+                'dur': int(fields[2]),
+                'addr': int(fields[3], 16),
+                'reg': int(fields[4], 16),
+                'len': int(fields[5]),
+                'ret': int(fields[6]),
+            })
+        elif fields[0] == 'H' and len(fields) > 5:
+            devices.append({
+                'addr': int(fields[1], 16),
+                'count': int(fields[2]),
+                'bytes': int(fields[3]),
+                'busy': int(fields[4]),
+                'hist': [int(f) for f in fields[5:]],
+            })
+
+    # Unwrap the 32-bit microsecond timestamps.
+    offset = 0
+    for i in range(1, len(transactions)):
+        if transactions[i]['ts'] + offset < transactions[i - 1]['ts']:
+            offset += WRAP
+        transactions[i]['ts'] += offset
+
+    return transactions, devices
+
+
+def percentile(hist, fraction):
+    total = sum(hist)
+    if not total:
+        return 0
+    seen = 0
+    for bucket, count in enumerate(hist):
+        seen += count
+        if seen >= total * fraction:
+            return 1 << (bucket + 1)
+    return 1 << len(hist)
+
+
+def print_timeline(transactions, devices):
+    start = transactions[0]['ts'] if transactions else 0
+    end = start
+    print('%12s %10s %6s %8s %6s %5s' %
+          ('time (us)', 'dur (us)', 'addr', 'reg', 'bytes', 'ret'))
+    for t in transactions:
+        print('%12d %10d   0x%02x   0x%04x %6d %5d' %
+              (t['ts'] - start, t['dur'], t['addr'], t['reg'], t['len'],
+               t['ret']))
+        end = max(end, t['ts'] + t['dur'])
+
+    if transactions:
+        busy = sum(t['dur'] for t in transactions)
+        span = max(end - start, 1)
+        print('\n%d transactions over %d us, bus busy %d us (%.1f%%)' %
+              (len(transactions), span, busy, 100.0 * busy / span))
+
+    for d in devices:
+        print('\ndevice 0x%02x: %d transactions, %d bytes, %d us busy' %
+              (d['addr'], d['count'], d['bytes'], d['busy']))
+        print('  p50 < %d us, p99 < %d us' %
+              (percentile(d['hist'], 0.5), percentile(d['hist'], 0.99)))
+        for bucket, count in enumerate(d['hist']):
+            if count:
+                print('  [%6d, %6d) us: %d' %
+                      (1 << bucket if bucket else 0, 1 << (bucket + 1),
+                       count))
+
+
+def print_json(transactions):
+    events = []
+    for t in transactions:
+        events.append({
+            'name': 'reg 0x%04x' % t['reg'],
+            'cat': 'i2c',
+            'ph': 'X',
+            'ts': t['ts'],
+            'dur': t['dur'],
+            'pid': 0,
+            'tid': t['addr'],
+            'args': {'bytes': t['len'], 'ret': t['ret']},
+        })
+    json.dump({'traceEvents': events}, sys.stdout, indent=1)
+
+
+def main(argv):
+    as_json = '--json' in argv
+    args = [a for a in argv if a != '--json']
+    stream = open(args[0]) if args else sys.stdin
+    transactions, devices = parse(stream)
+
+    if as_json:
+        print_json(transactions)
+    else:
+        print_timeline(transactions, devices)
+
+
+if __name__ == '__main__':
+    main(sys.argv[1:])